@@ -0,0 +1,305 @@
+// AABBTree.cpp
+#include "AABBTree.h"
+#include <algorithm>
+#include <cassert>
+
+// Surface-area heuristic cost of a box (half the surface area)
+static float Area(const AABB& b)
+{
+    glm::vec3 d = b.max - b.min;
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+static AABB Union(const AABB& a, const AABB& b)
+{
+    return AABB(glm::min(a.min, b.min), glm::max(a.max, b.max));
+}
+
+static bool Contains(const AABB& outer, const AABB& inner)
+{
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+        inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+}
+
+AABBTree::AABBTree(float margin)
+    : root(Null),
+    freeList(Null),
+    proxyCount(0),
+    margin(margin)
+{}
+
+int AABBTree::AllocateNode()
+{
+    int id;
+    if (freeList != Null) {
+        id = freeList;
+        freeList = nodes[id].parent;
+    }
+    else {
+        id = (int)nodes.size();
+        nodes.push_back(Node());
+    }
+    Node& n = nodes[id];
+    n.userData = nullptr;
+    n.parent = Null;
+    n.child1 = Null;
+    n.child2 = Null;
+    n.height = 0;
+    return id;
+}
+
+void AABBTree::FreeNode(int nodeId)
+{
+    nodes[nodeId].parent = freeList;
+    nodes[nodeId].height = -1;
+    freeList = nodeId;
+}
+
+int AABBTree::CreateProxy(const AABB& box, void* userData)
+{
+    int id = AllocateNode();
+    glm::vec3 m(margin);
+    nodes[id].box = AABB(box.min - m, box.max + m);
+    nodes[id].userData = userData;
+    InsertLeaf(id);
+    ++proxyCount;
+    return id;
+}
+
+void AABBTree::DestroyProxy(int proxyId)
+{
+    assert(proxyId >= 0 && proxyId < (int)nodes.size() && nodes[proxyId].IsLeaf());
+    RemoveLeaf(proxyId);
+    FreeNode(proxyId);
+    --proxyCount;
+}
+
+bool AABBTree::MoveProxy(int proxyId, const AABB& box)
+{
+    Node& n = nodes[proxyId];
+    if (Contains(n.box, box)) {
+        return false;
+    }
+
+    RemoveLeaf(proxyId);
+    glm::vec3 m(margin);
+    nodes[proxyId].box = AABB(box.min - m, box.max + m);
+    InsertLeaf(proxyId);
+    return true;
+}
+
+void AABBTree::InsertLeaf(int leaf)
+{
+    if (root == Null) {
+        root = leaf;
+        nodes[root].parent = Null;
+        return;
+    }
+
+    // Descend towards the sibling that increases total area the least
+    const AABB leafBox = nodes[leaf].box;
+    int index = root;
+    while (!nodes[index].IsLeaf()) {
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+
+        float area = Area(nodes[index].box);
+        float combinedArea = Area(Union(nodes[index].box, leafBox));
+
+        // Cost of making a new parent for this node and the leaf
+        float cost = 2.0f * combinedArea;
+        // Minimum cost of pushing the leaf further down
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        float cost1 = Area(Union(leafBox, nodes[child1].box)) + inheritanceCost;
+        if (!nodes[child1].IsLeaf()) {
+            cost1 -= Area(nodes[child1].box);
+        }
+        float cost2 = Area(Union(leafBox, nodes[child2].box)) + inheritanceCost;
+        if (!nodes[child2].IsLeaf()) {
+            cost2 -= Area(nodes[child2].box);
+        }
+
+        if (cost < cost1 && cost < cost2) {
+            break;
+        }
+        index = (cost1 < cost2) ? child1 : child2;
+    }
+
+    // Replace the sibling with a new parent holding sibling + leaf
+    int sibling = index;
+    int oldParent = nodes[sibling].parent;
+    int newParent = AllocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].box = Union(leafBox, nodes[sibling].box);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent != Null) {
+        if (nodes[oldParent].child1 == sibling) nodes[oldParent].child1 = newParent;
+        else                                    nodes[oldParent].child2 = newParent;
+    }
+    else {
+        root = newParent;
+    }
+
+    Refit(nodes[leaf].parent);
+}
+
+void AABBTree::RemoveLeaf(int leaf)
+{
+    if (leaf == root) {
+        root = Null;
+        return;
+    }
+
+    int parent = nodes[leaf].parent;
+    int grandParent = nodes[parent].parent;
+    int sibling = (nodes[parent].child1 == leaf) ? nodes[parent].child2 : nodes[parent].child1;
+
+    if (grandParent != Null) {
+        // Splice the sibling into the parent's place
+        if (nodes[grandParent].child1 == parent) nodes[grandParent].child1 = sibling;
+        else                                     nodes[grandParent].child2 = sibling;
+        nodes[sibling].parent = grandParent;
+        FreeNode(parent);
+        Refit(grandParent);
+    }
+    else {
+        root = sibling;
+        nodes[sibling].parent = Null;
+        FreeNode(parent);
+    }
+}
+
+void AABBTree::Refit(int index)
+{
+    while (index != Null) {
+        index = Balance(index);
+        int child1 = nodes[index].child1;
+        int child2 = nodes[index].child2;
+        nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+        nodes[index].box = Union(nodes[child1].box, nodes[child2].box);
+        index = nodes[index].parent;
+    }
+}
+
+// Rotate the taller grandchild up if the subtree at iA is unbalanced.
+// Returns the index of the node now at iA's position
+int AABBTree::Balance(int iA)
+{
+    Node& A = nodes[iA];
+    if (A.IsLeaf() || A.height < 2) {
+        return iA;
+    }
+
+    int iB = A.child1;
+    int iC = A.child2;
+    Node& B = nodes[iB];
+    Node& C = nodes[iC];
+    int balance = C.height - B.height;
+
+    // Rotate C up
+    if (balance > 1) {
+        int iF = C.child1;
+        int iG = C.child2;
+        Node& F = nodes[iF];
+        Node& G = nodes[iG];
+
+        C.child1 = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+
+        if (C.parent != Null) {
+            if (nodes[C.parent].child1 == iA) nodes[C.parent].child1 = iC;
+            else                              nodes[C.parent].child2 = iC;
+        }
+        else {
+            root = iC;
+        }
+
+        if (F.height > G.height) {
+            C.child2 = iF;
+            A.child2 = iG;
+            G.parent = iA;
+            A.box = Union(B.box, G.box);
+            C.box = Union(A.box, F.box);
+            A.height = 1 + std::max(B.height, G.height);
+            C.height = 1 + std::max(A.height, F.height);
+        }
+        else {
+            C.child2 = iG;
+            A.child2 = iF;
+            F.parent = iA;
+            A.box = Union(B.box, F.box);
+            C.box = Union(A.box, G.box);
+            A.height = 1 + std::max(B.height, F.height);
+            C.height = 1 + std::max(A.height, G.height);
+        }
+        return iC;
+    }
+
+    // Rotate B up
+    if (balance < -1) {
+        int iD = B.child1;
+        int iE = B.child2;
+        Node& D = nodes[iD];
+        Node& E = nodes[iE];
+
+        B.child1 = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+
+        if (B.parent != Null) {
+            if (nodes[B.parent].child1 == iA) nodes[B.parent].child1 = iB;
+            else                              nodes[B.parent].child2 = iB;
+        }
+        else {
+            root = iB;
+        }
+
+        if (D.height > E.height) {
+            B.child2 = iD;
+            A.child1 = iE;
+            E.parent = iA;
+            A.box = Union(C.box, E.box);
+            B.box = Union(A.box, D.box);
+            A.height = 1 + std::max(C.height, E.height);
+            B.height = 1 + std::max(A.height, D.height);
+        }
+        else {
+            B.child2 = iE;
+            A.child1 = iD;
+            D.parent = iA;
+            A.box = Union(C.box, D.box);
+            B.box = Union(A.box, E.box);
+            A.height = 1 + std::max(C.height, D.height);
+            B.height = 1 + std::max(A.height, E.height);
+        }
+        return iB;
+    }
+
+    return iA;
+}
+
+bool AABBTree::RayHitsAABB(const glm::vec3& origin, const glm::vec3& invDir,
+    const AABB& box, float maxT, float& tEnter)
+{
+    float tmin = 0.0f;
+    float tmax = maxT;
+    for (int i = 0; i < 3; ++i) {
+        float t1 = (box.min[i] - origin[i]) * invDir[i];
+        float t2 = (box.max[i] - origin[i]) * invDir[i];
+        if (t1 > t2) std::swap(t1, t2);
+        tmin = std::max(tmin, t1);
+        tmax = std::min(tmax, t2);
+        if (tmin > tmax) {
+            return false;
+        }
+    }
+    tEnter = tmin;
+    return true;
+}
@@ -0,0 +1,162 @@
+// AABBTree.h
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include "Bounds.h"
+#include "Frustum.h"
+
+// Incrementally maintained bounding-volume hierarchy. Leaves store a "fat"
+// AABB (the real box grown by a margin) so small movements don't touch the
+// tree at all; larger ones remove and reinsert just that leaf. Internal
+// nodes are kept balanced with AVL-style rotations, so queries stay
+// logarithmic as objects are added, moved and removed.
+class AABBTree {
+public:
+    static const int Null = -1;
+
+    // How far leaf boxes are grown beyond the real bounds
+    explicit AABBTree(float margin = 0.1f);
+
+    // Insert a leaf for box; returns its proxy id
+    int CreateProxy(const AABB& box, void* userData);
+
+    // Remove a leaf
+    void DestroyProxy(int proxyId);
+
+    // Update a leaf after its object moved. Returns true if the leaf had to
+    // be reinserted (the new box escaped the fat box)
+    bool MoveProxy(int proxyId, const AABB& box);
+
+    void* GetUserData(int proxyId) const { return nodes[proxyId].userData; }
+    void  SetUserData(int proxyId, void* userData) { nodes[proxyId].userData = userData; }
+    const AABB& GetFatAABB(int proxyId) const { return nodes[proxyId].box; }
+
+    // Leaves whose fat box overlaps box. fn(void* userData) returns false to stop
+    template <typename Fn>
+    void Query(const AABB& box, Fn fn) const;
+
+    // Leaves whose fat box touches the frustum. fn(void* userData)
+    template <typename Fn>
+    void QueryFrustum(const Frustum& frustum, Fn fn) const;
+
+    // Leaves whose fat box is hit by origin + t*dir for t in [0, maxT].
+    // fn(void* userData, float maxT) returns the new maxT (return the hit
+    // distance to only keep closer hits, 0 to stop, maxT to continue)
+    template <typename Fn>
+    void RayCast(const glm::vec3& origin, const glm::vec3& dir, float maxT, Fn fn) const;
+
+    int GetHeight() const { return root == Null ? 0 : nodes[root].height; }
+    int GetProxyCount() const { return proxyCount; }
+
+    // Slab test; on hit tEnter is the entry distance (0 if origin inside)
+    static bool RayHitsAABB(const glm::vec3& origin, const glm::vec3& invDir,
+        const AABB& box, float maxT, float& tEnter);
+
+private:
+    struct Node {
+        AABB  box;
+        void* userData;
+        int   parent;     // next free node while on the free list
+        int   child1;
+        int   child2;
+        int   height;     // leaf = 0, free = -1
+
+        bool IsLeaf() const { return child1 == Null; }
+    };
+
+    int  AllocateNode();
+    void FreeNode(int nodeId);
+    void InsertLeaf(int leaf);
+    void RemoveLeaf(int leaf);
+    int  Balance(int nodeId);
+
+    // Walk from nodeId to the root, rebalancing and refitting
+    void Refit(int nodeId);
+
+    std::vector<Node> nodes;
+    int   root;
+    int   freeList;
+    int   proxyCount;
+    float margin;
+
+    // Scratch traversal stack reused by queries
+    mutable std::vector<int> stack;
+};
+
+template <typename Fn>
+void AABBTree::Query(const AABB& box, Fn fn) const
+{
+    if (root == Null) return;
+    stack.clear();
+    stack.push_back(root);
+    while (!stack.empty()) {
+        int id = stack.back();
+        stack.pop_back();
+        const Node& n = nodes[id];
+        if (n.box.max.x < box.min.x || n.box.min.x > box.max.x ||
+            n.box.max.y < box.min.y || n.box.min.y > box.max.y ||
+            n.box.max.z < box.min.z || n.box.min.z > box.max.z) {
+            continue;
+        }
+        if (n.IsLeaf()) {
+            if (!fn(n.userData)) return;
+        }
+        else {
+            stack.push_back(n.child1);
+            stack.push_back(n.child2);
+        }
+    }
+}
+
+template <typename Fn>
+void AABBTree::QueryFrustum(const Frustum& frustum, Fn fn) const
+{
+    if (root == Null) return;
+    stack.clear();
+    stack.push_back(root);
+    while (!stack.empty()) {
+        int id = stack.back();
+        stack.pop_back();
+        const Node& n = nodes[id];
+        if (!frustum.IntersectsAABB(n.box)) {
+            continue;
+        }
+        if (n.IsLeaf()) {
+            fn(n.userData);
+        }
+        else {
+            stack.push_back(n.child1);
+            stack.push_back(n.child2);
+        }
+    }
+}
+
+template <typename Fn>
+void AABBTree::RayCast(const glm::vec3& origin, const glm::vec3& dir, float maxT, Fn fn) const
+{
+    if (root == Null) return;
+    const float big = 1e30f;
+    glm::vec3 invDir(dir.x != 0.0f ? 1.0f / dir.x : big,
+        dir.y != 0.0f ? 1.0f / dir.y : big,
+        dir.z != 0.0f ? 1.0f / dir.z : big);
+
+    stack.clear();
+    stack.push_back(root);
+    while (!stack.empty()) {
+        int id = stack.back();
+        stack.pop_back();
+        const Node& n = nodes[id];
+        float tEnter;
+        if (!RayHitsAABB(origin, invDir, n.box, maxT, tEnter)) {
+            continue;
+        }
+        if (n.IsLeaf()) {
+            maxT = fn(n.userData, maxT);
+            if (maxT <= 0.0f) return;
+        }
+        else {
+            stack.push_back(n.child1);
+            stack.push_back(n.child2);
+        }
+    }
+}
@@ -0,0 +1,32 @@
+// Bench.h
+#pragma once
+#include <chrono>
+#include <cstddef>
+
+// Entry points of the individual benchmarks in 3DEngineBench
+int RunModelMatrixBench(int argc, char** argv);
+int RunTextureCacheBench(int argc, char** argv);
+int RunBlockCompressBench(int argc, char** argv);
+int RunMipGeneratorBench(int argc, char** argv);
+int RunSceneBench(int argc, char** argv);
+
+// Heap allocations the process has made so far and their total size, from
+// the counting operator new in BenchAlloc.cpp
+size_t BenchAllocationCount();
+size_t BenchAllocationBytes();
+
+// Wall-clock stopwatch in milliseconds
+class BenchTimer {
+public:
+    BenchTimer() : start(std::chrono::steady_clock::now()) {}
+
+    void Reset() { start = std::chrono::steady_clock::now(); }
+
+    double ElapsedMs() const {
+        return std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
@@ -0,0 +1,71 @@
+// BenchAlloc.cpp
+#include "Bench.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Every heap allocation in the process is counted, so the scene benchmark
+// can report what a frame allocates. All the other replaceable forms are
+// defined too and forward to these two, so nothing reaches the library's
+// own allocator whatever it does by default. They live in a file of their
+// own so the compiler can't inline them into the code using new and delete
+static std::atomic<size_t> allocationCount(0);
+static std::atomic<size_t> allocationBytes(0);
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return operator new(size);
+    }
+    catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return operator new(size, std::nothrow);
+}
+
+void operator delete[](void* p) noexcept {
+    operator delete(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    operator delete(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    operator delete(p);
+}
+
+size_t BenchAllocationCount() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+size_t BenchAllocationBytes() {
+    return allocationBytes.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,112 @@
+// BenchBlockCompress.cpp
+#include "Bench.h"
+#include "BlockCompressor.h"
+#include "TextureFile.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// The distinct textures Engine::Init loads
+static const char* kTextures[] = {
+    "brick.png", "wood.png", "avocado.png", "burgers.png", "sky.png", "planet.png",
+    "holo.png", "hoth.png", "moon.png", "deathstar.png"
+};
+
+// Summed squared error over the channels the format keeps (BC1 drops alpha)
+static double SquaredError(const unsigned char* pixels, int channels, const unsigned char* rgba,
+    size_t count, bool withAlpha) {
+    double sum = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        const unsigned char* p = pixels + i * channels;
+        const unsigned char* q = rgba + i * 4;
+        for (int c = 0; c < 3; ++c) {
+            double d = (double)p[c] - q[c];
+            sum += d * d;
+        }
+        if (withAlpha) {
+            double d = (double)(channels == 4 ? p[3] : 255) - q[3];
+            sum += d * d;
+        }
+    }
+    return sum;
+}
+
+int RunBlockCompressBench(int argc, char** argv) {
+    std::string dir;
+    unsigned threads = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+            if (!dir.empty() && dir.back() != '/' && dir.back() != '\\') dir += '/';
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = (unsigned)std::max(1, std::atoi(argv[++i]));
+        }
+    }
+
+    // Base levels of every texture, decoded once up front
+    std::vector<TextureImage> images;
+    TextureFile::Options raw;
+    for (const char* name : kTextures) {
+        TextureImage image;
+        if (!TextureFile::Load(dir + name, false, raw, image) || image.channels < 3) {
+            std::fprintf(stderr, "Can't load %s%s (run from the asset folder or pass --dir)\n", dir.c_str(), name);
+            return 1;
+        }
+        images.push_back(std::move(image));
+    }
+
+    ThreadPool pool(threads);
+    std::printf("Block compression of %zu textures (level 0), %u worker threads\n",
+        images.size(), pool.GetThreadCount());
+    std::printf("%-6s %-7s %10s %10s %9s %9s %8s %7s\n",
+        "format", "quality", "1T ms", "MT ms", "MT MPix/s", "PSNR dB", "ratio", "MB");
+
+    const BlockCompressor::Format formats[] = {
+        BlockCompressor::Format::BC1, BlockCompressor::Format::BC3, BlockCompressor::Format::BC7
+    };
+    const BlockCompressor::Quality qualities[] = {
+        BlockCompressor::Quality::Fast, BlockCompressor::Quality::Normal, BlockCompressor::Quality::High
+    };
+    for (BlockCompressor::Format format : formats) {
+        bool withAlpha = format != BlockCompressor::Format::BC1;
+        for (BlockCompressor::Quality quality : qualities) {
+            double singleMs = 0.0, multiMs = 0.0, squaredError = 0.0;
+            size_t rawBytes = 0, packedBytes = 0, pixelCount = 0, samples = 0;
+            for (const TextureImage& image : images) {
+                const unsigned char* pixels = image.levels[0];
+                int w = image.width, h = image.height;
+                std::vector<unsigned char> blocks(BlockCompressor::LevelSize(format, w, h));
+
+                BenchTimer timer;
+                BlockCompressor::Compress(format, quality, pixels, w, h, image.channels, blocks.data());
+                singleMs += timer.ElapsedMs();
+
+                timer.Reset();
+                BlockCompressor::Compress(format, quality, pixels, w, h, image.channels, blocks.data(), &pool);
+                multiMs += timer.ElapsedMs();
+
+                std::vector<unsigned char> decoded((size_t)w * h * 4);
+                BlockCompressor::Decompress(format, blocks.data(), w, h, decoded.data());
+                squaredError += SquaredError(pixels, image.channels, decoded.data(), (size_t)w * h, withAlpha);
+                samples += (size_t)w * h * (withAlpha ? 4 : 3);
+
+                pixelCount += (size_t)w * h;
+                rawBytes += (size_t)w * h * image.channels;
+                packedBytes += blocks.size();
+            }
+            double mse = squaredError / (double)samples;
+            double psnr = mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : 99.0;
+            std::printf("%-6s %-7s %10.1f %10.1f %9.1f %9.2f %7.1f:1 %7.2f\n",
+                BlockCompressor::FormatName(format), BlockCompressor::QualityName(quality),
+                singleMs, multiMs, pixelCount / (multiMs * 1000.0), psnr,
+                (double)rawBytes / packedBytes, packedBytes / (1024.0 * 1024.0));
+        }
+    }
+    return 0;
+}
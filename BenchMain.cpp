@@ -0,0 +1,41 @@
+// BenchMain.cpp
+#include "Bench.h"
+#include <cstring>
+#include <iostream>
+
+struct BenchEntry {
+    const char* name;
+    const char* description;
+    int (*run)(int argc, char** argv);
+};
+
+static const BenchEntry benches[] = {
+    { "matrices", "Batch model-matrix builder vs. glm translate/rotate/scale chain", RunModelMatrixBench },
+    { "textures", "Cold PNG decode vs. warm memory-mapped texture cache load", RunTextureCacheBench },
+    { "mips", "CPU mip chain (box / Kaiser, gamma-correct) vs. the scalar box filter", RunMipGeneratorBench },
+    { "bc", "BC1 / BC3 / BC7 block compression speed and quality per setting", RunBlockCompressBench },
+    { "scene", "Seeded stress scene rendered headless; frame time percentiles as JSON", RunSceneBench },
+};
+
+static void PrintUsage(const char* exe) {
+    std::cout << "Usage: " << exe << " <benchmark> [options]\n\nBenchmarks:\n";
+    for (const BenchEntry& b : benches) {
+        std::cout << "  " << b.name << "\t" << b.description << "\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    for (const BenchEntry& b : benches) {
+        if (std::strcmp(argv[1], b.name) == 0) {
+            // Hand the benchmark its own options (argv[1] becomes its argv[0])
+            return b.run(argc - 1, argv + 1);
+        }
+    }
+    std::cerr << "Unknown benchmark \"" << argv[1] << "\"\n";
+    PrintUsage(argv[0]);
+    return 1;
+}
@@ -0,0 +1,189 @@
+// BenchMipGenerator.cpp
+#include "Bench.h"
+#include "MipGenerator.h"
+#include "TextureFile.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// The scalar 2x2 box filter MipGenerator started out with
+static void ReferenceChain(int w, int h, int channels, std::vector<std::vector<unsigned char>>& levels) {
+    levels.resize(1);
+    while (w > 1 || h > 1) {
+        int nw = std::max(1, w / 2), nh = std::max(1, h / 2);
+        const unsigned char* src = levels.back().data();
+        std::vector<unsigned char> next((size_t)nw * nh * channels);
+        for (int y = 0; y < nh; ++y) {
+            const unsigned char* row0 = src + (size_t)std::min(2 * y, h - 1) * w * channels;
+            const unsigned char* row1 = src + (size_t)std::min(2 * y + 1, h - 1) * w * channels;
+            for (int x = 0; x < nw; ++x) {
+                int x0 = std::min(2 * x, w - 1) * channels;
+                int x1 = std::min(2 * x + 1, w - 1) * channels;
+                for (int c = 0; c < channels; ++c) {
+                    int sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+                    next[((size_t)y * nw + x) * channels + c] = (unsigned char)((sum + 2) >> 2);
+                }
+            }
+        }
+        levels.push_back(std::move(next));
+        w = nw;
+        h = nh;
+    }
+}
+
+// Small and odd sizes (rows narrower than the kernel, non-square chains),
+// every filter: a flat image must stay flat, the threaded chain must match
+// the single-threaded one and the plain box filter the scalar reference
+static bool ValidateOddSizes(ThreadPool& pool) {
+    const int sizes[][2] = { { 1, 1 }, { 2, 2 }, { 3, 3 }, { 1, 7 }, { 7, 1 }, { 2, 8 }, { 8, 2 },
+        { 3, 5 }, { 5, 3 }, { 33, 17 }, { 17, 33 }, { 31, 9 } };
+    const MipGenerator::Filter filters[] = { MipGenerator::Filter::Box, MipGenerator::Filter::Kaiser };
+    const unsigned char flat = 150;
+    for (const auto& size : sizes) {
+        const int w = size[0], h = size[1];
+        for (int ch : { 1, 3, 4 }) {
+            std::vector<std::vector<unsigned char>> reference(1);
+            reference[0].assign((size_t)w * h * ch, flat);
+            ReferenceChain(w, h, ch, reference);
+            for (MipGenerator::Filter filter : filters) {
+                for (int gamma = 0; gamma < 2; ++gamma) {
+                    MipGenerator::Settings settings;
+                    settings.filter = filter;
+                    settings.gammaCorrect = gamma != 0;
+                    std::vector<std::vector<unsigned char>> single(1), multi;
+                    single[0].assign((size_t)w * h * ch, flat);
+                    multi = single;
+                    MipGenerator::BuildChain(w, h, ch, single, settings);
+                    settings.pool = &pool;
+                    MipGenerator::BuildChain(w, h, ch, multi, settings);
+
+                    const char* problem = nullptr;
+                    if ((int)single.size() != MipGenerator::LevelCount(w, h)) {
+                        problem = "wrong level count";
+                    }
+                    else if (single != multi) {
+                        problem = "threaded chain differs";
+                    }
+                    else if (filter == MipGenerator::Filter::Box && !gamma && single != reference) {
+                        problem = "box filter differs from the scalar reference";
+                    }
+                    for (size_t l = 0; !problem && l < single.size(); ++l) {
+                        for (unsigned char v : single[l]) {
+                            if (std::abs(v - flat) > 1) {
+                                problem = "flat image didn't stay flat";
+                                break;
+                            }
+                        }
+                    }
+                    if (problem) {
+                        std::fprintf(stderr, "Mip chain %dx%d, %d channels, %s%s: %s\n", w, h, ch,
+                            filter == MipGenerator::Filter::Box ? "box" : "kaiser",
+                            gamma ? ", gamma" : "", problem);
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Best-of-N milliseconds for one full chain
+template <typename Fn>
+static double BestMs(int repeats, Fn fn) {
+    double best = 1e300;
+    for (int r = 0; r < repeats; ++r) {
+        BenchTimer timer;
+        fn();
+        best = std::min(best, timer.ElapsedMs());
+    }
+    return best;
+}
+
+int RunMipGeneratorBench(int argc, char** argv) {
+    std::string path = "brick.png";
+    unsigned threads = 0;
+    int repeats = 5;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--image") == 0 && i + 1 < argc) {
+            path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = (unsigned)std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--repeats") == 0 && i + 1 < argc) {
+            repeats = std::max(1, std::atoi(argv[++i]));
+        }
+    }
+
+    TextureImage image;
+    TextureFile::Options raw;
+    if (!TextureFile::Load(path, false, raw, image) || image.channels < 3) {
+        std::fprintf(stderr, "Can't load %s as an RGB(A) image (pass --image)\n", path.c_str());
+        return 1;
+    }
+    const int w = image.width, h = image.height;
+    const size_t texels = (size_t)w * h;
+
+    // Gray, RGB and RGBA versions of the same picture
+    std::vector<unsigned char> bases[3];
+    const int channelCounts[3] = { 1, 3, 4 };
+    for (int b = 0; b < 3; ++b) {
+        int ch = channelCounts[b];
+        bases[b].resize(texels * ch);
+        for (size_t i = 0; i < texels; ++i) {
+            const unsigned char* p = image.levels[0] + i * image.channels;
+            unsigned char* q = &bases[b][i * ch];
+            if (ch == 1) {
+                q[0] = (unsigned char)((p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8);
+                continue;
+            }
+            q[0] = p[0];
+            q[1] = p[1];
+            q[2] = p[2];
+            if (ch == 4) q[3] = image.channels == 4 ? p[3] : (unsigned char)(i * 255 / texels);
+        }
+    }
+
+    ThreadPool pool(threads);
+    if (!ValidateOddSizes(pool)) {
+        return 1;
+    }
+    std::printf("Mip chain of %s (%dx%d, %d levels), %u worker threads\n",
+        path.c_str(), w, h, MipGenerator::LevelCount(w, h), pool.GetThreadCount());
+    std::printf("%-3s %-7s %-6s %10s %10s %10s %9s\n", "ch", "filter", "gamma", "ref ms", "1T ms", "MT ms", "speedup");
+
+    const MipGenerator::Filter filters[] = { MipGenerator::Filter::Box, MipGenerator::Filter::Kaiser };
+    for (int b = 0; b < 3; ++b) {
+        int ch = channelCounts[b];
+        std::vector<std::vector<unsigned char>> reference(1), levels(1);
+        reference[0] = bases[b];
+        double refMs = BestMs(repeats, [&]() { ReferenceChain(w, h, ch, reference); });
+
+        for (MipGenerator::Filter filter : filters) {
+            for (int gamma = 0; gamma < 2; ++gamma) {
+                MipGenerator::Settings settings;
+                settings.filter = filter;
+                settings.gammaCorrect = gamma != 0;
+                levels[0] = bases[b];
+                double singleMs = BestMs(repeats, [&]() { MipGenerator::BuildChain(w, h, ch, levels, settings); });
+                settings.pool = &pool;
+                double multiMs = BestMs(repeats, [&]() { MipGenerator::BuildChain(w, h, ch, levels, settings); });
+
+                // The plain box filter must match the scalar version bit for bit
+                if (filter == MipGenerator::Filter::Box && !gamma && levels != reference) {
+                    std::fprintf(stderr, "Box filter output differs from the scalar reference (%d channels)\n", ch);
+                    return 1;
+                }
+                std::printf("%-3d %-7s %-6s %10.2f %10.2f %10.2f %8.1fx\n", ch,
+                    filter == MipGenerator::Filter::Box ? "box" : "kaiser", gamma ? "yes" : "no",
+                    refMs, singleMs, multiMs, refMs / multiMs);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+// BenchModelMatrix.cpp
+#include "Bench.h"
+#include "ModelMatrixBatch.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// The per-object path Object3D::GetModelMatrix used before the batch builder
+static glm::mat4 GlmModelMatrix(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale) {
+    glm::mat4 T = glm::translate(glm::mat4(1.0f), position);
+    glm::mat4 Rx = glm::rotate(glm::mat4(1.0f), rotation.x, glm::vec3(1, 0, 0));
+    glm::mat4 Ry = glm::rotate(glm::mat4(1.0f), rotation.y, glm::vec3(0, 1, 0));
+    glm::mat4 Rz = glm::rotate(glm::mat4(1.0f), rotation.z, glm::vec3(0, 0, 1));
+    glm::mat4 S = glm::scale(glm::mat4(1.0f), scale);
+    return T * Rz * Ry * Rx * S;
+}
+
+static float MaxAbsError(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b) {
+    float err = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i) {
+        for (int c = 0; c < 4; ++c) {
+            for (int r = 0; r < 4; ++r) {
+                err = std::max(err, std::fabs(a[i][c][r] - b[i][c][r]));
+            }
+        }
+    }
+    return err;
+}
+
+// Best-of-N time per object in nanoseconds; fn builds all `count` matrices once
+template <typename Fn>
+static double TimePerObjectNs(size_t count, Fn fn) {
+    const int trials = 5;
+    const size_t reps = std::max<size_t>(3, 10000000 / count);
+    double best = 1e300;
+    for (int t = 0; t < trials; ++t) {
+        BenchTimer timer;
+        for (size_t r = 0; r < reps; ++r) {
+            fn();
+        }
+        best = std::min(best, timer.ElapsedMs() * 1e6 / (double)(reps * count));
+    }
+    return best;
+}
+
+int RunModelMatrixBench(int argc, char** argv) {
+    std::vector<size_t> counts = { 1000, 100000, 1000000 };
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--counts") == 0 && i + 1 < argc) {
+            counts.clear();
+            std::string list = argv[++i];
+            size_t pos = 0;
+            while (pos < list.size()) {
+                size_t comma = list.find(',', pos);
+                if (comma == std::string::npos) comma = list.size();
+                counts.push_back((size_t)std::strtoull(list.substr(pos, comma - pos).c_str(), nullptr, 10));
+                pos = comma + 1;
+            }
+        }
+    }
+
+    using ModelMatrixBatch::Kernel;
+    const Kernel best = ModelMatrixBatch::DetectKernel();
+    std::vector<Kernel> kernels = { Kernel::Scalar };
+    if (best == Kernel::SSE || best == Kernel::AVX2) kernels.push_back(Kernel::SSE);
+    if (best == Kernel::AVX2) kernels.push_back(Kernel::AVX2);
+
+    std::printf("Model matrix build (T*Rz*Ry*Rx*S), best kernel: %s\n",
+        ModelMatrixBatch::KernelName(best));
+    std::printf("%10s  %-8s %12s %10s %12s\n", "objects", "path", "ns/object", "speedup", "max |err|");
+
+    volatile float sink = 0.0f;
+    for (size_t count : counts) {
+        if (count == 0) continue;
+
+        // Same seeded scene for every run so results compare across commits
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> posDist(-100.0f, 100.0f);
+        std::uniform_real_distribution<float> rotDist(-6.2831853f, 6.2831853f);
+        std::uniform_real_distribution<float> sclDist(0.25f, 4.0f);
+        std::vector<glm::vec3> positions(count), rotations(count), scales(count);
+        for (size_t i = 0; i < count; ++i) {
+            positions[i] = glm::vec3(posDist(rng), posDist(rng), posDist(rng));
+            rotations[i] = glm::vec3(rotDist(rng), rotDist(rng), rotDist(rng));
+            scales[i] = glm::vec3(sclDist(rng), sclDist(rng), sclDist(rng));
+        }
+
+        std::vector<glm::mat4> reference(count), out(count);
+        double glmNs = TimePerObjectNs(count, [&]() {
+            for (size_t i = 0; i < count; ++i) {
+                reference[i] = GlmModelMatrix(positions[i], rotations[i], scales[i]);
+            }
+        });
+        sink = sink + reference[count / 2][3][0];
+        std::printf("%10zu  %-8s %12.2f %9.2fx %12s\n", count, "glm", glmNs, 1.0, "-");
+
+        for (Kernel kernel : kernels) {
+            double ns = TimePerObjectNs(count, [&]() {
+                ModelMatrixBatch::Build(kernel, positions.data(), rotations.data(),
+                    scales.data(), out.data(), count);
+            });
+            sink = sink + out[count / 2][3][0];
+            std::printf("%10zu  %-8s %12.2f %9.2fx %12.2e\n", count,
+                ModelMatrixBatch::KernelName(kernel), ns, glmNs / ns, MaxAbsError(reference, out));
+        }
+    }
+    return 0;
+}
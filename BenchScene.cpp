@@ -0,0 +1,318 @@
+// BenchScene.cpp
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+#include "Bench.h"
+#include "Engine.h"
+#include "Cube.h"
+#include "Pyramid.h"
+#include "Sphere.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// splitmix64: the same sequence from a seed on every compiler and standard
+// library, which the <random> distributions don't promise
+class SceneRandom {
+public:
+    explicit SceneRandom(uint64_t seed) : state(seed) {}
+
+    uint64_t Next() {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    // [0, 1) with 24 bits, exact in a float
+    float Uniform() { return (float)(Next() >> 40) * (1.0f / 16777216.0f); }
+    float Range(float lo, float hi) { return lo + (hi - lo) * Uniform(); }
+
+private:
+    uint64_t state;
+};
+
+enum class Motion { Static, Spin, Wave };
+
+static const char* MotionName(Motion m) {
+    switch (m) {
+    case Motion::Spin: return "spin";
+    case Motion::Wave: return "wave";
+    default:           return "static";
+    }
+}
+
+// Generated object and what its motion starts from
+struct SceneObject {
+    Object3D* object;
+    glm::vec3 position;
+    glm::vec3 rotation;
+    glm::vec3 spin;         // radians per frame
+    bool moving;
+};
+
+// Nearest-rank percentile of sorted values
+static double Percentile(const std::vector<double>& sorted, double p) {
+    size_t rank = (size_t)std::ceil(p / 100.0 * sorted.size());
+    return sorted[std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0)];
+}
+
+static uint64_t FloatBits(float f) {
+    uint32_t bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+// s as a quoted JSON string, control characters escaped
+static std::string JsonString(const char* s) {
+    std::string out = "\"";
+    for (; s && *s; ++s) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += (char)c;
+        }
+        else if (c == '\n') out += "\\n";
+        else if (c == '\r') out += "\\r";
+        else if (c == '\t') out += "\\t";
+        else if (c < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            out += code;
+        }
+        else out += (char)c;
+    }
+    return out + "\"";
+}
+
+int RunSceneBench(int argc, char** argv) {
+    int count = 1000;
+    float texturedRatio = 0.5f;
+    float movingRatio = 1.0f;
+    Motion motion = Motion::Static;
+    int frames = 300;
+    int warmup = 30;
+    uint64_t seed = 1;
+    std::string renderer = "instanced";
+    int width = 1280, height = 720;
+    const char* outPath = nullptr;
+    const char* label = "";
+    for (int i = 1; i < argc; ++i) {
+        const char* next = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (std::strcmp(argv[i], "--objects") == 0 && next) {
+            count = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--textured") == 0 && next) {
+            texturedRatio = std::min(1.0f, std::max(0.0f, (float)std::atof(argv[++i])));
+        }
+        else if (std::strcmp(argv[i], "--moving") == 0 && next) {
+            movingRatio = std::min(1.0f, std::max(0.0f, (float)std::atof(argv[++i])));
+        }
+        else if (std::strcmp(argv[i], "--motion") == 0 && next) {
+            ++i;
+            if (std::strcmp(argv[i], "spin") == 0) motion = Motion::Spin;
+            else if (std::strcmp(argv[i], "wave") == 0) motion = Motion::Wave;
+            else if (std::strcmp(argv[i], "static") == 0) motion = Motion::Static;
+            else {
+                std::fprintf(stderr, "Unknown motion \"%s\" (static, spin, wave)\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--frames") == 0 && next) {
+            frames = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--warmup") == 0 && next) {
+            warmup = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--seed") == 0 && next) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--renderer") == 0 && next) {
+            renderer = argv[++i];
+            if (renderer != "instanced" && renderer != "fixed" && renderer != "software") {
+                std::fprintf(stderr, "Unknown renderer \"%s\" (instanced, fixed, software)\n", renderer.c_str());
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--size") == 0 && next) {
+            if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                std::fprintf(stderr, "Bad --size %s, expected e.g. 1280x720\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--out") == 0 && next) {
+            outPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--label") == 0 && next) {
+            label = argv[++i];
+        }
+    }
+
+    // Objects at constant density in a cube; the orbit passes just outside
+    // it, so part of the scene is always behind the camera or off screen
+    const float side = 1.6f * std::cbrt((float)count);
+    const float orbitDistance = 0.75f * side + 2.0f;
+
+    Engine engine(argc, argv);
+    engine.SetClearColor(0.1f, 0.1f, 0.15f);
+    engine.SetResolution(width, height);
+    engine.SetPerspective(45.0f, 0.1f, orbitDistance + side);
+    engine.SetHeadless(frames);
+    engine.SetInstancedRendering(renderer == "instanced");
+    engine.SetSoftwareRendering(renderer == "software");
+    engine.Init();
+    engine.LoadAllTextures();
+    engine.ClearObjects();
+
+    BenchTimer setupTimer;
+    SceneRandom rng(seed);
+    std::vector<SceneObject> scene;
+    scene.reserve(count);
+    uint64_t sceneHash = 14695981039346656037ull;   // FNV-1a over the generated scene
+    for (int i = 0; i < count; ++i) {
+        SceneObject s;
+        uint64_t type = rng.Next() % 3;
+        switch (type) {
+        case 0:  s.object = new Cube(); break;
+        case 1:  s.object = new Pyramid(); break;
+        default: s.object = new Sphere(); break;
+        }
+        // One draw per statement: argument evaluation order differs between
+        // compilers, and the scene must not
+        s.position.x = rng.Range(-0.5f, 0.5f) * side;
+        s.position.y = rng.Range(-0.5f, 0.5f) * side;
+        s.position.z = rng.Range(-0.5f, 0.5f) * side;
+        s.rotation.x = rng.Range(0.0f, 6.2831853f);
+        s.rotation.y = rng.Range(0.0f, 6.2831853f);
+        s.rotation.z = 0.0f;
+        s.spin.x = rng.Range(-0.05f, 0.05f);
+        s.spin.y = rng.Range(-0.05f, 0.05f);
+        s.spin.z = 0.0f;
+        float scale = rng.Range(0.6f, 1.2f);
+        bool textured = rng.Uniform() < texturedRatio;
+        int texIndex = (int)(rng.Next() % 1024);
+        s.moving = rng.Uniform() < movingRatio;
+
+        s.object->SetPosition(s.position);
+        s.object->SetRotation(s.rotation);
+        s.object->SetScale(glm::vec3(scale));
+        s.object->SetTextured(textured);
+        s.object->SetTexIndex(texIndex);
+        engine.AddObject(s.object);
+        scene.push_back(s);
+
+        // Every generated value, floats by their bits
+        const uint64_t fields[] = { type, (uint64_t)textured, (uint64_t)texIndex, (uint64_t)s.moving,
+            FloatBits(s.position.x), FloatBits(s.position.y), FloatBits(s.position.z),
+            FloatBits(s.rotation.x), FloatBits(s.rotation.y), FloatBits(s.rotation.z),
+            FloatBits(s.spin.x), FloatBits(s.spin.y), FloatBits(s.spin.z), FloatBits(scale) };
+        for (uint64_t f : fields) {
+            sceneHash = (sceneHash ^ f) * 1099511628211ull;
+        }
+    }
+    const double setupMs = setupTimer.ElapsedMs();
+
+    // Scripted orbit: one turn over warm-up and measured frames together,
+    // bobbing up and down twice
+    const int totalFrames = warmup + frames;
+    std::vector<double> frameMs;
+    frameMs.reserve(frames);
+    double drawCalls = 0.0, stateChanges = 0.0, visible = 0.0;
+    size_t allocations = 0, allocatedBytes = 0;
+    for (int f = 0; f < totalFrames; ++f) {
+        const float t = (float)f / (float)totalFrames;
+        engine.SetCamera(6.2831853f * t, 0.35f + 0.2f * std::sin(12.566371f * t), orbitDistance, glm::vec3(0.0f));
+
+        if (motion != Motion::Static) {
+            for (const SceneObject& s : scene) {
+                if (!s.moving) {
+                    continue;
+                }
+                if (motion == Motion::Spin) {
+                    s.object->SetRotation(s.rotation + s.spin * (float)f);
+                }
+                else {
+                    glm::vec3 p = s.position;
+                    p.y += 0.5f * std::sin(0.1f * f + 0.3f * p.x + 0.2f * p.z);
+                    s.object->SetPosition(p);
+                }
+            }
+        }
+
+        const size_t allocsBefore = BenchAllocationCount();
+        const size_t bytesBefore = BenchAllocationBytes();
+        BenchTimer timer;
+        engine.RenderFrame();
+        glFinish();
+        const double ms = timer.ElapsedMs();
+        if (f < warmup) {
+            continue;
+        }
+
+        frameMs.push_back(ms);
+        allocations += BenchAllocationCount() - allocsBefore;
+        allocatedBytes += BenchAllocationBytes() - bytesBefore;
+        Engine::FrameStats stats = engine.GetFrameStats();
+        drawCalls += stats.drawCalls;
+        stateChanges += stats.stateChanges;
+        visible += (double)stats.visibleObjects;
+    }
+
+    std::vector<double> sorted = frameMs;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (double ms : frameMs) total += ms;
+
+    const std::string glRenderer = JsonString((const char*)glGetString(GL_RENDERER));
+    engine.Cleanup();
+
+    FILE* out = stdout;
+    if (outPath) {
+        out = std::fopen(outPath, "w");
+        if (!out) {
+            std::fprintf(stderr, "Cannot write %s\n", outPath);
+            return 1;
+        }
+    }
+    std::fprintf(out,
+        "{\n"
+        "  \"benchmark\": \"scene\",\n"
+        "  \"label\": %s,\n"
+        "  \"gl_renderer\": %s,\n"
+        "  \"renderer\": %s,\n"
+        "  \"seed\": %llu,\n"
+        "  \"objects\": %d,\n"
+        "  \"textured_ratio\": %.3f,\n"
+        "  \"motion\": \"%s\",\n"
+        "  \"moving_ratio\": %.3f,\n"
+        "  \"width\": %d,\n"
+        "  \"height\": %d,\n"
+        "  \"warmup_frames\": %d,\n"
+        "  \"frames\": %d,\n"
+        "  \"scene_hash\": \"%016llx\",\n"
+        "  \"setup_ms\": %.3f,\n"
+        "  \"frame_ms\": { \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"min\": %.4f, \"max\": %.4f },\n"
+        "  \"fps\": %.2f,\n"
+        "  \"draw_calls_per_frame\": %.2f,\n"
+        "  \"state_changes_per_frame\": %.2f,\n"
+        "  \"visible_objects_per_frame\": %.2f,\n"
+        "  \"allocations_per_frame\": %.2f,\n"
+        "  \"allocated_bytes_per_frame\": %.1f\n"
+        "}\n",
+        JsonString(label).c_str(), glRenderer.c_str(),
+        JsonString(renderer.c_str()).c_str(), (unsigned long long)seed, count, texturedRatio,
+        MotionName(motion), movingRatio, width, height, warmup, frames,
+        (unsigned long long)sceneHash, setupMs,
+        total / frames, Percentile(sorted, 50.0), Percentile(sorted, 95.0), Percentile(sorted, 99.0),
+        sorted.front(), sorted.back(), frames * 1000.0 / total,
+        drawCalls / frames, stateChanges / frames, visible / frames,
+        (double)allocations / frames, (double)allocatedBytes / frames);
+    if (out != stdout) {
+        std::fclose(out);
+    }
+    return 0;
+}
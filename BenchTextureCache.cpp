@@ -0,0 +1,97 @@
+// BenchTextureCache.cpp
+#include "Bench.h"
+#include "TextureFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// The textures Engine::Init loads, in the same order
+static const char* kTextures[] = {
+    "brick.png", "wood.png", "avocado.png", "burgers.png", "sky.png", "planet.png",
+    "holo.png", "hoth.png", "moon.png", "holo.png", "deathstar.png"
+};
+
+// Read one byte per page of every level, like an upload would, so the warm
+// timing includes faulting the mapped file in
+static unsigned TouchLevels(const TextureImage& image) {
+    unsigned sum = 0;
+    int w = image.width, h = image.height;
+    for (const unsigned char* level : image.levels) {
+        size_t bytes = (size_t)TextureFile::LevelBytes(image.format, w, h, image.channels);
+        for (size_t i = 0; i < bytes; i += 4096) {
+            sum += level[i];
+        }
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+    }
+    return sum;
+}
+
+int RunTextureCacheBench(int argc, char** argv) {
+    std::string dir;
+    int repeats = 5;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+            if (!dir.empty() && dir.back() != '/' && dir.back() != '\\') dir += '/';
+        }
+        else if (std::strcmp(argv[i], "--repeats") == 0 && i + 1 < argc) {
+            repeats = std::max(1, std::atoi(argv[++i]));
+        }
+    }
+
+    std::printf("Texture load: cold (PNG decode + mip chain + cache write) vs. warm (mapped cache)\n");
+    std::printf("%-16s %10s %12s %12s %10s %9s\n", "texture", "size", "decode ms", "cold ms", "warm ms", "speedup");
+
+    TextureFile::Options raw;     // uncompressed levels, as before
+    volatile unsigned sink = 0;
+    double totalDecode = 0.0, totalCold = 0.0, totalWarm = 0.0;
+    for (const char* name : kTextures) {
+        std::string path = dir + name;
+        std::string cachePath = TextureFile::CachePath(path);
+
+        // Decode only, what Texture2D did before (the GPU built the mips)
+        double decodeMs = 1e300;
+        double coldMs = 1e300;
+        double warmMs = 1e300;
+        TextureImage image;
+        for (int r = 0; r < repeats; ++r) {
+            BenchTimer timer;
+            if (!TextureFile::Load(path, false, raw, image)) {
+                std::fprintf(stderr, "Can't load %s (run from the asset folder or pass --dir)\n", path.c_str());
+                return 1;
+            }
+            decodeMs = std::min(decodeMs, timer.ElapsedMs());
+            sink = sink + image.levels[0][0];
+
+            // Cold: no cache file yet, so it is decoded, mipped and written
+            std::remove(cachePath.c_str());
+            timer.Reset();
+            TextureFile::Load(path, true, raw, image);
+            coldMs = std::min(coldMs, timer.ElapsedMs());
+            sink = sink + TouchLevels(image);
+
+            timer.Reset();
+            TextureFile::Load(path, true, raw, image);
+            sink = sink + TouchLevels(image);
+            warmMs = std::min(warmMs, timer.ElapsedMs());
+            if (!image.fromCache) {
+                std::fprintf(stderr, "Cache file for %s was not used\n", path.c_str());
+                return 1;
+            }
+        }
+
+        char size[32];
+        std::snprintf(size, sizeof(size), "%dx%dx%d", image.width, image.height, image.channels);
+        std::printf("%-16s %10s %12.2f %12.2f %10.2f %8.1fx\n", name, size, decodeMs, coldMs, warmMs, coldMs / warmMs);
+        totalDecode += decodeMs;
+        totalCold += coldMs;
+        totalWarm += warmMs;
+    }
+    std::printf("%-16s %10s %12.2f %12.2f %10.2f %8.1fx\n", "total", "", totalDecode, totalCold, totalWarm,
+        totalCold / totalWarm);
+    return 0;
+}
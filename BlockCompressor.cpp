@@ -0,0 +1,654 @@
+// BlockCompressor.cpp
+#include "BlockCompressor.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define BC_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace BlockCompressor {
+
+// One 4x4 block as r, g, b, a planes of 16 texels
+struct Block {
+    float c[4][16];
+};
+
+static const float kRGBWeights[4] = { 1.0f, 1.0f, 1.0f, 0.0f };
+static const float kRGBAWeights[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+// BC7 4-bit index interpolation weights (out of 64)
+static const int kBC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+Format Resolve(Format requested, int channels)
+{
+    if (channels < 3) return Format::None;
+    if (requested == Format::Auto) return channels == 4 ? Format::BC3 : Format::BC1;
+    return requested;
+}
+
+const char* FormatName(Format format)
+{
+    switch (format) {
+    case Format::BC1:  return "BC1";
+    case Format::BC3:  return "BC3";
+    case Format::BC7:  return "BC7";
+    case Format::Auto: return "auto";
+    default:           return "none";
+    }
+}
+
+const char* QualityName(Quality quality)
+{
+    switch (quality) {
+    case Quality::Fast: return "fast";
+    case Quality::High: return "high";
+    default:            return "normal";
+    }
+}
+
+size_t BlockBytes(Format format)
+{
+    switch (format) {
+    case Format::BC1: return 8;
+    case Format::BC3:
+    case Format::BC7: return 16;
+    default:          return 0;
+    }
+}
+
+size_t LevelSize(Format format, int w, int h)
+{
+    return (size_t)((w + 3) / 4) * ((h + 3) / 4) * BlockBytes(format);
+}
+
+// Nearest palette entry for every texel (weighted squared distance);
+// returns the block's total error
+static float FindIndices(const Block& blk, const float (*palette)[4], int count,
+    const float weights[4], uint8_t idx[16])
+{
+    float total = 0.0f;
+#if BC_SSE2
+    // Four texels at a time against each palette entry
+    for (int i = 0; i < 16; i += 4) {
+        __m128 px[4];
+        for (int c = 0; c < 4; ++c) {
+            px[c] = _mm_loadu_ps(&blk.c[c][i]);
+        }
+        __m128 best = _mm_set1_ps(FLT_MAX);
+        __m128i bestIdx = _mm_setzero_si128();
+        for (int p = 0; p < count; ++p) {
+            __m128 d = _mm_setzero_ps();
+            for (int c = 0; c < 4; ++c) {
+                __m128 diff = _mm_sub_ps(px[c], _mm_set1_ps(palette[p][c]));
+                d = _mm_add_ps(d, _mm_mul_ps(_mm_mul_ps(diff, diff), _mm_set1_ps(weights[c])));
+            }
+            __m128i closer = _mm_castps_si128(_mm_cmplt_ps(d, best));
+            best = _mm_min_ps(d, best);
+            bestIdx = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(p)),
+                _mm_andnot_si128(closer, bestIdx));
+        }
+        int32_t ib[4];
+        float eb[4];
+        _mm_storeu_si128((__m128i*)ib, bestIdx);
+        _mm_storeu_ps(eb, best);
+        for (int k = 0; k < 4; ++k) {
+            idx[i + k] = (uint8_t)ib[k];
+            total += eb[k];
+        }
+    }
+#else
+    for (int i = 0; i < 16; ++i) {
+        float best = FLT_MAX;
+        int bestIdx = 0;
+        for (int p = 0; p < count; ++p) {
+            float d = 0.0f;
+            for (int c = 0; c < 4; ++c) {
+                float diff = blk.c[c][i] - palette[p][c];
+                d += diff * diff * weights[c];
+            }
+            if (d < best) {
+                best = d;
+                bestIdx = p;
+            }
+        }
+        idx[i] = (uint8_t)bestIdx;
+        total += best;
+    }
+#endif
+    return total;
+}
+
+// Line through the block's texels (channels [0, n)) with endpoints e0, e1
+static void FitEndpoints(const Block& blk, int n, Quality quality, float e0[4], float e1[4])
+{
+    float mn[4], mx[4], mean[4];
+    for (int c = 0; c < 4; ++c) {
+        mn[c] = 255.0f;
+        mx[c] = 0.0f;
+        mean[c] = 0.0f;
+        for (int i = 0; i < 16; ++i) {
+            mn[c] = std::min(mn[c], blk.c[c][i]);
+            mx[c] = std::max(mx[c], blk.c[c][i]);
+            mean[c] += blk.c[c][i];
+        }
+        mean[c] *= 1.0f / 16.0f;
+        e0[c] = e1[c] = mean[c];
+    }
+
+    if (quality == Quality::Fast) {
+        // Bounding-box diagonal, pulled in slightly to cut the extremes' error
+        for (int c = 0; c < n; ++c) {
+            float inset = (mx[c] - mn[c]) / 16.0f;
+            e0[c] = mn[c] + inset;
+            e1[c] = mx[c] - inset;
+        }
+        return;
+    }
+
+    // Principal axis of the covariance by power iteration
+    float cov[4][4] = {};
+    for (int i = 0; i < 16; ++i) {
+        float d[4];
+        for (int c = 0; c < n; ++c) d[c] = blk.c[c][i] - mean[c];
+        for (int a = 0; a < n; ++a) {
+            for (int b = 0; b < n; ++b) cov[a][b] += d[a] * d[b];
+        }
+    }
+    float axis[4] = {};
+    for (int c = 0; c < n; ++c) axis[c] = mx[c] - mn[c];
+    for (int iter = 0; iter < 8; ++iter) {
+        float v[4] = {};
+        for (int a = 0; a < n; ++a) {
+            for (int b = 0; b < n; ++b) v[a] += cov[a][b] * axis[b];
+        }
+        float len = 0.0f;
+        for (int c = 0; c < n; ++c) len = std::max(len, std::fabs(v[c]));
+        if (len < 1e-6f) break;
+        for (int c = 0; c < n; ++c) axis[c] = v[c] / len;
+    }
+    float len2 = 0.0f;
+    for (int c = 0; c < n; ++c) len2 += axis[c] * axis[c];
+    if (len2 < 1e-12f) {
+        return;     // flat block: both endpoints at the mean
+    }
+
+    // Extent of the texels' projections onto the axis
+    float tmin = FLT_MAX, tmax = -FLT_MAX;
+    for (int i = 0; i < 16; ++i) {
+        float t = 0.0f;
+        for (int c = 0; c < n; ++c) t += (blk.c[c][i] - mean[c]) * axis[c];
+        tmin = std::min(tmin, t);
+        tmax = std::max(tmax, t);
+    }
+    tmin /= len2;
+    tmax /= len2;
+    for (int c = 0; c < n; ++c) {
+        e0[c] = std::min(255.0f, std::max(0.0f, mean[c] + tmin * axis[c]));
+        e1[c] = std::min(255.0f, std::max(0.0f, mean[c] + tmax * axis[c]));
+    }
+}
+
+// Least-squares endpoints for fixed indices; weight[i] is how far texel i's
+// palette entry lies from e0 towards e1. False if the system is singular
+static bool RefineEndpoints(const Block& blk, int n, const float weight[16], float e0[4], float e1[4])
+{
+    float a = 0.0f, b = 0.0f, c = 0.0f;
+    float x0[4] = {}, x1[4] = {};
+    for (int i = 0; i < 16; ++i) {
+        float w1 = weight[i], w0 = 1.0f - w1;
+        a += w0 * w0;
+        b += w0 * w1;
+        c += w1 * w1;
+        for (int ch = 0; ch < n; ++ch) {
+            x0[ch] += w0 * blk.c[ch][i];
+            x1[ch] += w1 * blk.c[ch][i];
+        }
+    }
+    float det = a * c - b * b;
+    if (std::fabs(det) < 1e-6f) {
+        return false;
+    }
+    for (int ch = 0; ch < n; ++ch) {
+        e0[ch] = std::min(255.0f, std::max(0.0f, (c * x0[ch] - b * x1[ch]) / det));
+        e1[ch] = std::min(255.0f, std::max(0.0f, (a * x1[ch] - b * x0[ch]) / det));
+    }
+    return true;
+}
+
+// ---- BC1 color block ----
+
+static uint16_t To565(const float c[4])
+{
+    int r = (int)(c[0] * 31.0f / 255.0f + 0.5f);
+    int g = (int)(c[1] * 63.0f / 255.0f + 0.5f);
+    int b = (int)(c[2] * 31.0f / 255.0f + 0.5f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void From565(uint16_t v, int c[3])
+{
+    int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+    c[0] = (r << 3) | (r >> 2);
+    c[1] = (g << 2) | (g >> 4);
+    c[2] = (b << 3) | (b >> 2);
+}
+
+// Indices for endpoints a > b in four-color order (a, b, 2/3 a + 1/3 b,
+// 1/3 a + 2/3 b). Equal endpoints use index 0 only
+static float BC1Indices(const Block& blk, uint16_t a, uint16_t b, uint8_t idx[16])
+{
+    int ca[3], cb[3];
+    From565(a, ca);
+    From565(b, cb);
+    float pal[4][4];
+    for (int c = 0; c < 3; ++c) {
+        pal[0][c] = (float)ca[c];
+        pal[1][c] = (float)cb[c];
+        pal[2][c] = (float)((2 * ca[c] + cb[c]) / 3);
+        pal[3][c] = (float)((ca[c] + 2 * cb[c]) / 3);
+    }
+    for (int p = 0; p < 4; ++p) pal[p][3] = 0.0f;
+    return FindIndices(blk, pal, a == b ? 1 : 4, kRGBWeights, idx);
+}
+
+static void EncodeBC1Block(const Block& blk, Quality quality, uint8_t out[8])
+{
+    float e0[4], e1[4];
+    FitEndpoints(blk, 3, quality, e0, e1);
+    uint16_t a = To565(e1), b = To565(e0);
+    if (a < b) std::swap(a, b);
+    uint8_t idx[16];
+    float err = BC1Indices(blk, a, b, idx);
+
+    if (quality == Quality::High) {
+        static const float kWeight[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+        for (int iter = 0; iter < 2 && a != b; ++iter) {
+            float w[16];
+            for (int i = 0; i < 16; ++i) w[i] = kWeight[idx[i]];
+            float r0[4], r1[4];
+            if (!RefineEndpoints(blk, 3, w, r0, r1)) break;
+            uint16_t na = To565(r0), nb = To565(r1);
+            if (na < nb) std::swap(na, nb);
+            uint8_t nidx[16];
+            float nerr = BC1Indices(blk, na, nb, nidx);
+            if (nerr >= err) break;
+            a = na;
+            b = nb;
+            err = nerr;
+            std::memcpy(idx, nidx, 16);
+        }
+    }
+
+    out[0] = (uint8_t)(a & 0xFF);
+    out[1] = (uint8_t)(a >> 8);
+    out[2] = (uint8_t)(b & 0xFF);
+    out[3] = (uint8_t)(b >> 8);
+    uint32_t bits = 0;
+    for (int i = 0; i < 16; ++i) bits |= (uint32_t)idx[i] << (2 * i);
+    std::memcpy(out + 4, &bits, 4);
+}
+
+// ---- BC3 alpha block ----
+
+static void EncodeAlphaBlock(const Block& blk, uint8_t out[8])
+{
+    int mn = 255, mx = 0;
+    int a[16];
+    for (int i = 0; i < 16; ++i) {
+        a[i] = (int)(blk.c[3][i] + 0.5f);
+        mn = std::min(mn, a[i]);
+        mx = std::max(mx, a[i]);
+    }
+
+    // a0 > a1 selects the eight-value ramp
+    int pal[8] = { mx, mn };
+    for (int i = 2; i < 8; ++i) pal[i] = ((8 - i) * mx + (i - 1) * mn) / 7;
+
+    uint64_t bits = 0;
+    for (int i = 0; i < 16; ++i) {
+        int best = 0, bestErr = 1 << 30;
+        for (int p = 0; p < (mx == mn ? 1 : 8); ++p) {
+            int d = std::abs(a[i] - pal[p]);
+            if (d < bestErr) {
+                bestErr = d;
+                best = p;
+            }
+        }
+        bits |= (uint64_t)best << (3 * i);
+    }
+    out[0] = (uint8_t)mx;
+    out[1] = (uint8_t)mn;
+    for (int i = 0; i < 6; ++i) out[2 + i] = (uint8_t)(bits >> (8 * i));
+}
+
+// ---- BC7 mode 6 ----
+
+// 7-bit endpoint plus shared p-bit: value = (q << 1) | p
+static void QuantizeBC7(const float e[4], int p, int q[4])
+{
+    for (int c = 0; c < 4; ++c) {
+        int v = (int)std::floor((e[c] - p) * 0.5f + 0.5f);
+        q[c] = std::min(127, std::max(0, v));
+    }
+}
+
+static float BC7Indices(const Block& blk, const int q0[4], int p0, const int q1[4], int p1, uint8_t idx[16])
+{
+    float pal[16][4];
+    for (int c = 0; c < 4; ++c) {
+        int v0 = (q0[c] << 1) | p0;
+        int v1 = (q1[c] << 1) | p1;
+        for (int i = 0; i < 16; ++i) {
+            pal[i][c] = (float)(((64 - kBC7Weights[i]) * v0 + kBC7Weights[i] * v1 + 32) >> 6);
+        }
+    }
+    return FindIndices(blk, pal, 16, kRGBAWeights, idx);
+}
+
+// Best p-bits for a pair of float endpoints. Normal rounds each endpoint
+// on its own; High tries all four combinations against the block
+static float EncodeBC7Endpoints(const Block& blk, Quality quality, const float e0[4], const float e1[4],
+    int q0[4], int& p0, int q1[4], int& p1, uint8_t idx[16])
+{
+    if (quality != Quality::High) {
+        auto pick = [](const float e[4], int q[4]) {
+            int best = 0;
+            float bestErr = FLT_MAX;
+            for (int p = 0; p < 2; ++p) {
+                int t[4];
+                QuantizeBC7(e, p, t);
+                float err = 0.0f;
+                for (int c = 0; c < 4; ++c) {
+                    float d = (float)((t[c] << 1) | p) - e[c];
+                    err += d * d;
+                }
+                if (err < bestErr) {
+                    bestErr = err;
+                    best = p;
+                    std::memcpy(q, t, sizeof(t));
+                }
+            }
+            return best;
+        };
+        p0 = pick(e0, q0);
+        p1 = pick(e1, q1);
+        return BC7Indices(blk, q0, p0, q1, p1, idx);
+    }
+
+    float bestErr = FLT_MAX;
+    for (int combo = 0; combo < 4; ++combo) {
+        int a = combo & 1, b = combo >> 1;
+        int t0[4], t1[4];
+        QuantizeBC7(e0, a, t0);
+        QuantizeBC7(e1, b, t1);
+        uint8_t tidx[16];
+        float err = BC7Indices(blk, t0, a, t1, b, tidx);
+        if (err < bestErr) {
+            bestErr = err;
+            std::memcpy(q0, t0, sizeof(t0));
+            std::memcpy(q1, t1, sizeof(t1));
+            p0 = a;
+            p1 = b;
+            std::memcpy(idx, tidx, 16);
+        }
+    }
+    return bestErr;
+}
+
+// Little-endian bit stream filling a 128-bit block
+struct BitWriter {
+    uint64_t lo = 0, hi = 0;
+    int pos = 0;
+
+    void Put(uint64_t v, int n) {
+        if (pos < 64) {
+            lo |= v << pos;
+            if (pos + n > 64) hi |= v >> (64 - pos);
+        }
+        else {
+            hi |= v << (pos - 64);
+        }
+        pos += n;
+    }
+};
+
+static void EncodeBC7Block(const Block& blk, Quality quality, uint8_t out[16])
+{
+    float e0[4], e1[4];
+    FitEndpoints(blk, 4, quality, e0, e1);
+    int q0[4] = {}, q1[4] = {}, p0 = 0, p1 = 0;
+    uint8_t idx[16];
+    float err = EncodeBC7Endpoints(blk, quality, e0, e1, q0, p0, q1, p1, idx);
+
+    if (quality == Quality::High) {
+        float w[16];
+        for (int i = 0; i < 16; ++i) w[i] = kBC7Weights[idx[i]] / 64.0f;
+        float r0[4], r1[4];
+        std::memcpy(r0, e0, sizeof(r0));
+        std::memcpy(r1, e1, sizeof(r1));
+        if (RefineEndpoints(blk, 4, w, r0, r1)) {
+            int n0[4] = {}, n1[4] = {}, np0 = 0, np1 = 0;
+            uint8_t nidx[16] = {};
+            float nerr = EncodeBC7Endpoints(blk, quality, r0, r1, n0, np0, n1, np1, nidx);
+            if (nerr < err) {
+                std::memcpy(q0, n0, sizeof(n0));
+                std::memcpy(q1, n1, sizeof(n1));
+                p0 = np0;
+                p1 = np1;
+                std::memcpy(idx, nidx, 16);
+            }
+        }
+    }
+
+    // The first texel's index is stored with its top bit implied zero
+    if (idx[0] >= 8) {
+        for (int c = 0; c < 4; ++c) std::swap(q0[c], q1[c]);
+        std::swap(p0, p1);
+        for (int i = 0; i < 16; ++i) idx[i] = (uint8_t)(15 - idx[i]);
+    }
+
+    BitWriter bw;
+    bw.Put(1 << 6, 7);                  // mode 6
+    for (int c = 0; c < 4; ++c) {
+        bw.Put((uint64_t)q0[c], 7);
+        bw.Put((uint64_t)q1[c], 7);
+    }
+    bw.Put((uint64_t)p0, 1);
+    bw.Put((uint64_t)p1, 1);
+    bw.Put(idx[0], 3);
+    for (int i = 1; i < 16; ++i) bw.Put(idx[i], 4);
+    std::memcpy(out, &bw.lo, 8);
+    std::memcpy(out + 8, &bw.hi, 8);
+}
+
+// ---- Driver ----
+
+// 4x4 texels at block (bx, by); texels past the edge repeat the last row / column
+static void LoadBlock(const unsigned char* pixels, int w, int h, int channels, int bx, int by, Block& blk)
+{
+    for (int y = 0; y < 4; ++y) {
+        int sy = std::min(by * 4 + y, h - 1);
+        for (int x = 0; x < 4; ++x) {
+            int sx = std::min(bx * 4 + x, w - 1);
+            const unsigned char* p = pixels + ((size_t)sy * w + sx) * channels;
+            int i = y * 4 + x;
+            blk.c[0][i] = p[0];
+            blk.c[1][i] = p[1];
+            blk.c[2][i] = p[2];
+            blk.c[3][i] = channels == 4 ? p[3] : 255.0f;
+        }
+    }
+}
+
+void Compress(Format format, Quality quality, const unsigned char* pixels,
+    int w, int h, int channels, unsigned char* out, ThreadPool* pool)
+{
+    const size_t blockBytes = BlockBytes(format);
+    if (blockBytes == 0 || channels < 3) {
+        return;
+    }
+    const int blocksX = (w + 3) / 4;
+    const int blocksY = (h + 3) / 4;
+
+    auto encodeRow = [&](size_t row) {
+        int by = (int)row;
+        Block blk;
+        unsigned char* dst = out + (size_t)by * blocksX * blockBytes;
+        for (int bx = 0; bx < blocksX; ++bx, dst += blockBytes) {
+            LoadBlock(pixels, w, h, channels, bx, by, blk);
+            switch (format) {
+            case Format::BC1:
+                EncodeBC1Block(blk, quality, dst);
+                break;
+            case Format::BC3:
+                EncodeAlphaBlock(blk, dst);
+                EncodeBC1Block(blk, quality, dst + 8);
+                break;
+            case Format::BC7:
+                EncodeBC7Block(blk, quality, dst);
+                break;
+            default:
+                break;
+            }
+        }
+    };
+
+    if (pool && blocksY > 1) {
+        pool->ParallelFor((size_t)blocksY, encodeRow);
+    }
+    else {
+        for (int by = 0; by < blocksY; ++by) encodeRow((size_t)by);
+    }
+}
+
+// ---- Decoding ----
+
+static void DecodeColorBlock(const uint8_t* in, bool allowThreeColor, uint8_t rgba[16][4])
+{
+    uint16_t a = (uint16_t)(in[0] | (in[1] << 8));
+    uint16_t b = (uint16_t)(in[2] | (in[3] << 8));
+    int ca[3], cb[3];
+    From565(a, ca);
+    From565(b, cb);
+    int pal[4][4];
+    for (int c = 0; c < 3; ++c) {
+        pal[0][c] = ca[c];
+        pal[1][c] = cb[c];
+        if (a > b || !allowThreeColor) {
+            pal[2][c] = (2 * ca[c] + cb[c]) / 3;
+            pal[3][c] = (ca[c] + 2 * cb[c]) / 3;
+        }
+        else {
+            pal[2][c] = (ca[c] + cb[c]) / 2;
+            pal[3][c] = 0;
+        }
+    }
+    for (int p = 0; p < 4; ++p) pal[p][3] = 255;
+    uint32_t bits;
+    std::memcpy(&bits, in + 4, 4);
+    for (int i = 0; i < 16; ++i) {
+        int p = (bits >> (2 * i)) & 3;
+        for (int c = 0; c < 4; ++c) rgba[i][c] = (uint8_t)pal[p][c];
+    }
+}
+
+static void DecodeAlphaBlock(const uint8_t* in, uint8_t rgba[16][4])
+{
+    int a0 = in[0], a1 = in[1];
+    int pal[8] = { a0, a1 };
+    if (a0 > a1) {
+        for (int i = 2; i < 8; ++i) pal[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+    }
+    else {
+        for (int i = 2; i < 6; ++i) pal[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+        pal[6] = 0;
+        pal[7] = 255;
+    }
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; ++i) bits |= (uint64_t)in[2 + i] << (8 * i);
+    for (int i = 0; i < 16; ++i) rgba[i][3] = (uint8_t)pal[(bits >> (3 * i)) & 7];
+}
+
+static void DecodeBC7Block(const uint8_t* in, uint8_t rgba[16][4])
+{
+    uint64_t lo, hi;
+    std::memcpy(&lo, in, 8);
+    std::memcpy(&hi, in + 8, 8);
+    int pos = 0;
+    auto get = [&](int n) {
+        uint64_t v;
+        if (pos >= 64) v = hi >> (pos - 64);
+        else if (pos + n > 64) v = (lo >> pos) | (hi << (64 - pos));
+        else v = lo >> pos;
+        pos += n;
+        return (int)(v & ((1ull << n) - 1));
+    };
+
+    if ((lo & 0x7F) != 0x40) {
+        // Not mode 6: flag it in magenta rather than guess
+        for (int i = 0; i < 16; ++i) {
+            rgba[i][0] = 255; rgba[i][1] = 0; rgba[i][2] = 255; rgba[i][3] = 255;
+        }
+        return;
+    }
+    get(7);
+    int q0[4], q1[4];
+    for (int c = 0; c < 4; ++c) {
+        q0[c] = get(7);
+        q1[c] = get(7);
+    }
+    int p0 = get(1), p1 = get(1);
+    for (int i = 0; i < 16; ++i) {
+        int idx = get(i == 0 ? 3 : 4);
+        for (int c = 0; c < 4; ++c) {
+            int v0 = (q0[c] << 1) | p0;
+            int v1 = (q1[c] << 1) | p1;
+            rgba[i][c] = (uint8_t)(((64 - kBC7Weights[idx]) * v0 + kBC7Weights[idx] * v1 + 32) >> 6);
+        }
+    }
+}
+
+void Decompress(Format format, const unsigned char* blocks, int w, int h, unsigned char* rgba)
+{
+    const size_t blockBytes = BlockBytes(format);
+    if (blockBytes == 0) {
+        return;
+    }
+    const int blocksX = (w + 3) / 4;
+    const int blocksY = (h + 3) / 4;
+    uint8_t texels[16][4];
+    for (int by = 0; by < blocksY; ++by) {
+        for (int bx = 0; bx < blocksX; ++bx) {
+            const uint8_t* in = blocks + ((size_t)by * blocksX + bx) * blockBytes;
+            switch (format) {
+            case Format::BC1:
+                DecodeColorBlock(in, true, texels);
+                break;
+            case Format::BC3:
+                DecodeColorBlock(in + 8, false, texels);
+                DecodeAlphaBlock(in, texels);
+                break;
+            case Format::BC7:
+                DecodeBC7Block(in, texels);
+                break;
+            default:
+                break;
+            }
+            for (int y = 0; y < 4; ++y) {
+                for (int x = 0; x < 4; ++x) {
+                    int px = bx * 4 + x, py = by * 4 + y;
+                    if (px < w && py < h) {
+                        std::memcpy(rgba + ((size_t)py * w + px) * 4, texels[y * 4 + x], 4);
+                    }
+                }
+            }
+        }
+    }
+}
+
+}
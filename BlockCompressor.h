@@ -0,0 +1,50 @@
+// BlockCompressor.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+class ThreadPool;
+
+// CPU encoder for the GPU block-compressed formats. Every 4x4 texel block
+// becomes 8 (BC1) or 16 (BC3, BC7) bytes that the GPU samples directly,
+// cutting texture memory to 1/6 (BC1 on RGB) or 1/4 (BC3 / BC7 on RGBA).
+namespace BlockCompressor {
+
+enum class Format : uint32_t {
+    None = 0,   // keep uncompressed
+    BC1,        // RGB, 4 bpp
+    BC3,        // RGBA: BC1 color plus an interpolated alpha block, 8 bpp
+    BC7,        // RGBA, 8 bpp; this encoder emits mode 6 (one subset, 4-bit indices)
+    Auto        // BC1 for RGB images, BC3 for RGBA, uncompressed otherwise
+};
+
+// Speed / quality trade-off of the endpoint search
+enum class Quality : uint32_t {
+    Fast = 0,   // bounding-box endpoints
+    Normal,     // principal-axis endpoints
+    High        // principal axis plus least-squares refinement (and p-bit search for BC7)
+};
+
+// Concrete format for an image with this many channels (resolves Auto;
+// gray / gray-alpha images stay uncompressed)
+Format Resolve(Format requested, int channels);
+
+const char* FormatName(Format format);
+const char* QualityName(Quality quality);
+
+// Bytes per 4x4 block, 0 for None
+size_t BlockBytes(Format format);
+
+// Bytes of one compressed w x h level (partial blocks are padded)
+size_t LevelSize(Format format, int w, int h);
+
+// Compress a tightly packed 3- or 4-channel image into out (LevelSize
+// bytes). Rows of blocks are spread over pool when one is given
+void Compress(Format format, Quality quality, const unsigned char* pixels,
+    int w, int h, int channels, unsigned char* out, ThreadPool* pool = nullptr);
+
+// Expand compressed data back to tightly packed RGBA8 (used to measure
+// quality; BC7 only handles the mode 6 blocks Compress writes)
+void Decompress(Format format, const unsigned char* blocks, int w, int h, unsigned char* rgba);
+
+}
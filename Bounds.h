@@ -0,0 +1,35 @@
+// Bounds.h
+#pragma once
+#include <glm/glm.hpp>
+#include <cmath>
+
+// Axis-aligned bounding box
+struct AABB {
+    glm::vec3 min;
+    glm::vec3 max;
+
+    AABB() : min(0.0f), max(0.0f) {}
+    AABB(const glm::vec3& mn, const glm::vec3& mx) : min(mn), max(mx) {}
+
+    glm::vec3 Center()  const { return (min + max) * 0.5f; }
+    glm::vec3 Extents() const { return (max - min) * 0.5f; }
+
+    // Radius of the bounding sphere around Center()
+    float Radius() const {
+        glm::vec3 e = Extents();
+        return std::sqrt(e.x * e.x + e.y * e.y + e.z * e.z);
+    }
+
+    // Box enclosing this box after an affine transform
+    AABB Transformed(const glm::mat4& m) const {
+        glm::vec3 c = Center();
+        glm::vec3 e = Extents();
+        glm::vec3 center(m[3]);
+        glm::vec3 extent(0.0f);
+        for (int col = 0; col < 3; ++col) {
+            center += glm::vec3(m[col]) * c[col];
+            extent += glm::abs(glm::vec3(m[col])) * e[col];
+        }
+        return AABB(center - extent, center + extent);
+    }
+};
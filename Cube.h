@@ -6,8 +6,9 @@
 
 class Cube : public Object3D {
 public:
-    Cube() = default;
+    // Unit cube centered at the origin
+    Cube() { SetLocalBounds(AABB(glm::vec3(-0.5f), glm::vec3(0.5f))); }
     virtual ~Cube() = default;
 
-    virtual void Draw() override;
-};
\ No newline at end of file
+    virtual Mesh* GetMesh() override;
+};
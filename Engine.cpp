@@ -5,19 +5,32 @@
 #include "Cube.h"
 #include "Pyramid.h"
 #include "Sphere.h"
+#include "Mesh.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 
 // Initialize the static instance pointer to nullptr
 Engine* Engine::instance = nullptr;
 
 Engine::Engine(int argc, char** argv)
-    : width(800),
+    : placeholderTexture(nullptr),
+    cubeMesh(nullptr),
+    pyramidMesh(nullptr),
+    width(800),
     height(600),
     fullscreen(false),
     window(0),
+    argCount(argc),
+    argValues(argv),
+    showHelp(false),
+    headless(false),
+    headlessFrames(0),
+    showPerfHud(false),
     fps(60),
     clearColor(0.0f, 0.0f, 0.0f),
     projMode(ProjectionMode::Perspective),
@@ -28,35 +41,51 @@ Engine::Engine(int argc, char** argv)
     orthoRight(1.0f),
     orthoBottom(-1.0f),
     orthoTop(1.0f),
+    projection(1.0f),
+    view(1.0f),
     angleY(0.0f),
     angleX(0.0f),
     camDist(5.0f),
     camTarget(0.0f, 0.0f, 0.0f),
     lastMouseX(-1),
     lastMouseY(-1),
+    pressMouseX(-1),
+    pressMouseY(-1),
     rotating(false),
     lightingEnabled(true),
     shadingEnabled(true),
+    textureFormat(BlockCompressor::Format::Auto),
+    textureQuality(BlockCompressor::Quality::Normal),
+    textureMipFilter(MipGenerator::Filter::Box),
+    gammaCorrectMips(false),
+    textureCache(textureLoader),
+    instancingEnabled(true),
+    softwareEnabled(false),
+    textureArrayEnabled(true),
+    culledCount(0),
     selectedIndex(-1),
-    showHelp(false)
+    textureSwitches(0),
+    textureSwitchMisses(0),
+    missTexIndex(-1),
+    missPixels(0.0f),
+    missWaitMs(0.0)
 {
-    // Initialize GLUT
-    glutInit(&argc, argv);
+    // GLUT is initialized in Init, and only when there will be a window
 
     //instance pointer
     instance = this;
+
+    // New objects register their transforms with this engine's store
+    TransformStore::instance = &transforms;
+
+    // Texture binds and line state go through this engine's tracker
+    RenderState::instance = &renderState;
+    PixelUploadRing::instance = &uploadRing;
+    Profiler::instance = &profiler;
 }
 
 Engine::~Engine() {
-    // Delete all loaded textures
-    for (auto tex : textures) {
-        if (tex) {
-            tex->Delete();
-            delete tex;
-        }
-    }
-    textures.clear();
-
+    // The GL objects went in Cleanup, while their context was current.
     // Delete all allocated scene objects
     for (auto obj : objects) {
         delete obj;
@@ -64,20 +93,83 @@ Engine::~Engine() {
     objects.clear();
 }
 
+void Engine::DeleteGLObjects() {
+    // Release the texture handles; the last one frees each GL texture
+    textures.clear();
+    if (placeholderTexture) {
+        placeholderTexture->Delete();
+        delete placeholderTexture;
+        placeholderTexture = nullptr;
+    }
+
+    // Delete the shared primitive meshes
+    for (Mesh* mesh : { cubeMesh, pyramidMesh }) {
+        if (mesh) {
+            mesh->Delete();
+            delete mesh;
+        }
+    }
+    cubeMesh = pyramidMesh = nullptr;
+
+    textureArray.Delete();
+    perfHud.Delete();
+    profiler.Delete();
+    instancer.Delete();
+    uploadRing.Delete();
+}
+
 void Engine::Init() {
-    // Set up display mode. double buffering, RGB, depth buffer
-    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
-    glutInitWindowSize(width, height);
-    window = glutCreateWindow("3D Engine");
+    if (headless) {
+        // No window: a context of our own drawing into a framebuffer object
+        if (!offscreen.Create(width, height)) {
+            std::cerr << "Headless rendering not available\n";
+            exit(1);
+        }
+    }
+    else {
+        glutInit(&argCount, argValues);
+
+        // Set up display mode. double buffering, RGB, depth buffer
+        glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
+        glutInitWindowSize(width, height);
+        window = glutCreateWindow("3D Engine");
+
+        GLenum glewErr = glewInit();
+        if (glewErr != GLEW_OK) {
+            std::cerr << "GLEW initialization failed: "
+                << glewGetErrorString(glewErr) << std::endl;
+            exit(1);
+        }
+    }
+
+    // SetClearColor may have been called before there was a context
+    glClearColor(clearColor.x, clearColor.y, clearColor.z, 1.0f);
+
+    // Stage texture uploads in a pixel buffer (placeholder included)
+    uploadRing.Init();
 
-    GLenum glewErr = glewInit();
-    if (glewErr != GLEW_OK) {
-        std::cerr << "GLEW initialization failed: "
-            << glewGetErrorString(glewErr) << std::endl;
-        exit(1);
+    // ENGINE_PROFILE=<frames> profiles the first frames, and the texture
+    // loads started below, into ENGINE_PROFILE_OUT (default frame_trace.json)
+    profiler.SetThreadName("Main");
+    if (const char* frames = std::getenv("ENGINE_PROFILE")) {
+        const char* path = std::getenv("ENGINE_PROFILE_OUT");
+        profiler.StartCapture(std::atoi(frames), path ? path : "frame_trace.json");
     }
 
-    if (fullscreen) {
+    // Compress textures only into formats this GPU can sample
+    BlockCompressor::Format format = textureFormat;
+    if (format == BlockCompressor::Format::BC7 && !GLEW_ARB_texture_compression_bptc) {
+        std::cerr << "BC7 textures not supported, using BC1 / BC3\n";
+        format = BlockCompressor::Format::Auto;
+    }
+    if (format != BlockCompressor::Format::BC7 && !GLEW_EXT_texture_compression_s3tc) {
+        format = BlockCompressor::Format::None;
+    }
+    textureLoader.SetCompression(format, textureQuality);
+    textureLoader.SetMipFilter(textureMipFilter, gammaCorrectMips);
+    textureLoader.SetStreamer(&textureStreamer);
+
+    if (fullscreen && !headless) {
         glutFullScreen();
     }
 
@@ -113,23 +205,49 @@ void Engine::Init() {
     glLightfv(GL_LIGHT0, GL_SPECULAR, specular);
     glLightfv(GL_LIGHT0, GL_POSITION, position);
 
-    // Load all the textures we want to cycle through:
-    textures.push_back(new Texture2D("brick.png"));
-    textures.push_back(new Texture2D("wood.png"));
-    textures.push_back(new Texture2D("avocado.png"));
-    textures.push_back(new Texture2D("burgers.png"));
-    textures.push_back(new Texture2D("sky.png"));
-    textures.push_back(new Texture2D("planet.png"));
-    textures.push_back(new Texture2D("holo.png"));
-    textures.push_back(new Texture2D("hoth.png"));
-    textures.push_back(new Texture2D("moon.png"));
-    textures.push_back(new Texture2D("holo.png"));
-    textures.push_back(new Texture2D("deathstar.png"));
+    // Grey checkerboard shown while the real textures are still decoding
+    const unsigned char checker[] = {
+        200, 200, 200,  120, 120, 120,
+        120, 120, 120,  200, 200, 200
+    };
+    placeholderTexture = new Texture2D();
+    placeholderTexture->Upload(checker, 2, 2, 3, "placeholder");
+    placeholderTexture->Bind();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    Texture2D::Unbind();
+
+    // Start decoding all the textures we want to cycle through; they are
+    // uploaded from Display as each one finishes
+    textures.push_back(textureCache.Get("brick.png"));
+    textures.push_back(textureCache.Get("wood.png"));
+    textures.push_back(textureCache.Get("avocado.png"));
+    textures.push_back(textureCache.Get("burgers.png"));
+    textures.push_back(textureCache.Get("sky.png"));
+    textures.push_back(textureCache.Get("planet.png"));
+    textures.push_back(textureCache.Get("holo.png"));
+    textures.push_back(textureCache.Get("hoth.png"));
+    textures.push_back(textureCache.Get("moon.png"));
+    textures.push_back(textureCache.Get("holo.png"));
+    textures.push_back(textureCache.Get("deathstar.png"));
+
+    // Upload the primitive geometry once; every object draws from these
+    cubeMesh = Mesh::CreateCube();
+    pyramidMesh = Mesh::CreatePyramid();
+
+    // Compile the instancing shader (falls back to per-object draws)
+    instancer.Init();
 
     //Create the initial scene object and select the first
     objects.push_back(new Cube());
     selectedIndex = 0;  // index 0 is the first object
 
+    if (headless) {
+        // The size GLUT would have reported for the window
+        Reshape(width, height);
+        return;
+    }
+
     // Register GLUT callbacks
     glutDisplayFunc(DisplayCallback);
     glutReshapeFunc(ReshapeCallback);
@@ -141,16 +259,46 @@ void Engine::Init() {
 }
 
 void Engine::Run() {
+    if (headless) {
+        RunHeadless();
+        return;
+    }
+
     // Enter the GLUT event loop
     glutMainLoop();
 }
 
+void Engine::RunHeadless() {
+    // Final textures from the first frame, so the output doesn't depend on
+    // decode timing
+    LoadAllTextures();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < headlessFrames; ++i) {
+        Display();
+    }
+    glFinish();
+    double ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    std::cout << "Headless: " << headlessFrames << " frames in " << ms << " ms ("
+        << (ms > 0.0 ? headlessFrames * 1000.0 / ms : 0.0) << " fps)\n";
+
+    if (!headlessImage.empty() && offscreen.SaveImage(headlessImage.c_str())) {
+        std::cout << "Last frame saved to " << headlessImage << "\n";
+    }
+}
+
 void Engine::Cleanup() {
     std::cout << "Cleaning up...\n";
+    profiler.Finish();
+
+    // Free the GL objects while their context is still current
+    DeleteGLObjects();
     if (window != 0) {
         glutDestroyWindow(window);
         window = 0;
     }
+    offscreen.Delete();
 }
 
 //   Configuration setters
@@ -172,6 +320,161 @@ void Engine::SetFPS(int frames) {
     fps = frames;
 }
 
+void Engine::SetTextureCompression(BlockCompressor::Format format, BlockCompressor::Quality quality) {
+    textureFormat = format;
+    textureQuality = quality;
+}
+
+void Engine::SetTextureMipFilter(MipGenerator::Filter filter, bool gammaCorrect) {
+    textureMipFilter = filter;
+    gammaCorrectMips = gammaCorrect;
+}
+
+void Engine::SetTextureBudget(size_t bytes) {
+    textureStreamer.SetBudget(bytes);
+}
+
+void Engine::SetHeadless(int frames, const char* imagePath) {
+    headless = true;
+    headlessFrames = frames;
+    headlessImage = imagePath ? imagePath : "";
+}
+
+void Engine::SetSoftwareRendering(bool value) {
+    softwareEnabled = value;
+    if (!softwareEnabled) {
+        softwareRasterizer.ReleaseTextures();
+    }
+}
+
+void Engine::SetInstancedRendering(bool value) {
+    instancingEnabled = value;
+}
+
+void Engine::SetPerfHud(bool value) {
+    showPerfHud = value;
+    profiler.SetLiveTimings(value);
+}
+
+void Engine::AddObject(Object3D* obj) {
+    // New objects take the next store slot, so appending keeps slot order
+    objects.push_back(obj);
+}
+
+void Engine::ClearObjects() {
+    // From the back, so every release is the store's last slot
+    while (!objects.empty()) {
+        delete objects.back();
+        objects.pop_back();
+    }
+    selectedIndex = -1;
+}
+
+void Engine::SetCamera(float yaw, float pitch, float distance, const glm::vec3& target) {
+    angleY = yaw;
+    angleX = pitch;
+    camDist = distance;
+    camTarget = target;
+}
+
+void Engine::RenderFrame() {
+    Display();
+}
+
+Engine::FrameStats Engine::GetFrameStats() const {
+    FrameStats stats;
+    stats.drawCalls = renderState.GetDrawCalls();
+    stats.stateChanges = renderState.GetIssuedCalls();
+    stats.redundantStates = renderState.GetSkippedCalls();
+    stats.visibleObjects = visibleObjects.size();
+    stats.culledObjects = culledCount;
+    return stats;
+}
+
+void Engine::LoadAllTextures() {
+    textureLoader.WaitForDecodes();
+    while (textureLoader.GetPendingCount() > 0) {
+        textureLoader.PumpUploads(1000.0);
+    }
+    if (!textureArray.IsBuilt()) {
+        textureArray.Build(textures, textureStreamer);
+        textureStreamer.SetReservedBytes(textureArray.GetByteSize());
+    }
+}
+
+
+void Engine::BenchmarkRenderers(int frames) {
+    // Every texture resident first, so each renderer draws the same frames
+    LoadAllTextures();
+
+    // A 10 x 10 x 5 block of mixed, mostly textured objects in front of the camera
+    const size_t firstAdded = objects.size();
+    for (int i = 0; i < 500; ++i) {
+        Object3D* obj;
+        switch (i % 3) {
+        case 0:  obj = new Cube(); break;
+        case 1:  obj = new Pyramid(); break;
+        default: obj = new Sphere(); break;
+        }
+        obj->SetPosition(camTarget + 1.2f * glm::vec3((i % 10) - 4.5f, (i / 10 % 10) - 4.5f, -(float)(i / 100)));
+        obj->SetRotation(glm::vec3(0.3f * i, 0.7f * i, 0.0f));
+        obj->SetTextured(i % 4 != 3);
+        obj->SetTexIndex(i);
+        objects.push_back(obj);
+    }
+    const float savedDist = camDist;
+    const bool savedInstancing = instancingEnabled;
+    const bool savedSoftware = softwareEnabled;
+    camDist = 14.0f;
+
+    struct Renderer {
+        const char* name;
+        bool software;
+        bool instancing;
+    };
+    const Renderer renderers[] = {
+        { "GL instanced", false, true },
+        { "GL fixed-function", false, false },
+        { "Software", true, false },
+    };
+    for (const Renderer& r : renderers) {
+        if (r.instancing && !instancer.IsSupported()) {
+            continue;
+        }
+        softwareEnabled = r.software;
+        instancingEnabled = r.instancing;
+
+        // Warm-up frames stream the mip levels in
+        for (int i = 0; i < 5; ++i) {
+            Display();
+        }
+        glFinish();
+
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < frames; ++i) {
+            Display();
+            glFinish();
+        }
+        double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        std::cout << r.name << ": " << frames * 1000.0 / ms << " fps ("
+            << ms / frames << " ms/frame)\n";
+    }
+
+    // Put the scene back
+    while (objects.size() > firstAdded) {
+        delete objects.back();
+        objects.pop_back();
+    }
+    selectedIndex = std::min(selectedIndex, (int)objects.size() - 1);
+    camDist = savedDist;
+    instancingEnabled = savedInstancing;
+    softwareEnabled = savedSoftware;
+    if (!softwareEnabled) {
+        softwareRasterizer.ReleaseTextures();
+    }
+}
+
 
 //   Projection setters
 void Engine::SetPerspective(float fovDeg, float zn, float zf) {
@@ -193,13 +496,37 @@ void Engine::SetOrtho(float left, float right, float bottom, float top, float zn
 
 //   Display callback
 void Engine::Display() {
+    // Frame boundary first: it may end a capture, which writes the trace
+    profiler.BeginFrame();
+    perfHud.BeginFrame();
+    PROFILE_SCOPE("Engine::Display");
+
     // Clear color & depth buffers
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    // Count redundant state changes per frame
+    renderState.BeginFrame();
+
+    // Make newly decoded textures resident, a few milliseconds' worth per frame
+    if (textureLoader.PumpUploads(4.0) > 0 && textureLoader.GetPendingCount() == 0) {
+        std::cout << "Textures: " << textureCache.GetLiveCount() << " resident ("
+            << textureCache.GetDedupCount() << " duplicate loads shared), "
+            << textureCache.GetResidentBytes() / (1024 * 1024) << " MB, "
+            << textureLoader.GetBytesSaved() / (1024 * 1024) << " MB saved by block compression\n";
+
+        // Every texture is in; copy the ones that fit into layers, whose
+        // memory then comes out of the streaming budget
+        if (textureArray.Build(textures, textureStreamer) > 0) {
+            std::cout << "Texture array: " << textureArray.GetLayerCount() << " layers, "
+                << textureArray.GetByteSize() / (1024 * 1024) << " MB\n";
+        }
+        textureStreamer.SetReservedBytes(textureArray.GetByteSize());
+    }
+
     // Build camera (view) matrix
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
-    glm::mat4 view = glm::lookAt(
+    view = glm::lookAt(
         glm::vec3(
             camDist * sin(angleY) * cos(angleX) + camTarget.x,
             camDist * sin(angleX) + camTarget.y,
@@ -210,22 +537,82 @@ void Engine::Display() {
     );
     glLoadMatrixf(glm::value_ptr(view));
 
-    // Mark exactly one object as selected
-    for (int i = 0; i < (int)objects.size(); ++i) {
-        objects[i]->SetSelected(i == selectedIndex);
+    // Rebuild model matrices only for objects that moved since last frame
+    transforms.UpdateModelMatrices();
+
+    // Mark exactly one object as selected (one linear pass over the flags)
+    transforms.SetFlagAll(TransformStore::FlagSelected, false);
+    if (selectedIndex >= 0 && selectedIndex < (int)objects.size()) {
+        objects[selectedIndex]->SetSelected(true);
     }
 
-    // Draw all objects
-    for (auto obj : objects) {
-        obj->Draw();
+    // Drop objects whose world bounds are outside the view frustum
+    frustum.Extract(projection * view);
+    visibleObjects.clear();
+    culledCount = transforms.CullFrustum(frustum, visibleObjects);
+
+    // Queue the visible objects keyed by mesh, texture and view depth, and
+    // ask for the texture levels their size on screen needs
+    renderQueue.Clear();
+    const glm::vec4 viewZ(view[0][2], view[1][2], view[2][2], view[3][2]);
+    const float invRange = 1.0f / (zFar - zNear);
+    for (auto obj : visibleObjects) {
+        const AABB& bounds = obj->GetWorldBounds();
+        float depth = -glm::dot(viewZ, glm::vec4(bounds.Center(), 1.0f));
+        renderQueue.Submit(obj, RenderQueue::PassOpaque, (depth - zNear) * invRange);
+        if (obj->IsTextured() && !DrawnFromArray(obj->GetTexture())) {
+            textureStreamer.Request(obj->GetTexture(), ScreenSize(bounds, depth));
+        }
+    }
+    PrefetchNeighbourTextures();
+    renderQueue.Sort();
+
+    // Draw the queue: on the CPU, or one instanced call per run when
+    // instancing is on
+    if (softwareEnabled) {
+        softwareRasterizer.Render(renderQueue, view, projection, lightingEnabled, shadingEnabled,
+            clearColor, textureStreamer);
+        softwareRasterizer.Present();
+    }
+    else if (instancingEnabled && instancer.IsSupported()) {
+        instancer.Render(renderQueue, lightingEnabled, textureArrayEnabled ? &textureArray : nullptr);
+    }
+    else {
+        renderQueue.Execute();
+    }
+
+    // Upload / evict mip levels for what was just drawn; used from next frame
+    textureStreamer.Update(2.0);
+
+    // A missed texture switch is over once its texture is fully in
+    if (missTexIndex >= 0) {
+        Texture2D* tex = textures[missTexIndex].get();
+        if (!tex->IsPending() && (DrawnFromArray(tex) || textureStreamer.IsResident(tex, missPixels))) {
+            double ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - missStart).count();
+            missWaitMs += ms;
+            missTexIndex = -1;
+            std::cout << "Texture switch resolved after " << ms << " ms ("
+                << textureSwitchMisses << " of " << textureSwitches << " switches missed, "
+                << missWaitMs << " ms waited in total)\n";
+        }
     }
 
     if (showHelp) {
         DrawHelpOverlay();
     }
+    if (showPerfHud) {
+        DrawPerfHud();
+    }
 
-    // Swap buffers
-    glutSwapBuffers();
+    // Swap buffers (headless: just flush the offscreen frame)
+    if (offscreen.IsCreated()) {
+        offscreen.Swap();
+    }
+    else {
+        PROFILE_SCOPE("glutSwapBuffers");
+        glutSwapBuffers();
+    }
 }
 
 
@@ -239,21 +626,94 @@ void Engine::Reshape(int w, int h) {
     float aspect = (float)w / (float)h;
     glViewport(0, 0, w, h);
 
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
+    // Keep the matrix on the CPU as well; Display culls against it
     if (projMode == ProjectionMode::Perspective) {
-        gluPerspective(fov, aspect, zNear, zFar);
+        projection = glm::perspective(glm::radians(fov), aspect, zNear, zFar);
     }
     else {
-        glOrtho(orthoLeft * aspect,
+        projection = glm::ortho(orthoLeft * aspect,
             orthoRight * aspect,
             orthoBottom,
             orthoTop,
             zNear,
             zFar);
     }
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixf(glm::value_ptr(projection));
+
+    softwareRasterizer.Resize(w, h);
+}
+
+
+float Engine::ViewDepth(const glm::vec3& p) const {
+    return -(view[0][2] * p.x + view[1][2] * p.y + view[2][2] * p.z + view[3][2]);
+}
+
+float Engine::ScreenSize(const AABB& bounds, float depth) const {
+    // Diameter times pixels per unit at depth 1, divided by depth in perspective
+    float pixels = 2.0f * bounds.Radius() * 0.5f * height * projection[1][1];
+    if (projMode == ProjectionMode::Perspective) {
+        pixels /= std::max(depth, zNear);
+    }
+    return pixels;
+}
+
+bool Engine::DrawnFromArray(const Texture2D* tex) const {
+    return tex && tex->GetArrayLayer() >= 0 && textureArrayEnabled && textureArray.IsBuilt() &&
+        instancingEnabled && instancer.IsSupported() && !softwareEnabled;
 }
 
+void Engine::SwitchTexture(Object3D* obj, int idx) {
+    obj->SetTexIndex(idx);
+    if (!obj->IsTextured()) {
+        std::cout << "Object " << selectedIndex
+            << ": now using texture #" << idx << "\n";
+        return;
+    }
+
+    // A hit if it can be drawn at full detail right away: from its array
+    // layer, or from streamed levels
+    const AABB& bounds = obj->GetWorldBounds();
+    float pixels = ScreenSize(bounds, ViewDepth(bounds.Center()));
+    Texture2D* tex = textures[idx].get();
+    bool resident = !tex->IsPending() &&
+        (DrawnFromArray(tex) || textureStreamer.IsResident(tex, pixels));
+    ++textureSwitches;
+    if (resident) {
+        missTexIndex = -1;
+    }
+    else {
+        ++textureSwitchMisses;
+        missTexIndex = idx;
+        missPixels = pixels;
+        missStart = std::chrono::steady_clock::now();
+    }
+    std::cout << "Object " << selectedIndex << ": now using texture #" << idx
+        << (resident ? " (resident, " : " (not resident, ") << textureSwitchMisses
+        << " of " << textureSwitches << " switches missed)\n";
+}
+
+void Engine::PrefetchNeighbourTextures() {
+    if (selectedIndex < 0 || selectedIndex >= (int)objects.size() || textures.size() < 2) {
+        return;
+    }
+    Object3D* obj = objects[selectedIndex];
+    if (!obj->IsTextured()) {
+        return;
+    }
+
+    const AABB& bounds = obj->GetWorldBounds();
+    float pixels = ScreenSize(bounds, ViewDepth(bounds.Center()));
+    int count = (int)textures.size();
+    int idx = obj->GetTexIndex() % count;
+    for (int next : { (idx + 1) % count, (idx - 1 + count) % count }) {
+        // Textures in the array are already there at full detail
+        Texture2D* tex = textures[next].get();
+        if (!DrawnFromArray(tex)) {
+            textureStreamer.Prefetch(tex, pixels);
+        }
+    }
+}
 
 //   Keyboard callback
 void Engine::Keyboard(unsigned char key, int, int) {
@@ -424,9 +884,7 @@ void Engine::Keyboard(unsigned char key, int, int) {
         if (selObj && !textures.empty()) {
             int idx = selObj->GetTexIndex();
             idx = (idx - 1 + (int)textures.size()) % (int)textures.size();
-            selObj->SetTexIndex(idx);
-            std::cout << "Object " << selectedIndex
-                << ": now using texture #" << idx << "\n";
+            SwitchTexture(selObj, idx);
         }
         break;
     }
@@ -435,9 +893,7 @@ void Engine::Keyboard(unsigned char key, int, int) {
         if (selObj && !textures.empty()) {
             int idx = selObj->GetTexIndex();
             idx = (idx + 1) % (int)textures.size();
-            selObj->SetTexIndex(idx);
-            std::cout << "Object " << selectedIndex
-                << ": now using texture #" << idx << "\n";
+            SwitchTexture(selObj, idx);
         }
         break;
     }
@@ -445,6 +901,33 @@ void Engine::Keyboard(unsigned char key, int, int) {
     case 'h':
         showHelp = !showHelp;
         break;
+    case 'I':
+    case 'i': // Toggle instanced rendering
+        instancingEnabled = !instancingEnabled;
+        std::cout << "Instanced rendering "
+            << (instancingEnabled && instancer.IsSupported() ? "ON\n" : "OFF\n");
+        break;
+    case 'B':
+    case 'b': // Toggle texture array batching
+        textureArrayEnabled = !textureArrayEnabled;
+        std::cout << "Texture array "
+            << (textureArrayEnabled && textureArray.IsBuilt() ? "ON\n" : "OFF\n");
+        break;
+    case 'U':
+    case 'u': // Toggle the software rasterizer
+        softwareEnabled = !softwareEnabled;
+        std::cout << "Software rasterizer " << (softwareEnabled ? "ON\n" : "OFF\n");
+        if (!softwareEnabled) {
+            softwareRasterizer.ReleaseTextures();
+        }
+        break;
+    case 'J':
+    case 'j': // Profile the next frames into a Chrome trace
+        if (!profiler.IsCapturing()) {
+            std::cout << "Profiling the next 120 frames...\n";
+            profiler.StartCapture(120, "frame_trace.json");
+        }
+        break;
     case '1': { // Add a new Cube at camTarget
         Cube* newCube = new Cube();
         newCube->SetPosition(camTarget);
@@ -466,6 +949,17 @@ void Engine::Keyboard(unsigned char key, int, int) {
         selectedIndex = (int)objects.size() - 1;
         break;
     }
+    case 127: { // (Delete) remove the selected object
+        if (selObj) {
+            // Mirror the store's swap-remove so objects stays in slot order
+            objects[selectedIndex] = objects.back();
+            objects.pop_back();
+            delete selObj;
+            selectedIndex = std::min(selectedIndex, (int)objects.size() - 1);
+            std::cout << "Selected object index = " << selectedIndex << "\n";
+        }
+        break;
+    }
     case '9': {
         if (selectedIndex >= 0 && selectedIndex < (int)objects.size()) {
             Object3D* selObj = objects[selectedIndex];
@@ -498,6 +992,12 @@ void Engine::Special(int key, int /*x*/, int /*y*/) {
     // How much we move per keypress
     const float moveStep = 0.1f;
 
+    if (key == GLUT_KEY_F3) { // Toggle the performance HUD
+        SetPerfHud(!showPerfHud);
+        glutPostRedisplay();
+        return;
+    }
+
     // If no object is selected, do nothing
     if (selectedIndex >= 0 && selectedIndex < (int)objects.size()) {
         // Get pointer to currently selected Object3D
@@ -538,6 +1038,22 @@ void Engine::Mouse(int button, int state, int x, int y) {
         rotating = (state == GLUT_DOWN);
         lastMouseX = x;
         lastMouseY = y;
+        if (state == GLUT_DOWN) {
+            pressMouseX = x;
+            pressMouseY = y;
+        }
+        // A click that didn't drag the camera selects what's under the cursor
+        else if (std::abs(x - pressMouseX) + std::abs(y - pressMouseY) <= 3) {
+            auto start = std::chrono::high_resolution_clock::now();
+            int picked = Pick(x, y);
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - start).count();
+            if (picked >= 0) {
+                selectedIndex = picked;
+                std::cout << "Selected object index = " << selectedIndex
+                    << " (picked in " << us << " us)\n";
+            }
+        }
     }
     else if (button == 3) { // scroll up
         camDist = std::max(0.5f, camDist - 0.5f);
@@ -549,6 +1065,36 @@ void Engine::Mouse(int button, int state, int x, int y) {
 }
 
 
+// Cast a ray from the camera through pixel (x, y) into the scene
+int Engine::Pick(int x, int y) {
+    // Picking can run before the next Display, so bring moved objects up to date
+    transforms.UpdateModelMatrices();
+
+    // GLUT's y runs down from the top, the viewport's runs up from the bottom
+    glm::vec4 viewport(0.0f, 0.0f, (float)width, (float)height);
+    float winX = (float)x + 0.5f;
+    float winY = (float)(height - y) - 0.5f;
+    glm::vec3 nearPt = glm::unProject(glm::vec3(winX, winY, 0.0f), view, projection, viewport);
+    glm::vec3 farPt = glm::unProject(glm::vec3(winX, winY, 1.0f), view, projection, viewport);
+
+    float t;
+    Object3D* hit = transforms.RayCast(nearPt, farPt - nearPt, t);
+    if (!hit || t > 1.0f) {
+        return -1;
+    }
+
+    // The hit's index in objects, not its store slot. The two agree while
+    // objects is kept in slot order (the usual case), so only scan for it
+    // when they don't
+    const size_t slot = hit->GetSlot();
+    if (slot < objects.size() && objects[slot] == hit) {
+        return (int)slot;
+    }
+    auto it = std::find(objects.begin(), objects.end(), hit);
+    return it != objects.end() ? (int)(it - objects.begin()) : -1;
+}
+
+
 //   Mouse motion callback (dragging to rotate camera)
 void Engine::Motion(int x, int y) {
     if (rotating) {
@@ -602,12 +1148,19 @@ void Engine::DrawHelpOverlay() {
         "L             - Toggle lighting on/off",
         "K             - Toggle shading on/off",
         "P / O         - Perspective / Orthographic projection",
+        "I             - Toggle instanced rendering",
+        "B             - Toggle texture array batching",
+        "U             - Toggle software rasterizer",
+        "J             - Profile 120 frames to frame_trace.json",
         "1             - Add Cube",
         "2             - Add Pyramid",
         "3             - Add Sphere",
+        "DEL           - Delete selected object",
+        "Mouse Click   - Select object under cursor",
         "Mouse Drag    - Rotate camera",
         "Mouse Wheel   - Zoom in/out",
         "H             - Toggle this help overlay",
+        "F3            - Toggle performance HUD",
         "===================================="
     };
     const int linesCount = sizeof(helpLines) / sizeof(helpLines[0]);
@@ -631,6 +1184,34 @@ void Engine::DrawHelpOverlay() {
 
 
 
+// Performance HUD in the top right corner, beside the help text
+void Engine::DrawPerfHud() {
+    FrameStats stats = GetFrameStats();
+    PerfHud::Counters counters;
+    counters.drawCalls = stats.drawCalls;
+    counters.stateChanges = stats.stateChanges;
+    counters.redundantStates = stats.redundantStates;
+    counters.visibleObjects = stats.visibleObjects;
+    counters.culledObjects = stats.culledObjects;
+    counters.textureBytes = textureCache.GetResidentBytes();
+    counters.arrayBytes = textureArray.GetByteSize();
+    counters.streamedBytes = textureStreamer.GetResidentBytes();
+    counters.streamBudget = textureStreamer.GetBudget();
+    if (softwareEnabled) {
+        counters.renderer = "Software rasterizer";
+    }
+    else if (instancingEnabled && instancer.IsSupported()) {
+        counters.renderer = textureArrayEnabled && textureArray.GetLayerCount() > 0
+            ? "GL instanced, texture array" : "GL instanced";
+    }
+    else {
+        counters.renderer = "GL per object";
+    }
+    perfHud.Draw(width, height, counters, profiler.GetPhaseTimings());
+}
+
+
+
 //instance‐side timer handler
 void Engine::OnTimer(int value) {
     glutPostRedisplay();
@@ -641,6 +1222,7 @@ void Engine::OnTimer(int value) {
 
 //   Static GLUT callback wrapper for timer
 void Engine::TimerCallback(int value) {
+    PROFILE_SCOPE("GLUT timer");
     // Call the renamed instance method
     instance->OnTimer(value);
 }
@@ -648,25 +1230,31 @@ void Engine::TimerCallback(int value) {
 
 //   Static GLUT callback wrappers for the rest
 void Engine::DisplayCallback() {
+    PROFILE_SCOPE("GLUT display");
     instance->Display();
 }
 
 void Engine::ReshapeCallback(int w, int h) {
+    PROFILE_SCOPE("GLUT reshape");
     instance->Reshape(w, h);
 }
 
 void Engine::KeyboardCallback(unsigned char k, int x, int y) {
+    PROFILE_SCOPE("GLUT keyboard");
     instance->Keyboard(k, x, y);
 }
 
 void Engine::SpecialCallback(int key, int x, int y) {
+    PROFILE_SCOPE("GLUT special");
     instance->Special(key, x, y);
 }
 
 void Engine::MouseCallback(int button, int state, int x, int y) {
+    PROFILE_SCOPE("GLUT mouse");
     instance->Mouse(button, state, x, y);
 }
 
 void Engine::MotionCallback(int x, int y) {
+    PROFILE_SCOPE("GLUT motion");
     instance->Motion(x, y);
 }
@@ -1,11 +1,30 @@
 ﻿// Engine.h
 #pragma once
 
+#include <chrono>
+#include <memory>
+#include <string>
 #include <vector>
 #include <glm/glm.hpp>
 #include "Texture2D.h"
+#include "MeshCache.h"
+#include "InstancedRenderer.h"
+#include "TransformStore.h"
+#include "Frustum.h"
+#include "RenderState.h"
+#include "RenderQueue.h"
+#include "TextureLoader.h"
+#include "TextureCache.h"
+#include "TextureStreamer.h"
+#include "TextureArray.h"
+#include "PixelUploadRing.h"
+#include "SoftwareRasterizer.h"
+#include "OffscreenContext.h"
+#include "Profiler.h"
+#include "PerfHud.h"
 
 class Object3D;
+class Mesh;
 
 class Engine {
 public:
@@ -18,10 +37,11 @@ public:
     // Initialize GLUT, OpenGL state, and create the first object
     void Init();
 
-    // Enter the GLUT main loop
+    // Enter the GLUT main loop (headless: draw the frames and return)
     void Run();
 
-    // Clean up (delete window, etc.)
+    // Clean up: free the GL objects, then delete the window or offscreen
+    // context they live in
     void Cleanup();
 
     // Configuration setters
@@ -30,6 +50,65 @@ public:
     void SetClearColor(float r, float g, float b);
     void SetFPS(int frames);
 
+    // Block compression for the textures loaded in Init (default: BC1 / BC3
+    // at normal quality). Falls back when the GPU lacks the format
+    void SetTextureCompression(BlockCompressor::Format format, BlockCompressor::Quality quality);
+
+    // Filter for the mip chains of the textures loaded in Init (default:
+    // box, not gamma-correct)
+    void SetTextureMipFilter(MipGenerator::Filter filter, bool gammaCorrect);
+
+    // GPU memory the textures' streamed mip levels may use together
+    void SetTextureBudget(size_t bytes);
+
+    // Render `frames` frames into an offscreen framebuffer instead of opening
+    // a window, so no display is needed; Run draws them and returns, saving
+    // the last one to imagePath (binary PPM) when given. Call before Init
+    void SetHeadless(int frames, const char* imagePath = nullptr);
+
+    // Start on the software rasterizer instead of GL (U toggles it)
+    void SetSoftwareRendering(bool value);
+
+    // Instanced draws when the GPU supports them, else per object (I)
+    void SetInstancedRendering(bool value);
+
+    // Show the performance HUD (F3 toggles it); also turns on the
+    // profiler's live per-phase timings it displays
+    void SetPerfHud(bool value);
+
+    // Scene access for code driving the engine without GLUT (benchmarks,
+    // headless tools). AddObject takes ownership; objects must be created
+    // after Init, which sets up their store and meshes
+    void AddObject(Object3D* obj);
+    void ClearObjects();
+    size_t GetObjectCount() const { return objects.size(); }
+
+    // Orbit camera: yaw / pitch in radians around target, at distance
+    void SetCamera(float yaw, float pitch, float distance, const glm::vec3& target);
+
+    // Finish decoding and uploading every texture now instead of a few per
+    // frame, then build the texture array
+    void LoadAllTextures();
+
+    // Draw one frame, as the GLUT display callback does
+    void RenderFrame();
+
+    // Counters from the last frame drawn
+    struct FrameStats {
+        int drawCalls;
+        int stateChanges;       // texture / polygon mode / line width calls made
+        int redundantStates;    // and skipped as already current
+        size_t visibleObjects;
+        size_t culledObjects;
+    };
+    FrameStats GetFrameStats() const;
+
+    // Time `frames` frames of a generated 500-object scene with each
+    // renderer (GL instanced, GL fixed-function, software) and print their
+    // frames per second. Call after Init; frame times include the buffer
+    // swap, so GL numbers are only meaningful with vsync off
+    void BenchmarkRenderers(int frames);
+
     // Projection mode setters
     void SetPerspective(float fovDeg, float zn, float zf);
     void SetOrtho(float left, float right, float bottom, float top, float zn, float zf);
@@ -43,14 +122,30 @@ public:
     static void MotionCallback(int x, int y);
     static void TimerCallback(int value);
 
-    // Collection of textures to load multiple at startup
-    std::vector<Texture2D*> textures;
+    // Textures cycled with R / Y, shared through textureCache (a file
+    // listed twice occupies two slots but one GPU texture)
+    std::vector<std::shared_ptr<Texture2D>> textures;
+
+    // Small checkerboard drawn on textured objects until their texture
+    // finishes loading
+    Texture2D* placeholderTexture;
+
+    // Shared GPU meshes for the built-in primitives, uploaded once in Init
+    Mesh* cubeMesh;
+    Mesh* pyramidMesh;
+
+    // Reference-counted sphere tessellations, keyed by (slices, stacks)
+    MeshCache meshCache;
 
 private:
     // Disallow copying
     Engine(const Engine&) = delete;
     Engine& operator=(const Engine&) = delete;
 
+    // Textures, meshes and the renderers' GL objects; Cleanup calls it
+    // before the context goes
+    void DeleteGLObjects();
+
     // Internal handlers for each callback
     void Display();
     void Reshape(int w, int h);
@@ -62,12 +157,57 @@ private:
 
     void DrawHelpOverlay();
 
+    // Fill in the HUD's counters for this frame and draw it
+    void DrawPerfHud();
+
+    // Run for headless mode: the requested frames, timed, then the image
+    void RunHeadless();
+
+    // Select the nearest object under window pixel (x, y); returns its index
+    // in objects or -1 when the ray misses everything
+    int Pick(int x, int y);
+
+    // View depth of a world-space point, from this frame's camera
+    float ViewDepth(const glm::vec3& p) const;
+
+    // About how many pixels across bounds cover on screen at view depth
+    // depth; what the texture streamer sizes mip levels by
+    float ScreenSize(const AABB& bounds, float depth) const;
+
+    // True if tex is sampled from its texture array layer on the current
+    // render path; its own 2D mip levels then needn't be streamed in
+    bool DrawnFromArray(const Texture2D* tex) const;
+
+    // Give obj texture idx (R / Y), counting the switch as a miss when the
+    // texture isn't yet resident at the detail obj needs on screen
+    void SwitchTexture(Object3D* obj, int idx);
+
+    // Ask the streamer to warm the textures R / Y would give the selected
+    // object next, at the size it is drawn
+    void PrefetchNeighbourTextures();
+
     // Window / context state
     int width, height;
     bool fullscreen;
     int window;       // GLUT window handle
+    int argCount;     // command line for glutInit
+    char** argValues;
     bool showHelp;
 
+    // Headless mode: an offscreen context replaces GLUT and its window
+    OffscreenContext offscreen;
+    bool headless;
+    int headlessFrames;
+    std::string headlessImage;
+
+    // CPU / GPU scope recorder, captured to a Chrome trace on demand (J or
+    // ENGINE_PROFILE). Declared before the loader so its workers stop first
+    Profiler profiler;
+
+    // Frame time graph, counters and phase timings (F3)
+    PerfHud perfHud;
+    bool showPerfHud;
+
     // Timing
     int fps;
 
@@ -79,21 +219,83 @@ private:
     ProjectionMode projMode;
     float fov, zNear, zFar;
     float orthoLeft, orthoRight, orthoBottom, orthoTop;
+    glm::mat4 projection;      // current projection, rebuilt in Reshape
+    glm::mat4 view;            // current camera matrix, rebuilt in Display
 
     // Camera controls
     float angleY, angleX;      // rotation around Y and X axes
     float camDist;             // distance from camera to camTarget
     glm::vec3 camTarget;       // point the camera looks at
     int lastMouseX, lastMouseY;
+    int pressMouseX, pressMouseY;  // where the left button went down
     bool rotating;
 
     // Lighting / shading toggles
     bool lightingEnabled;
     bool shadingEnabled;
 
-    // Scene graph: a list of Object3D pointers
+    // Requested texture compression and mip filter, applied to textureLoader in Init
+    BlockCompressor::Format textureFormat;
+    BlockCompressor::Quality textureQuality;
+    MipGenerator::Filter textureMipFilter;
+    bool gammaCorrectMips;
+
+    // Decodes textures on worker threads; finished ones are uploaded in Display
+    TextureLoader textureLoader;
+
+    // Path / content-hash keyed handles on top of textureLoader
+    TextureCache textureCache;
+
+    // Keeps small mips of every texture resident and streams the larger
+    // ones in for visible objects, within a memory budget
+    TextureStreamer textureStreamer;
+
+    // Pixel-unpack staging buffer every texture upload goes through
+    PixelUploadRing uploadRing;
+
+    // Cached texture / polygon mode / line width; skips redundant GL calls
+    RenderState renderState;
+
+    // Instanced rendering: one draw per (mesh, texture) group
+    InstancedRenderer instancer;
+    bool instancingEnabled;
+
+    // CPU renderer used instead of GL while softwareEnabled
+    SoftwareRasterizer softwareRasterizer;
+    bool softwareEnabled;
+
+    // Layered copy of the textures, built once they have all loaded. While
+    // enabled, instanced draws pick textures by layer, one group per mesh
+    TextureArray textureArray;
+    bool textureArrayEnabled;
+
+    // Transform, flag and texture-index data for every object (SoA)
+    TransformStore transforms;
+
+    // Scene graph: a list of Object3D handles into transforms. Kept in slot
+    // order (objects[i]->GetSlot() == i), so removals must swap with the back
     std::vector<Object3D*> objects;
 
+    // Frustum culling: objects that survived this frame's cull
+    Frustum frustum;
+    std::vector<Object3D*> visibleObjects;
+    size_t culledCount;
+
+    // Visible objects as sort keys, drawn grouped by mesh/texture and front-to-back
+    RenderQueue renderQueue;
+
     // Index of the currently selected object in objects (−1 if none)
     int selectedIndex;
+
+    // Texture switches on textured objects, and those that found the new
+    // texture still loading or short of mip levels (drawn blurry meanwhile)
+    size_t textureSwitches;
+    size_t textureSwitchMisses;
+
+    // The last missed switch until its texture is fully in (-1: none), and
+    // the time all missed switches have waited so far
+    int missTexIndex;
+    float missPixels;
+    std::chrono::steady_clock::time_point missStart;
+    double missWaitMs;
 };
@@ -0,0 +1,46 @@
+// Frustum.cpp
+#include "Frustum.h"
+#include <cmath>
+
+void Frustum::Extract(const glm::mat4& m)
+{
+    // Gribb/Hartmann: each plane is row 3 +/- row 0..2 of the clip matrix
+    // (glm is column-major, so row r is m[0][r], m[1][r], m[2][r], m[3][r])
+    for (int i = 0; i < 3; ++i) {
+        glm::vec4 row(m[0][i], m[1][i], m[2][i], m[3][i]);
+        glm::vec4 w(m[0][3], m[1][3], m[2][3], m[3][3]);
+        planes[i * 2 + 0] = w + row;
+        planes[i * 2 + 1] = w - row;
+    }
+
+    for (glm::vec4& p : planes) {
+        float len = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+        if (len > 0.0f) {
+            p /= len;
+        }
+    }
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3& center, float radius) const
+{
+    for (const glm::vec4& p : planes) {
+        if (p.x * center.x + p.y * center.y + p.z * center.z + p.w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::IntersectsAABB(const AABB& box) const
+{
+    for (const glm::vec4& p : planes) {
+        // Corner furthest along the plane normal
+        glm::vec3 v(p.x >= 0.0f ? box.max.x : box.min.x,
+            p.y >= 0.0f ? box.max.y : box.min.y,
+            p.z >= 0.0f ? box.max.z : box.min.z);
+        if (p.x * v.x + p.y * v.y + p.z * v.z + p.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
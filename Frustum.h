@@ -0,0 +1,20 @@
+// Frustum.h
+#pragma once
+#include <glm/glm.hpp>
+#include "Bounds.h"
+
+class Frustum {
+public:
+    // Extract the six planes from projection * view. Works for both
+    // perspective and orthographic projections
+    void Extract(const glm::mat4& viewProj);
+
+    // Conservative tests: false only if the volume is fully outside
+    bool IntersectsSphere(const glm::vec3& center, float radius) const;
+    bool IntersectsAABB(const AABB& box) const;
+
+private:
+    // Planes as (normal, d) with normals pointing inward:
+    // left, right, bottom, top, near, far
+    glm::vec4 planes[6];
+};
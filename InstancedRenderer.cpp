@@ -0,0 +1,327 @@
+// InstancedRenderer.cpp
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+#include <glm/gtc/type_ptr.hpp>
+#include "InstancedRenderer.h"
+#include "Object3D.h"
+#include "Texture2D.h"
+#include "TextureArray.h"
+#include "Mesh.h"
+#include "Profiler.h"
+#include "RenderQueue.h"
+#include "RenderState.h"
+#include <cstddef>
+#include <iostream>
+
+// First generic attribute slot of the per-instance model matrix (4 columns),
+// and the slot of the per-instance texture array layer. Many drivers alias
+// the built-in inputs onto generic slots (0 vertex, 2 normal, 3 color,
+// 8.. texture coordinates), so both stay on slots the shader's built-ins
+// don't use: 1 is the vertex weight, 4 and 5 secondary color and fog, 6
+// and 7 have no built-in
+static const GLuint kInstanceAttrib = 4;
+static const GLuint kLayerAttrib = 1;
+
+// Texture unit of the array; sampler2D and sampler2DArray may not share one
+static const int kArrayUnit = 1;
+
+// Values of the texturing uniform
+enum Texturing { TexturingOff = 0, TexturingTexture = 1, TexturingArray = 2 };
+
+// Put before both shaders. TEXTURE_ARRAY is defined when the GL can sample
+// texture arrays, so the shader still compiles where it can't
+static const char* kVersionSrc = "#version 120\n";
+static const char* kArraySrc = "#extension GL_EXT_texture_array : enable\n#define TEXTURE_ARRAY 1\n";
+
+// Reproduces the fixed-function state the engine sets up in Init: LIGHT0
+// as a point light, GL_COLOR_MATERIAL on ambient & diffuse, per-vertex
+// lighting (so glShadeModel still applies) and GL_MODULATE texturing
+static const char* kVertexSrc = R"(
+attribute mat4 instanceModel;
+attribute float instanceLayer;
+uniform bool lighting;
+varying float layer;
+
+void main() {
+    vec4 eyePos = gl_ModelViewMatrix * (instanceModel * gl_Vertex);
+    gl_Position = gl_ProjectionMatrix * eyePos;
+    gl_TexCoord[0] = gl_MultiTexCoord0;
+    layer = instanceLayer;
+
+    if (!lighting) {
+        gl_FrontColor = gl_Color;
+        gl_BackColor = gl_Color;
+        return;
+    }
+
+    mat3 normalMat = mat3(gl_ModelViewMatrix) * mat3(instanceModel);
+    vec3 n = normalize(normalMat * gl_Normal);
+    vec4 lp = gl_LightSource[0].position;
+    vec3 l = normalize(lp.w == 0.0 ? lp.xyz : lp.xyz - eyePos.xyz);
+
+    vec4 ambient = gl_Color * (gl_LightModel.ambient + gl_LightSource[0].ambient);
+    vec4 front = ambient + gl_Color * gl_LightSource[0].diffuse * max(dot(n, l), 0.0);
+    vec4 back = ambient + gl_Color * gl_LightSource[0].diffuse * max(dot(-n, l), 0.0);
+    gl_FrontColor = vec4(front.rgb, gl_Color.a);
+    gl_BackColor = vec4(back.rgb, gl_Color.a);
+}
+)";
+
+static const char* kFragmentSrc = R"(
+uniform int texturing;
+uniform sampler2D tex;
+#ifdef TEXTURE_ARRAY
+uniform sampler2DArray texArray;
+#endif
+varying float layer;
+
+void main() {
+    vec4 color = gl_Color;
+    if (texturing == 1) {
+        color *= texture2D(tex, gl_TexCoord[0].st);
+    }
+#ifdef TEXTURE_ARRAY
+    else if (texturing == 2) {
+        color *= texture2DArray(texArray, vec3(gl_TexCoord[0].st, floor(layer + 0.5)));
+    }
+#endif
+    gl_FragColor = color;
+}
+)";
+
+static GLuint CompileShader(GLenum type, const char* src, bool textureArrays)
+{
+    const char* sources[] = { kVersionSrc, textureArrays ? kArraySrc : "", src };
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 3, sources, nullptr);
+    glCompileShader(shader);
+
+    GLint ok = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::cerr << "Instancing shader failed to compile:\n" << log << "\n";
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+void InstancedRenderer::Init()
+{
+    if (!GLEW_VERSION_2_0 || !GLEW_ARB_instanced_arrays || !GLEW_ARB_draw_instanced) {
+        std::cerr << "Instanced rendering not supported, using per-object draws\n";
+        return;
+    }
+
+    const bool textureArrays = GLEW_VERSION_3_0 || GLEW_EXT_texture_array;
+    GLuint vs = CompileShader(GL_VERTEX_SHADER, kVertexSrc, textureArrays);
+    GLuint fs = CompileShader(GL_FRAGMENT_SHADER, kFragmentSrc, textureArrays);
+    if (vs == 0 || fs == 0) {
+        if (vs) glDeleteShader(vs);
+        if (fs) glDeleteShader(fs);
+        return;
+    }
+
+    program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glBindAttribLocation(program, kInstanceAttrib, "instanceModel");
+    glBindAttribLocation(program, kLayerAttrib, "instanceLayer");
+    glLinkProgram(program);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    GLint ok = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        char log[1024];
+        glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+        std::cerr << "Instancing shader failed to link:\n" << log << "\n";
+        glDeleteProgram(program);
+        program = 0;
+        return;
+    }
+
+    uTexturing = glGetUniformLocation(program, "texturing");
+    uLighting = glGetUniformLocation(program, "lighting");
+    uSampler = glGetUniformLocation(program, "tex");
+    uArraySampler = glGetUniformLocation(program, "texArray");
+
+    glGenBuffers(1, &instanceVBO);
+}
+
+void InstancedRenderer::Delete()
+{
+    if (program != 0) {
+        glDeleteProgram(program);
+        program = 0;
+    }
+    if (instanceVBO != 0) {
+        glDeleteBuffers(1, &instanceVBO);
+        instanceVBO = 0;
+    }
+    instanceCapacity = 0;
+}
+
+void InstancedRenderer::AddInstances(const RenderQueue& queue, size_t first, size_t count, float layer)
+{
+    for (size_t i = first; i < first + count; ++i) {
+        instances.push_back({ queue.GetObject(i)->GetModelMatrix(), layer });
+    }
+}
+
+void InstancedRenderer::BindInstances(size_t first) const
+{
+    const size_t base = first * sizeof(Instance);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    for (GLuint col = 0; col < 4; ++col) {
+        glEnableVertexAttribArray(kInstanceAttrib + col);
+        glVertexAttribPointer(kInstanceAttrib + col, 4, GL_FLOAT, GL_FALSE, sizeof(Instance),
+            (const void*)(base + col * sizeof(glm::vec4)));
+        glVertexAttribDivisorARB(kInstanceAttrib + col, 1);
+    }
+    glEnableVertexAttribArray(kLayerAttrib);
+    glVertexAttribPointer(kLayerAttrib, 1, GL_FLOAT, GL_FALSE, sizeof(Instance),
+        (const void*)(base + offsetof(Instance, layer)));
+    glVertexAttribDivisorARB(kLayerAttrib, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void InstancedRenderer::UnbindInstances()
+{
+    const GLuint attribs[] = { kInstanceAttrib, kInstanceAttrib + 1, kInstanceAttrib + 2,
+        kInstanceAttrib + 3, kLayerAttrib };
+    for (GLuint attrib : attribs) {
+        glVertexAttribDivisorARB(attrib, 0);
+        glDisableVertexAttribArray(attrib);
+    }
+}
+
+void InstancedRenderer::Render(const RenderQueue& queue, bool lighting, const TextureArray* array)
+{
+    PROFILE_SCOPE("InstancedRenderer::Render");
+    PROFILE_GPU_SCOPE("Instanced draws");
+    drawCalls = 0;
+    if (!IsSupported()) {
+        return;
+    }
+    const bool useArray = array && array->IsBuilt() && uArraySampler >= 0;
+
+    // Flatten the sorted runs into one contiguous instance array. Runs of a
+    // mesh are adjacent; with the array, those it covers become one group
+    // ahead of the mesh's remaining runs
+    instances.clear();
+    groups.clear();
+    const std::vector<RenderQueue::Run>& runs = queue.GetRuns();
+    for (size_t begin = 0; begin < runs.size();) {
+        Mesh* mesh = runs[begin].mesh;
+        size_t end = begin + 1;
+        while (end < runs.size() && runs[end].mesh == mesh && runs[end].pass == runs[begin].pass) {
+            ++end;
+        }
+
+        if (useArray) {
+            size_t first = instances.size();
+            for (size_t r = begin; r < end; ++r) {
+                const RenderQueue::Run& run = runs[r];
+                if (run.texture && run.texture->GetArrayLayer() >= 0) {
+                    AddInstances(queue, run.first, run.count, (float)run.texture->GetArrayLayer());
+                }
+            }
+            if (instances.size() > first) {
+                groups.push_back({ mesh, 0u, true, first, instances.size() - first });
+            }
+        }
+        for (size_t r = begin; r < end; ++r) {
+            const RenderQueue::Run& run = runs[r];
+            if (useArray && run.texture && run.texture->GetArrayLayer() >= 0) {
+                continue;
+            }
+            groups.push_back({ mesh, run.texture ? run.texture->GetID() : 0u, false,
+                               instances.size(), run.count });
+            AddInstances(queue, run.first, run.count, 0.0f);
+        }
+        begin = end;
+    }
+    if (instances.empty()) {
+        return;
+    }
+
+    // Single upload per frame into fresh storage: orphaning every frame
+    // lets the driver keep the old storage for last frame's draws instead
+    // of waiting for them to finish reading it
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    if (instances.size() > instanceCapacity) {
+        instanceCapacity = instances.size() * 2;
+    }
+    glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(Instance), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(Instance), instances.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glUseProgram(program);
+    glUniform1i(uSampler, 0);
+    glUniform1i(uLighting, lighting ? 1 : 0);
+    if (uArraySampler >= 0) {
+        // Even unused, it must not point at unit 0 along with tex
+        glUniform1i(uArraySampler, kArrayUnit);
+    }
+    if (useArray) {
+        array->Bind(kArrayUnit);
+    }
+    glEnable(GL_TEXTURE_2D);
+    RenderState* state = RenderState::instance;
+    state->SetPolygonMode(GL_FILL);
+
+    const Mesh* boundMesh = nullptr;
+    for (const Group& g : groups) {
+        // Runs are sorted by mesh, so each mesh is bound once
+        if (g.mesh != boundMesh) {
+            g.mesh->Bind();
+            boundMesh = g.mesh;
+        }
+        BindInstances(g.first);
+
+        // Filled pass (textured if the group has a texture or array layers,
+        // else flat white). Array groups leave the bound texture alone
+        if (g.arrayTextured) {
+            glUniform1i(uTexturing, TexturingArray);
+        }
+        else {
+            state->BindTexture(g.texture);
+            glUniform1i(uTexturing, g.texture != 0 ? TexturingTexture : TexturingOff);
+        }
+        glColor3f(1.0f, 1.0f, 1.0f);
+        glDrawElementsInstancedARB(GL_TRIANGLES, g.mesh->GetTriangleIndexCount(),
+            GL_UNSIGNED_INT, (const void*)0, (GLsizei)g.count);
+        ++drawCalls;
+        state->CountDraw();
+
+        // Thin black wireframe pass. The shader ignores the sampler when
+        // untextured, so the texture stays bound for the next group
+        if (g.mesh->GetEdgeIndexCount() > 0) {
+            glUniform1i(uTexturing, TexturingOff);
+            state->SetLineWidth(1.0f);
+            glColor3f(0.0f, 0.0f, 0.0f);
+            glDrawElementsInstancedARB(GL_LINES, g.mesh->GetEdgeIndexCount(), GL_UNSIGNED_INT,
+                (const void*)(g.mesh->GetTriangleIndexCount() * sizeof(GLuint)), (GLsizei)g.count);
+            ++drawCalls;
+            state->CountDraw();
+        }
+
+        UnbindInstances();
+    }
+
+    Mesh::Unbind();
+    Texture2D::Unbind();
+    if (useArray) {
+        TextureArray::Unbind(kArrayUnit);
+    }
+    glUseProgram(0);
+
+    // Thick orange outline for the selected object over its black edges
+    if (Object3D* selected = queue.GetSelected()) {
+        selected->DrawOutline();
+    }
+}
@@ -0,0 +1,67 @@
+// InstancedRenderer.h
+#pragma once
+#include <GL/freeglut.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+class Mesh;
+class RenderQueue;
+class TextureArray;
+
+class InstancedRenderer {
+public:
+    // Compile the instancing shader and create the per-instance buffer.
+    // Needs a current GL context; leaves IsSupported() false on failure
+    void Init();
+
+    // Delete the GL program and buffer
+    void Delete();
+
+    // True once Init succeeded on a driver with instanced arrays
+    bool IsSupported() const { return program != 0; }
+
+    // Draw a sorted queue, one instanced call per (mesh, texture) run for
+    // the filled pass and one for the wireframe pass. Instances keep the
+    // queue's front-to-back order. The selected object's outline goes on top.
+    // With a built texture array, all runs of a mesh whose textures have a
+    // layer in it merge into one group that samples the array by layer
+    void Render(const RenderQueue& queue, bool lighting, const TextureArray* array = nullptr);
+
+    // Number of instanced draw calls issued by the last Render
+    int GetDrawCalls() const { return drawCalls; }
+
+private:
+    // Per-instance vertex data
+    struct Instance {
+        glm::mat4 model;
+        float     layer;    // texture array layer (unused outside array groups)
+    };
+
+    struct Group {
+        Mesh* mesh;
+        GLuint texture;
+        bool  arrayTextured;    // samples the texture array instead of texture
+        size_t first;   // offset into the instance buffer, in instances
+        size_t count;
+    };
+
+    // Append the instances of queue's sorted draws [first, first + count)
+    void AddInstances(const RenderQueue& queue, size_t first, size_t count, float layer);
+
+    // Point the per-instance attributes at a group's slice of the buffer
+    void BindInstances(size_t first) const;
+    static void UnbindInstances();
+
+    GLuint program = 0;
+    GLuint instanceVBO = 0;
+    size_t instanceCapacity = 0;
+    GLint  uTexturing = -1;
+    GLint  uLighting = -1;
+    GLint  uSampler = -1;
+    GLint  uArraySampler = -1;  // -1 when the GL has no texture arrays
+
+    // Reused between frames to avoid reallocating
+    std::vector<Instance> instances;
+    std::vector<Group> groups;
+    int drawCalls = 0;
+};
@@ -0,0 +1,92 @@
+// MappedFile.cpp
+#include "MappedFile.h"
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+    HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (f == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER len;
+    if (!GetFileSizeEx(f, &len) || len.QuadPart == 0) {
+        CloseHandle(f);
+        return false;
+    }
+    HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m) {
+        CloseHandle(f);
+        return false;
+    }
+    void* view = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(m);
+        CloseHandle(f);
+        return false;
+    }
+    file = f;
+    mapping = m;
+    data = static_cast<const unsigned char*>(view);
+    size = (size_t)len.QuadPart;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data) UnmapViewOfFile(data);
+    if (mapping) CloseHandle(mapping);
+    if (file) CloseHandle(file);
+    data = nullptr;
+    mapping = nullptr;
+    file = nullptr;
+    size = 0;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& path)
+{
+    Close();
+    int f = open(path.c_str(), O_RDONLY);
+    if (f < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(f, &st) != 0 || st.st_size == 0) {
+        close(f);
+        return false;
+    }
+    void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, f, 0);
+    if (view == MAP_FAILED) {
+        close(f);
+        return false;
+    }
+    fd = f;
+    data = static_cast<const unsigned char*>(view);
+    size = (size_t)st.st_size;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (data) munmap(const_cast<unsigned char*>(data), size);
+    if (fd >= 0) close(fd);
+    data = nullptr;
+    fd = -1;
+    size = 0;
+}
+
+#endif
@@ -0,0 +1,31 @@
+// MappedFile.h
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    // Map path; returns false (and stays closed) if it can't be opened
+    bool Open(const std::string& path);
+    void Close();
+
+    const unsigned char* GetData() const { return data; }
+    size_t GetSize() const { return size; }
+
+private:
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* file = nullptr;      // HANDLE
+    void* mapping = nullptr;   // HANDLE
+#else
+    int fd = -1;
+#endif
+};
@@ -0,0 +1,255 @@
+// Mesh.cpp
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+#include "Mesh.h"
+#include "RenderState.h"
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+
+Mesh::Mesh(const std::vector<Vertex>& vertices,
+    const std::vector<GLuint>& triangles,
+    const std::vector<GLuint>& edges)
+{
+    if (vertices.empty() || triangles.empty()) {
+        std::cerr << "Refusing to create an empty mesh\n";
+        return; // ids remain 0
+    }
+
+    triCount = (GLsizei)triangles.size();
+    edgeCount = (GLsizei)edges.size();
+
+    // Both index lists live in one element buffer: triangles first, edges
+    // after. The CPU keeps a copy of everything
+    this->vertices = vertices;
+    indices = triangles;
+    indices.insert(indices.end(), edges.begin(), edges.end());
+
+    // A VAO captures the array pointers so Bind() is a single call
+    if (GLEW_ARB_vertex_array_object) {
+        glGenVertexArrays(1, &vao);
+        glBindVertexArray(vao);
+    }
+
+    glGenBuffers(1, &vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex),
+        vertices.data(), GL_STATIC_DRAW);
+
+    glGenBuffers(1, &ibo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint),
+        indices.data(), GL_STATIC_DRAW);
+
+    if (vao != 0) {
+        SetupArrays();
+        glBindVertexArray(0);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+void Mesh::SetupArrays() const
+{
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, sizeof(Vertex), (const void*)offsetof(Vertex, position));
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glNormalPointer(GL_FLOAT, sizeof(Vertex), (const void*)offsetof(Vertex, normal));
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), (const void*)offsetof(Vertex, uv));
+}
+
+void Mesh::Bind() const
+{
+    if (vao != 0) {
+        glBindVertexArray(vao);
+    }
+    else {
+        SetupArrays();
+    }
+}
+
+void Mesh::Unbind()
+{
+    if (GLEW_ARB_vertex_array_object) {
+        glBindVertexArray(0);
+    }
+    else {
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glDisableClientState(GL_NORMAL_ARRAY);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Mesh::DrawFill() const
+{
+    glDrawElements(GL_TRIANGLES, triCount, GL_UNSIGNED_INT, (const void*)0);
+    if (RenderState::instance) RenderState::instance->CountDraw();
+}
+
+void Mesh::DrawEdges() const
+{
+    if (edgeCount == 0) return;
+    glDrawElements(GL_LINES, edgeCount, GL_UNSIGNED_INT,
+        (const void*)(triCount * sizeof(GLuint)));
+    if (RenderState::instance) RenderState::instance->CountDraw();
+}
+
+void Mesh::Delete()
+{
+    if (vao != 0) {
+        glDeleteVertexArrays(1, &vao);
+        vao = 0;
+    }
+    if (vbo != 0) {
+        glDeleteBuffers(1, &vbo);
+        vbo = 0;
+    }
+    if (ibo != 0) {
+        glDeleteBuffers(1, &ibo);
+        ibo = 0;
+    }
+    triCount = edgeCount = 0;
+    vertices.clear();
+    indices.clear();
+}
+
+
+//   Built-in primitives
+Mesh* Mesh::CreateCube()
+{
+    static const glm::vec3 corners[8] = {
+        {-0.5f,-0.5f,-0.5f},{ 0.5f,-0.5f,-0.5f},
+        { 0.5f, 0.5f,-0.5f},{-0.5f, 0.5f,-0.5f},
+        {-0.5f,-0.5f, 0.5f},{ 0.5f,-0.5f, 0.5f},
+        { 0.5f, 0.5f, 0.5f},{-0.5f, 0.5f, 0.5f}
+    };
+    static const int faces[6][4] = {
+        {0,1,2,3},{4,5,6,7},
+        {0,1,5,4},{2,3,7,6},
+        {0,3,7,4},{1,2,6,5}
+    };
+    static const glm::vec3 norms[6] = {
+        { 0,  0, -1},{ 0,  0,  1},
+        { 0, -1,  0},{ 0,  1,  0},
+        {-1,  0,  0},{ 1,  0,  0}
+    };
+    static const glm::vec2 texCoords[4] = {
+        {0.0f, 0.0f},{1.0f, 0.0f},{1.0f, 1.0f},{0.0f, 1.0f}
+    };
+
+    // Four vertices per face so every face gets its own normal and UVs
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> triangles;
+    std::vector<GLuint> edges;
+    for (int i = 0; i < 6; ++i) {
+        GLuint base = (GLuint)vertices.size();
+        for (int j = 0; j < 4; ++j) {
+            vertices.push_back({ corners[faces[i][j]], norms[i], texCoords[j] });
+        }
+        triangles.insert(triangles.end(), { base, base + 1, base + 2, base, base + 2, base + 3 });
+        edges.insert(edges.end(), { base, base + 1, base + 1, base + 2,
+                                    base + 2, base + 3, base + 3, base });
+    }
+    return new Mesh(vertices, triangles, edges);
+}
+
+Mesh* Mesh::CreatePyramid()
+{
+    const glm::vec3 apex(0.0f, 0.5f, 0.0f);
+    const glm::vec3 base[4] = {
+        {-0.5f, -0.5f,  0.5f},{ 0.5f, -0.5f,  0.5f},
+        { 0.5f, -0.5f, -0.5f},{-0.5f, -0.5f, -0.5f}
+    };
+    // Front, right, back, left side normals
+    const glm::vec3 sideNorms[4] = {
+        { 0.0f,    0.4472f,  0.8944f},{ 0.8944f, 0.4472f,  0.0f},
+        { 0.0f,    0.4472f, -0.8944f},{-0.8944f, 0.4472f,  0.0f}
+    };
+
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> triangles;
+    std::vector<GLuint> edges;
+
+    // Triangular sides
+    for (int i = 0; i < 4; ++i) {
+        GLuint first = (GLuint)vertices.size();
+        vertices.push_back({ apex,              sideNorms[i], {0.5f, 1.0f} });
+        vertices.push_back({ base[i],           sideNorms[i], {0.0f, 0.0f} });
+        vertices.push_back({ base[(i + 1) % 4], sideNorms[i], {1.0f, 0.0f} });
+        triangles.insert(triangles.end(), { first, first + 1, first + 2 });
+        edges.insert(edges.end(), { first, first + 1, first + 1, first + 2, first + 2, first });
+    }
+
+    // Square base
+    const glm::vec2 baseUV[4] = { {0.0f, 0.0f},{1.0f, 0.0f},{1.0f, 1.0f},{0.0f, 1.0f} };
+    GLuint first = (GLuint)vertices.size();
+    for (int i = 0; i < 4; ++i) {
+        vertices.push_back({ base[i], glm::vec3(0.0f, -1.0f, 0.0f), baseUV[i] });
+    }
+    triangles.insert(triangles.end(), { first, first + 1, first + 2, first, first + 2, first + 3 });
+    edges.insert(edges.end(), { first, first + 1, first + 1, first + 2,
+                                first + 2, first + 3, first + 3, first });
+
+    return new Mesh(vertices, triangles, edges);
+}
+
+Mesh* Mesh::CreateSphere(int slices, int stacks)
+{
+    if (slices < 3) slices = 3;
+    if (stacks < 2) stacks = 2;
+
+    const float radius = 0.5f;
+    const float pi = 3.14159265358979f;
+
+    // Same parameterization as gluSphere: poles on the Z axis, s around,
+    // t from the -Z pole (0) to the +Z pole (1)
+    std::vector<Vertex> vertices;
+    vertices.reserve((slices + 1) * (stacks + 1));
+    for (int i = 0; i <= stacks; ++i) {
+        float rho = pi * i / stacks;
+        for (int j = 0; j <= slices; ++j) {
+            float theta = (j == slices) ? 0.0f : 2.0f * pi * j / slices;
+            glm::vec3 n(-std::sin(theta) * std::sin(rho),
+                std::cos(theta) * std::sin(rho),
+                std::cos(rho));
+            vertices.push_back({ n * radius, n,
+                glm::vec2((float)j / slices, 1.0f - (float)i / stacks) });
+        }
+    }
+
+    std::vector<GLuint> triangles;
+    triangles.reserve(slices * stacks * 6);
+    for (int i = 0; i < stacks; ++i) {
+        for (int j = 0; j < slices; ++j) {
+            GLuint a = i * (slices + 1) + j;
+            GLuint b = a + slices + 1;
+            triangles.insert(triangles.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+    }
+
+    // Outline on every other ring and meridian, matching the density of
+    // the old glutWireSphere(0.5, 16, 16) overlay
+    std::vector<GLuint> edges;
+    const int step = (slices >= 8 && stacks >= 8) ? 2 : 1;
+    for (int i = step; i < stacks; i += step) {       // rings
+        for (int j = 0; j < slices; ++j) {
+            GLuint a = i * (slices + 1) + j;
+            edges.insert(edges.end(), { a, a + 1 });
+        }
+    }
+    for (int j = 0; j < slices; j += step) {          // meridians
+        for (int i = 0; i < stacks; ++i) {
+            GLuint a = i * (slices + 1) + j;
+            edges.insert(edges.end(), { a, a + slices + 1 });
+        }
+    }
+
+    return new Mesh(vertices, triangles, edges);
+}
@@ -0,0 +1,63 @@
+// Mesh.h
+#pragma once
+#include <GL/freeglut.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+class Mesh {
+public:
+    // Interleaved vertex layout stored in the vertex buffer
+    struct Vertex {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 uv;
+    };
+
+    // Upload vertices plus two index lists (triangles for the filled pass,
+    // line pairs for the wireframe pass) to the GPU once, if fails ids=0
+    Mesh(const std::vector<Vertex>& vertices,
+        const std::vector<GLuint>& triangles,
+        const std::vector<GLuint>& edges);
+
+    // Bind the vertex/index buffers and vertex array state
+    void Bind() const;
+
+    // Unbind (bind 0 and disable the client arrays)
+    static void Unbind();
+
+    // Single indexed draw of the filled triangles / wireframe edges
+    // (the mesh must be bound)
+    void DrawFill() const;
+    void DrawEdges() const;
+
+    // Delete the GL buffers
+    void Delete();
+
+    // Getters
+    GLuint GetVAO() const { return vao; }
+    GLsizei GetTriangleIndexCount() const { return triCount; }
+    GLsizei GetEdgeIndexCount() const { return edgeCount; }
+
+    // CPU copy of the geometry, for the software rasterizer: the vertices,
+    // and the triangle indices followed by the edge indices
+    const std::vector<Vertex>& GetVertices() const { return vertices; }
+    const GLuint* GetTriangleIndices() const { return indices.data(); }
+    const GLuint* GetEdgeIndices() const { return indices.data() + triCount; }
+
+    // Unit primitives centered at the origin (extent -0.5..0.5)
+    static Mesh* CreateCube();
+    static Mesh* CreatePyramid();
+    static Mesh* CreateSphere(int slices, int stacks);
+
+private:
+    // Point the fixed-function arrays at the bound vertex buffer
+    void SetupArrays() const;
+
+    GLuint  vao = 0;
+    GLuint  vbo = 0;
+    GLuint  ibo = 0;
+    GLsizei triCount = 0;
+    GLsizei edgeCount = 0;
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+};
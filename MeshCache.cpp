@@ -0,0 +1,32 @@
+// MeshCache.cpp
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+#include "MeshCache.h"
+#include "Mesh.h"
+
+std::shared_ptr<Mesh> MeshCache::GetSphere(int slices, int stacks)
+{
+    std::weak_ptr<Mesh>& entry = spheres[std::make_pair(slices, stacks)];
+    if (std::shared_ptr<Mesh> mesh = entry.lock()) {
+        return mesh;
+    }
+
+    // Tessellate once; the deleter releases the GPU buffers with the last user
+    std::shared_ptr<Mesh> mesh(Mesh::CreateSphere(slices, stacks), [](Mesh* m) {
+        m->Delete();
+        delete m;
+    });
+    entry = mesh;
+    return mesh;
+}
+
+size_t MeshCache::GetLiveCount() const
+{
+    size_t live = 0;
+    for (const auto& entry : spheres) {
+        if (!entry.second.expired()) {
+            ++live;
+        }
+    }
+    return live;
+}
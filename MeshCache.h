@@ -0,0 +1,20 @@
+// MeshCache.h
+#pragma once
+#include <map>
+#include <memory>
+#include <utility>
+
+class Mesh;
+
+class MeshCache {
+public:
+    // Shared sphere mesh for a (slices, stacks) tessellation. Generated on
+    // first request; the GL buffers are freed when the last handle is released
+    std::shared_ptr<Mesh> GetSphere(int slices, int stacks);
+
+    // Number of tessellations currently alive
+    size_t GetLiveCount() const;
+
+private:
+    std::map<std::pair<int, int>, std::weak_ptr<Mesh>> spheres;
+};
@@ -0,0 +1,363 @@
+// MipGenerator.cpp
+#include "MipGenerator.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MIP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace MipGenerator {
+
+// Rows handed to one thread at a time
+static const int kRowBand = 32;
+
+int LevelCount(int width, int height)
+{
+    int levels = 1;
+    while (width > 1 || height > 1) {
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+        ++levels;
+    }
+    return levels;
+}
+
+// Run fn(first, last) over bands of [0, rows), in parallel when there is a pool
+template <typename Fn>
+static void ForRows(ThreadPool* pool, int rows, Fn fn)
+{
+    int bands = (rows + kRowBand - 1) / kRowBand;
+    if (!pool || bands < 2) {
+        fn(0, rows);
+        return;
+    }
+    pool->ParallelFor((size_t)bands, [&](size_t band) {
+        int first = (int)band * kRowBand;
+        fn(first, std::min(rows, first + kRowBand));
+    });
+}
+
+// ---- Box filter on 8-bit texels ----
+
+// Average 2x2 source blocks into destination rows [y0, y1)
+static void BoxRows(const unsigned char* src, int sw, int sh,
+    unsigned char* dst, int dw, int channels, int y0, int y1)
+{
+    const size_t rowBytes = (size_t)sw * channels;
+    std::vector<uint16_t> sums(rowBytes);
+    for (int y = y0; y < y1; ++y) {
+        const unsigned char* row0 = src + (size_t)std::min(2 * y, sh - 1) * rowBytes;
+        const unsigned char* row1 = src + (size_t)std::min(2 * y + 1, sh - 1) * rowBytes;
+        unsigned char* out = dst + (size_t)y * dw * channels;
+
+        // Vertical pairs, 16 bytes at a time
+        size_t i = 0;
+#if MIP_SSE2
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 <= rowBytes; i += 16) {
+            __m128i a = _mm_loadu_si128((const __m128i*)(row0 + i));
+            __m128i b = _mm_loadu_si128((const __m128i*)(row1 + i));
+            __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+            __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+            _mm_storeu_si128((__m128i*)&sums[i], lo);
+            _mm_storeu_si128((__m128i*)&sums[i + 8], hi);
+        }
+#endif
+        for (; i < rowBytes; ++i) {
+            sums[i] = (uint16_t)(row0[i] + row1[i]);
+        }
+
+        // Horizontal pairs; with sw >= 2 texel 2x + 1 always exists
+        int x = 0;
+#if MIP_SSE2
+        const __m128i two = _mm_set1_epi16(2);
+        if (sw >= 2 && channels == 4) {
+            // One register holds two RGBA texels: fold its halves
+            for (; x + 2 <= dw; x += 2) {
+                __m128i a = _mm_loadu_si128((const __m128i*)&sums[(size_t)x * 8]);
+                __m128i b = _mm_loadu_si128((const __m128i*)&sums[(size_t)x * 8 + 8]);
+                __m128i s = _mm_add_epi16(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b));
+                s = _mm_srli_epi16(_mm_add_epi16(s, two), 2);
+                _mm_storel_epi64((__m128i*)(out + (size_t)x * 4), _mm_packus_epi16(s, s));
+            }
+        }
+        else if (sw >= 2 && channels == 1) {
+            // Adjacent 16-bit sums added pairwise by a multiply-add with ones
+            const __m128i ones = _mm_set1_epi16(1);
+            for (; x + 8 <= dw; x += 8) {
+                __m128i a = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)&sums[(size_t)x * 2]), ones);
+                __m128i b = _mm_madd_epi16(_mm_loadu_si128((const __m128i*)&sums[(size_t)x * 2 + 8]), ones);
+                __m128i s = _mm_srli_epi16(_mm_add_epi16(_mm_packs_epi32(a, b), two), 2);
+                _mm_storel_epi64((__m128i*)(out + x), _mm_packus_epi16(s, s));
+            }
+        }
+#endif
+        for (; x < dw; ++x) {
+            int x0 = std::min(2 * x, sw - 1) * channels;
+            int x1 = std::min(2 * x + 1, sw - 1) * channels;
+            for (int c = 0; c < channels; ++c) {
+                out[x * channels + c] = (unsigned char)((sums[x0 + c] + sums[x1 + c] + 2) >> 2);
+            }
+        }
+    }
+}
+
+// ---- Separable float filters (Kaiser, and anything gamma-correct) ----
+
+// Source texel offsets from 2x and their weights for one output texel
+struct Kernel {
+    int   first;        // offset of the first tap
+    int   taps;
+    float weight[8];
+};
+
+static float BesselI0(float x)
+{
+    float sum = 1.0f, term = 1.0f;
+    for (int k = 1; k < 20; ++k) {
+        term *= (x * 0.5f / k) * (x * 0.5f / k);
+        sum += term;
+    }
+    return sum;
+}
+
+static Kernel MakeKernel(Filter filter)
+{
+    Kernel k;
+    if (filter == Filter::Box) {
+        k.first = 0;
+        k.taps = 2;
+        k.weight[0] = k.weight[1] = 0.5f;
+        return k;
+    }
+
+    // Half-band sinc under a Kaiser window (alpha 4) spanning 4 source
+    // texels either side of the output texel's center at 2x + 1
+    const float alpha = 4.0f;
+    const float pi = 3.14159265f;
+    k.first = -3;
+    k.taps = 8;
+    float sum = 0.0f;
+    for (int i = 0; i < 8; ++i) {
+        float d = (k.first + i) + 0.5f - 1.0f;          // texel center - output center
+        float t = d * 0.5f;
+        float sinc = std::fabs(t) < 1e-6f ? 1.0f : std::sin(pi * t) / (pi * t);
+        float r = d / 4.0f;
+        float window = BesselI0(alpha * std::sqrt(std::max(0.0f, 1.0f - r * r))) / BesselI0(alpha);
+        k.weight[i] = sinc * window;
+        sum += k.weight[i];
+    }
+    for (int i = 0; i < 8; ++i) k.weight[i] /= sum;
+    return k;
+}
+
+// sRGB <-> linear conversions through lookup tables
+struct GammaTables {
+    float toLinear[256];
+    unsigned char toSrgb[4096];
+
+    GammaTables() {
+        for (int i = 0; i < 256; ++i) {
+            float c = i / 255.0f;
+            toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        for (int i = 0; i < 4096; ++i) {
+            float l = i / 4095.0f;
+            float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            toSrgb[i] = (unsigned char)std::min(255.0f, c * 255.0f + 0.5f);
+        }
+    }
+};
+
+static const GammaTables& Gamma()
+{
+    static const GammaTables tables;
+    return tables;
+}
+
+// Channel c of a texel holds sRGB color (rather than alpha)
+static bool IsColor(int c, int channels)
+{
+    return !(channels == 4 && c == 3);
+}
+
+static void ToFloat(const unsigned char* src, size_t texels, int channels, bool gamma, float* dst)
+{
+    const GammaTables& g = Gamma();
+    for (size_t i = 0; i < texels; ++i) {
+        for (int c = 0; c < channels; ++c) {
+            unsigned char v = src[i * channels + c];
+            dst[i * channels + c] = (gamma && IsColor(c, channels)) ? g.toLinear[v] : v / 255.0f;
+        }
+    }
+}
+
+// Unclamped horizontal taps for outputs [x, end) of one row; returns end
+template <int CH>
+static int HorizontalInner(const Kernel& k, const float* in, float* out, int x, int end)
+{
+    for (; x < end; ++x) {
+        const float* p = in + (size_t)(2 * x + k.first) * CH;
+        float acc[CH] = {};
+        for (int t = 0; t < k.taps; ++t) {
+            for (int c = 0; c < CH; ++c) acc[c] += k.weight[t] * p[t * CH + c];
+        }
+        for (int c = 0; c < CH; ++c) out[x * CH + c] = acc[c];
+    }
+    return x;
+}
+
+// Filter src (sw x sh floats) down to dw x dh: horizontal pass into tmp,
+// vertical pass into dst, which is also written out as 8-bit texels
+static void FilterLevel(const Kernel& k, const float* src, int sw, int sh, float* tmp,
+    float* dst, unsigned char* bytes, int dw, int dh, int channels, bool gamma, ThreadPool* pool)
+{
+    const size_t dstRow = (size_t)dw * channels;
+
+    // Output texels whose taps all lie inside the row need no clamping. A
+    // row only a few texels wide may have none
+    int inner0 = std::min(dw, std::max(0, (1 - k.first) / 2));
+    int last = sw - k.first - k.taps;
+    int inner1 = last < 0 ? inner0 : std::max(inner0, std::min(dw, last / 2 + 1));
+
+    ForRows(pool, sh, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            const float* in = src + (size_t)y * sw * channels;
+            float* out = tmp + (size_t)y * dstRow;
+            auto clamped = [&](int x) {
+                float acc[4] = {};
+                for (int t = 0; t < k.taps; ++t) {
+                    int sx = std::min(std::max(2 * x + k.first + t, 0), sw - 1);
+                    const float* p = in + (size_t)sx * channels;
+                    for (int c = 0; c < channels; ++c) acc[c] += k.weight[t] * p[c];
+                }
+                for (int c = 0; c < channels; ++c) out[x * channels + c] = acc[c];
+            };
+
+            int x = 0;
+            for (; x < inner0; ++x) clamped(x);
+#if MIP_SSE2
+            if (channels == 4) {
+                // One RGBA texel per register
+                for (; x < inner1; ++x) {
+                    const float* p = in + (size_t)(2 * x + k.first) * 4;
+                    __m128 acc = _mm_setzero_ps();
+                    for (int t = 0; t < k.taps; ++t) {
+                        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(k.weight[t]), _mm_loadu_ps(p + t * 4)));
+                    }
+                    _mm_storeu_ps(out + (size_t)x * 4, acc);
+                }
+            }
+            else if (channels == 1) {
+                // Four outputs at once: every other source texel, per tap.
+                // The second load runs one texel past the last tap
+                for (; x + 4 <= inner1 && 2 * x + k.first + k.taps + 7 <= sw; x += 4) {
+                    const float* p = in + 2 * x + k.first;
+                    __m128 acc = _mm_setzero_ps();
+                    for (int t = 0; t < k.taps; ++t) {
+                        __m128 a = _mm_loadu_ps(p + t);
+                        __m128 b = _mm_loadu_ps(p + t + 4);
+                        __m128 even = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+                        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(k.weight[t]), even));
+                    }
+                    _mm_storeu_ps(out + x, acc);
+                }
+            }
+#endif
+            switch (channels) {
+            case 1:  x = HorizontalInner<1>(k, in, out, x, inner1); break;
+            case 3:  x = HorizontalInner<3>(k, in, out, x, inner1); break;
+            default: x = HorizontalInner<4>(k, in, out, x, inner1); break;
+            }
+            for (; x < dw; ++x) clamped(x);
+        }
+    });
+
+    const GammaTables& g = Gamma();
+    ForRows(pool, dh, [&](int y0, int y1) {
+        for (int y = y0; y < y1; ++y) {
+            const float* rows[8];
+            for (int t = 0; t < k.taps; ++t) {
+                int sy = std::min(std::max(2 * y + k.first + t, 0), sh - 1);
+                rows[t] = tmp + (size_t)sy * dstRow;
+            }
+            float* out = dst + (size_t)y * dstRow;
+
+            // Weighted sum of whole rows, four floats at a time
+            size_t i = 0;
+#if MIP_SSE2
+            for (; i + 4 <= dstRow; i += 4) {
+                __m128 acc = _mm_setzero_ps();
+                for (int t = 0; t < k.taps; ++t) {
+                    acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(k.weight[t]), _mm_loadu_ps(rows[t] + i)));
+                }
+                // Sinc lobes can overshoot
+                acc = _mm_min_ps(_mm_max_ps(acc, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+                _mm_storeu_ps(out + i, acc);
+            }
+#endif
+            for (; i < dstRow; ++i) {
+                float acc = 0.0f;
+                for (int t = 0; t < k.taps; ++t) acc += k.weight[t] * rows[t][i];
+                out[i] = std::min(1.0f, std::max(0.0f, acc));
+            }
+
+            unsigned char* b = bytes + (size_t)y * dstRow;
+            for (size_t j = 0; j < dstRow; j += channels) {
+                for (int c = 0; c < channels; ++c) {
+                    b[j + c] = (gamma && IsColor(c, channels)) ? g.toSrgb[(int)(out[j + c] * 4095.0f + 0.5f)]
+                        : (unsigned char)(out[j + c] * 255.0f + 0.5f);
+                }
+            }
+        }
+    });
+}
+
+void BuildChain(int width, int height, int channels,
+    std::vector<std::vector<unsigned char>>& levels, const Settings& settings)
+{
+    levels.resize(1);
+    int w = width, h = height;
+
+    if (settings.filter == Filter::Box && !settings.gammaCorrect) {
+        // Exact integer averages, straight from the 8-bit level above
+        while (w > 1 || h > 1) {
+            int nw = std::max(1, w / 2);
+            int nh = std::max(1, h / 2);
+            std::vector<unsigned char> next((size_t)nw * nh * channels);
+            const unsigned char* src = levels.back().data();
+            ForRows(settings.pool, nh, [&](int y0, int y1) {
+                BoxRows(src, w, h, next.data(), nw, channels, y0, y1);
+            });
+            levels.push_back(std::move(next));
+            w = nw;
+            h = nh;
+        }
+        return;
+    }
+
+    // Float chain: each level is filtered from the unrounded one above
+    const Kernel kernel = MakeKernel(settings.filter);
+    std::vector<float> current((size_t)w * h * channels);
+    ToFloat(levels[0].data(), (size_t)w * h, channels, settings.gammaCorrect, current.data());
+    std::vector<float> tmp, next;
+    while (w > 1 || h > 1) {
+        int nw = std::max(1, w / 2);
+        int nh = std::max(1, h / 2);
+        tmp.resize((size_t)nw * h * channels);
+        next.resize((size_t)nw * nh * channels);
+        std::vector<unsigned char> bytes((size_t)nw * nh * channels);
+        FilterLevel(kernel, current.data(), w, h, tmp.data(), next.data(), bytes.data(),
+            nw, nh, channels, settings.gammaCorrect, settings.pool);
+        levels.push_back(std::move(bytes));
+        current.swap(next);
+        w = nw;
+        h = nh;
+    }
+}
+
+}
@@ -0,0 +1,32 @@
+// MipGenerator.h
+#pragma once
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Builds mip chains on the CPU so every level can be cached, compressed
+// and uploaded explicitly instead of left to glGenerateMipmap
+namespace MipGenerator {
+
+enum class Filter : uint32_t {
+    Box = 0,    // 2x2 average
+    Kaiser      // 8-tap Kaiser-windowed sinc: sharper, less aliasing
+};
+
+struct Settings {
+    Filter filter = Filter::Box;
+    bool gammaCorrect = false;      // filter sRGB color in linear light (alpha stays linear)
+    ThreadPool* pool = nullptr;     // spreads each level's rows when set
+};
+
+// Append levels 1..N (down to 1x1) to levels, which must hold the tightly
+// packed 1-, 3- or 4-channel base image as levels[0]. Each level halves
+// the one above (rounding down); odd edges repeat their last row / column
+void BuildChain(int width, int height, int channels,
+    std::vector<std::vector<unsigned char>>& levels, const Settings& settings = Settings());
+
+// Number of levels in a full chain for a width x height image
+int LevelCount(int width, int height);
+
+}
@@ -0,0 +1,350 @@
+// ModelMatrixBatch.cpp
+#include "ModelMatrixBatch.h"
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define MMB_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define MMB_TARGET_AVX2
+#else
+#include <cpuid.h>
+#define MMB_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#endif
+
+namespace ModelMatrixBatch {
+
+// Closed form of Rz(c) * Ry(b) * Rx(a), column-major like glm:
+//   col0 = ( cc*cb,            sc*cb,            -sb    )
+//   col1 = ( cc*sb*sa - sc*ca, sc*sb*sa + cc*ca,  cb*sa )
+//   col2 = ( cc*sb*ca + sc*sa, sc*sb*ca - cc*sa,  cb*ca )
+// Each column is then multiplied by the matching scale component and the
+// translation goes in col3.
+glm::mat4 BuildOne(const glm::vec3& p, const glm::vec3& r, const glm::vec3& s)
+{
+    float sa = std::sin(r.x), ca = std::cos(r.x);
+    float sb = std::sin(r.y), cb = std::cos(r.y);
+    float sc = std::sin(r.z), cc = std::cos(r.z);
+
+    glm::mat4 m(1.0f);
+    m[0][0] = cc * cb * s.x;
+    m[0][1] = sc * cb * s.x;
+    m[0][2] = -sb * s.x;
+    m[0][3] = 0.0f;
+
+    m[1][0] = (cc * sb * sa - sc * ca) * s.y;
+    m[1][1] = (sc * sb * sa + cc * ca) * s.y;
+    m[1][2] = cb * sa * s.y;
+    m[1][3] = 0.0f;
+
+    m[2][0] = (cc * sb * ca + sc * sa) * s.z;
+    m[2][1] = (sc * sb * ca - cc * sa) * s.z;
+    m[2][2] = cb * ca * s.z;
+    m[2][3] = 0.0f;
+
+    m[3][0] = p.x;
+    m[3][1] = p.y;
+    m[3][2] = p.z;
+    m[3][3] = 1.0f;
+    return m;
+}
+
+static void BuildScalar(const glm::vec3* positions, const glm::vec3* rotations,
+    const glm::vec3* scales, glm::mat4* out, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = BuildOne(positions[i], rotations[i], scales[i]);
+    }
+}
+
+#if MMB_X86
+
+// Cody-Waite split of pi/2 and the minimax polynomials for sin/cos on
+// [-pi/4, pi/4] (Cephes sinf/cosf coefficients)
+static const float kTwoOverPi = 0.636619772367581343f;
+static const float kPio2_1 = 1.5703125f;
+static const float kPio2_2 = 4.837512969970703125e-4f;
+static const float kPio2_3 = 7.54978995489188216e-8f;
+static const float kSin1 = -1.6666654611e-1f;
+static const float kSin2 = 8.3321608736e-3f;
+static const float kSin3 = -1.9515295891e-4f;
+static const float kCos1 = 4.166664568298827e-2f;
+static const float kCos2 = -1.388731625493765e-3f;
+static const float kCos3 = 2.443315711809948e-5f;
+
+//   SSE (4 objects per iteration)
+
+static inline void SinCos4(__m128 x, __m128* s, __m128* c)
+{
+    // Quadrant and reduced argument r in [-pi/4, pi/4]
+    __m128i q = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(kTwoOverPi)));
+    __m128 qf = _mm_cvtepi32_ps(q);
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(qf, _mm_set1_ps(kPio2_1)));
+    r = _mm_sub_ps(r, _mm_mul_ps(qf, _mm_set1_ps(kPio2_2)));
+    r = _mm_sub_ps(r, _mm_mul_ps(qf, _mm_set1_ps(kPio2_3)));
+
+    __m128 r2 = _mm_mul_ps(r, r);
+    __m128 ps = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kSin3), r2), _mm_set1_ps(kSin2));
+    ps = _mm_add_ps(_mm_mul_ps(ps, r2), _mm_set1_ps(kSin1));
+    ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, r2), r), r);
+
+    __m128 pc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(kCos3), r2), _mm_set1_ps(kCos2));
+    pc = _mm_add_ps(_mm_mul_ps(pc, r2), _mm_set1_ps(kCos1));
+    pc = _mm_mul_ps(_mm_mul_ps(pc, r2), r2);
+    pc = _mm_add_ps(_mm_sub_ps(pc, _mm_mul_ps(_mm_set1_ps(0.5f), r2)), _mm_set1_ps(1.0f));
+
+    // Odd quadrants swap sin/cos; quadrants 2,3 negate sin, 1,2 negate cos
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(
+        _mm_and_si128(q, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+    __m128 sinv = _mm_or_ps(_mm_and_ps(swap, pc), _mm_andnot_ps(swap, ps));
+    __m128 cosv = _mm_or_ps(_mm_and_ps(swap, ps), _mm_andnot_ps(swap, pc));
+    __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, _mm_set1_epi32(2)), 30));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(
+        _mm_and_si128(_mm_add_epi32(q, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+    *s = _mm_xor_ps(sinv, sinSign);
+    *c = _mm_xor_ps(cosv, cosSign);
+}
+
+// Four packed vec3s (12 floats) -> x, y, z lanes
+static inline void Deinterleave4(const glm::vec3* v, __m128* x, __m128* y, __m128* z)
+{
+    const float* f = &v[0].x;
+    __m128 a = _mm_loadu_ps(f);        // x0 y0 z0 x1
+    __m128 b = _mm_loadu_ps(f + 4);    // y1 z1 x2 y2
+    __m128 c = _mm_loadu_ps(f + 8);    // z2 x3 y3 z3
+
+    __m128 t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2));            // x2 x2 x3 x3
+    *x = _mm_shuffle_ps(a, t, _MM_SHUFFLE(2, 0, 3, 0));
+    __m128 t1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));           // y0 y0 y1 y1
+    __m128 t2 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));           // y2 y2 y3 y3
+    *y = _mm_shuffle_ps(t1, t2, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 t3 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));           // z0 z0 z1 z1
+    __m128 t4 = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));           // z2 z2 z3 z3
+    *z = _mm_shuffle_ps(t3, t4, _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+// Matrix elements for 4 objects in SoA form: m[col][row]
+struct Soa4 { __m128 m[4][3]; };
+
+static inline void Compose4(__m128 px, __m128 py, __m128 pz,
+    __m128 rx, __m128 ry, __m128 rz,
+    __m128 sx, __m128 sy, __m128 sz, Soa4* o)
+{
+    __m128 sa, ca, sb, cb, sc, cc;
+    SinCos4(rx, &sa, &ca);
+    SinCos4(ry, &sb, &cb);
+    SinCos4(rz, &sc, &cc);
+
+    __m128 ccsb = _mm_mul_ps(cc, sb);
+    __m128 scsb = _mm_mul_ps(sc, sb);
+
+    o->m[0][0] = _mm_mul_ps(_mm_mul_ps(cc, cb), sx);
+    o->m[0][1] = _mm_mul_ps(_mm_mul_ps(sc, cb), sx);
+    o->m[0][2] = _mm_sub_ps(_mm_setzero_ps(), _mm_mul_ps(sb, sx));
+
+    o->m[1][0] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(ccsb, sa), _mm_mul_ps(sc, ca)), sy);
+    o->m[1][1] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(scsb, sa), _mm_mul_ps(cc, ca)), sy);
+    o->m[1][2] = _mm_mul_ps(_mm_mul_ps(cb, sa), sy);
+
+    o->m[2][0] = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(ccsb, ca), _mm_mul_ps(sc, sa)), sz);
+    o->m[2][1] = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(scsb, ca), _mm_mul_ps(cc, sa)), sz);
+    o->m[2][2] = _mm_mul_ps(_mm_mul_ps(cb, ca), sz);
+
+    o->m[3][0] = px;
+    o->m[3][1] = py;
+    o->m[3][2] = pz;
+}
+
+// Transpose the SoA lanes back into four column-major mat4s
+static inline void Store4(const Soa4& s, glm::mat4* out)
+{
+    for (int col = 0; col < 4; ++col) {
+        __m128 r0 = s.m[col][0];
+        __m128 r1 = s.m[col][1];
+        __m128 r2 = s.m[col][2];
+        __m128 r3 = (col == 3) ? _mm_set1_ps(1.0f) : _mm_setzero_ps();
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(&out[0][col].x, r0);
+        _mm_storeu_ps(&out[1][col].x, r1);
+        _mm_storeu_ps(&out[2][col].x, r2);
+        _mm_storeu_ps(&out[3][col].x, r3);
+    }
+}
+
+static void BuildSSE(const glm::vec3* positions, const glm::vec3* rotations,
+    const glm::vec3* scales, glm::mat4* out, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 px, py, pz, rx, ry, rz, sx, sy, sz;
+        Deinterleave4(positions + i, &px, &py, &pz);
+        Deinterleave4(rotations + i, &rx, &ry, &rz);
+        Deinterleave4(scales + i, &sx, &sy, &sz);
+
+        Soa4 soa;
+        Compose4(px, py, pz, rx, ry, rz, sx, sy, sz, &soa);
+        Store4(soa, out + i);
+    }
+    BuildScalar(positions + i, rotations + i, scales + i, out + i, count - i);
+}
+
+//   AVX2 (8 objects per iteration)
+
+MMB_TARGET_AVX2
+static inline void SinCos8(__m256 x, __m256* s, __m256* c)
+{
+    __m256i q = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(kTwoOverPi)));
+    __m256 qf = _mm256_cvtepi32_ps(q);
+    __m256 r = _mm256_fnmadd_ps(qf, _mm256_set1_ps(kPio2_1), x);
+    r = _mm256_fnmadd_ps(qf, _mm256_set1_ps(kPio2_2), r);
+    r = _mm256_fnmadd_ps(qf, _mm256_set1_ps(kPio2_3), r);
+
+    __m256 r2 = _mm256_mul_ps(r, r);
+    __m256 ps = _mm256_fmadd_ps(_mm256_set1_ps(kSin3), r2, _mm256_set1_ps(kSin2));
+    ps = _mm256_fmadd_ps(ps, r2, _mm256_set1_ps(kSin1));
+    ps = _mm256_fmadd_ps(_mm256_mul_ps(ps, r2), r, r);
+
+    __m256 pc = _mm256_fmadd_ps(_mm256_set1_ps(kCos3), r2, _mm256_set1_ps(kCos2));
+    pc = _mm256_fmadd_ps(pc, r2, _mm256_set1_ps(kCos1));
+    pc = _mm256_mul_ps(_mm256_mul_ps(pc, r2), r2);
+    pc = _mm256_add_ps(_mm256_fnmadd_ps(_mm256_set1_ps(0.5f), r2, pc), _mm256_set1_ps(1.0f));
+
+    __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+        _mm256_and_si256(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+    __m256 sinv = _mm256_blendv_ps(ps, pc, swap);
+    __m256 cosv = _mm256_blendv_ps(pc, ps, swap);
+    __m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+        _mm256_and_si256(q, _mm256_set1_epi32(2)), 30));
+    __m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+        _mm256_and_si256(_mm256_add_epi32(q, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+    *s = _mm256_xor_ps(sinv, sinSign);
+    *c = _mm256_xor_ps(cosv, cosSign);
+}
+
+MMB_TARGET_AVX2
+static inline void Deinterleave8(const glm::vec3* v, __m256* x, __m256* y, __m256* z)
+{
+    __m128 x0, y0, z0, x1, y1, z1;
+    Deinterleave4(v, &x0, &y0, &z0);
+    Deinterleave4(v + 4, &x1, &y1, &z1);
+    *x = _mm256_insertf128_ps(_mm256_castps128_ps256(x0), x1, 1);
+    *y = _mm256_insertf128_ps(_mm256_castps128_ps256(y0), y1, 1);
+    *z = _mm256_insertf128_ps(_mm256_castps128_ps256(z0), z1, 1);
+}
+
+MMB_TARGET_AVX2
+static void BuildAVX2(const glm::vec3* positions, const glm::vec3* rotations,
+    const glm::vec3* scales, glm::mat4* out, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 px, py, pz, rx, ry, rz, sx, sy, sz;
+        Deinterleave8(positions + i, &px, &py, &pz);
+        Deinterleave8(rotations + i, &rx, &ry, &rz);
+        Deinterleave8(scales + i, &sx, &sy, &sz);
+
+        __m256 sa, ca, sb, cb, sc, cc;
+        SinCos8(rx, &sa, &ca);
+        SinCos8(ry, &sb, &cb);
+        SinCos8(rz, &sc, &cc);
+
+        __m256 ccsb = _mm256_mul_ps(cc, sb);
+        __m256 scsb = _mm256_mul_ps(sc, sb);
+
+        __m256 m[4][3];
+        m[0][0] = _mm256_mul_ps(_mm256_mul_ps(cc, cb), sx);
+        m[0][1] = _mm256_mul_ps(_mm256_mul_ps(sc, cb), sx);
+        m[0][2] = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_mul_ps(sb, sx));
+
+        m[1][0] = _mm256_mul_ps(_mm256_fmsub_ps(ccsb, sa, _mm256_mul_ps(sc, ca)), sy);
+        m[1][1] = _mm256_mul_ps(_mm256_fmadd_ps(scsb, sa, _mm256_mul_ps(cc, ca)), sy);
+        m[1][2] = _mm256_mul_ps(_mm256_mul_ps(cb, sa), sy);
+
+        m[2][0] = _mm256_mul_ps(_mm256_fmadd_ps(ccsb, ca, _mm256_mul_ps(sc, sa)), sz);
+        m[2][1] = _mm256_mul_ps(_mm256_fmsub_ps(scsb, ca, _mm256_mul_ps(cc, sa)), sz);
+        m[2][2] = _mm256_mul_ps(_mm256_mul_ps(cb, ca), sz);
+
+        m[3][0] = px;
+        m[3][1] = py;
+        m[3][2] = pz;
+
+        // Split into two 4-wide halves and reuse the SSE transpose/store
+        Soa4 lo, hi;
+        for (int col = 0; col < 4; ++col) {
+            for (int row = 0; row < 3; ++row) {
+                lo.m[col][row] = _mm256_castps256_ps128(m[col][row]);
+                hi.m[col][row] = _mm256_extractf128_ps(m[col][row], 1);
+            }
+        }
+        Store4(lo, out + i);
+        Store4(hi, out + i + 4);
+    }
+    BuildSSE(positions + i, rotations + i, scales + i, out + i, count - i);
+}
+
+static bool CpuHasAVX2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    bool fma = (info[2] & (1 << 12)) != 0;
+    if (!osxsave || !avx || !fma) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;   // OS saves YMM state
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+#endif // MMB_X86
+
+Kernel DetectKernel()
+{
+#if MMB_X86
+    static const Kernel best = CpuHasAVX2() ? Kernel::AVX2 : Kernel::SSE;
+    return best;
+#else
+    return Kernel::Scalar;
+#endif
+}
+
+const char* KernelName(Kernel kernel)
+{
+    switch (kernel) {
+    case Kernel::AVX2: return "avx2";
+    case Kernel::SSE:  return "sse";
+    default:           return "scalar";
+    }
+}
+
+void Build(const glm::vec3* positions, const glm::vec3* rotations,
+    const glm::vec3* scales, glm::mat4* out, size_t count)
+{
+    Build(DetectKernel(), positions, rotations, scales, out, count);
+}
+
+void Build(Kernel kernel, const glm::vec3* positions, const glm::vec3* rotations,
+    const glm::vec3* scales, glm::mat4* out, size_t count)
+{
+#if MMB_X86
+    if (kernel == Kernel::AVX2 && DetectKernel() == Kernel::AVX2) {
+        BuildAVX2(positions, rotations, scales, out, count);
+        return;
+    }
+    if (kernel != Kernel::Scalar) {
+        BuildSSE(positions, rotations, scales, out, count);
+        return;
+    }
+#endif
+    BuildScalar(positions, rotations, scales, out, count);
+}
+
+} // namespace ModelMatrixBatch
@@ -0,0 +1,31 @@
+// ModelMatrixBatch.h
+#pragma once
+#include <glm/glm.hpp>
+#include <cstddef>
+
+// Vectorized builder for many model matrices at once. Each output is
+// T * Rz * Ry * Rx * S (the same order Object3D always used), evaluated in
+// closed form from the Euler angles instead of chaining glm::rotate calls.
+namespace ModelMatrixBatch {
+
+    enum class Kernel { Scalar, SSE, AVX2 };
+
+    // Widest kernel the running CPU (and OS) supports
+    Kernel DetectKernel();
+
+    const char* KernelName(Kernel kernel);
+
+    // out[i] = T(positions[i]) * Rz * Ry * Rx (rotations[i]) * S(scales[i])
+    // for i in [0, count). Uses the detected kernel
+    void Build(const glm::vec3* positions, const glm::vec3* rotations,
+        const glm::vec3* scales, glm::mat4* out, size_t count);
+
+    // Same, forcing a particular kernel. AVX2 on a CPU without it runs the
+    // SSE kernel; SSE / AVX2 on non-x86 builds run the scalar one. Mostly
+    // for benchmarks and validation
+    void Build(Kernel kernel, const glm::vec3* positions, const glm::vec3* rotations,
+        const glm::vec3* scales, glm::mat4* out, size_t count);
+
+    // Single matrix, scalar closed form
+    glm::mat4 BuildOne(const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale);
+}
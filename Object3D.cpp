@@ -0,0 +1,106 @@
+// Object3D.cpp
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+#include <glm/gtc/type_ptr.hpp>
+#include "Object3D.h"
+#include "Engine.h"
+#include "Mesh.h"
+#include "Profiler.h"
+#include "RenderState.h"
+
+Texture2D* Object3D::GetTexture() const {
+    if (!IsTextured() || !Engine::instance || Engine::instance->textures.empty()) {
+        return nullptr;
+    }
+    int idx = GetTexIndex() % (int)Engine::instance->textures.size();
+    Texture2D* tex = Engine::instance->textures[idx].get();
+    if (tex && tex->IsPending()) {
+        // Still loading: draw with the placeholder meanwhile
+        tex = Engine::instance->placeholderTexture;
+    }
+    return (tex && tex->GetID() != 0) ? tex : nullptr;
+}
+
+bool Object3D::IntersectLocalRay(const glm::vec3& origin, const glm::vec3& dir, float& t) const {
+    const float big = 1e30f;
+    glm::vec3 invDir(dir.x != 0.0f ? 1.0f / dir.x : big,
+        dir.y != 0.0f ? 1.0f / dir.y : big,
+        dir.z != 0.0f ? 1.0f / dir.z : big);
+    return AABBTree::RayHitsAABB(origin, invDir, GetLocalBounds(), big, t);
+}
+
+bool Object3D::IntersectRay(const glm::vec3& origin, const glm::vec3& dir, float& t) const {
+    // Affine transforms keep the ray parameter, so t carries over unchanged
+    glm::mat4 inv = glm::inverse(GetModelMatrix());
+    glm::vec3 localOrigin(inv * glm::vec4(origin, 1.0f));
+    glm::vec3 localDir(inv * glm::vec4(dir, 0.0f));
+    return IntersectLocalRay(localOrigin, localDir, t);
+}
+
+void Object3D::DrawOutline() {
+    Mesh* mesh = GetMesh();
+    if (!mesh) {
+        return;
+    }
+
+    RenderState* state = RenderState::instance;
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glMultMatrixf(glm::value_ptr(GetModelMatrix()));
+    mesh->Bind();
+    Texture2D::Unbind();
+    state->SetLineWidth(3.0f);
+    glColor3f(1.0f, 0.5f, 0.0f);
+    mesh->DrawEdges();
+    Mesh::Unbind();
+    state->SetLineWidth(1.0f);
+    glPopMatrix();
+}
+
+void Object3D::DrawMesh(const Mesh* mesh) {
+    PROFILE_SCOPE("Object3D::Draw");
+
+    // Bind the correct texture or unbind if none
+    if (Texture2D* tex = GetTexture()) {
+        tex->Bind();
+    }
+    else {
+        Texture2D::Unbind();
+    }
+
+    if (!mesh) {
+        return;
+    }
+
+    // Apply this object's transform
+    const glm::mat4& model = GetModelMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glMultMatrixf(glm::value_ptr(model));
+
+    mesh->Bind();
+
+    // Draw the filled faces (textured if bound, else flat white)
+    glEnable(GL_TEXTURE_2D);
+    glColor3f(1.0f, 1.0f, 1.0f);
+    RenderState* state = RenderState::instance;
+    state->SetPolygonMode(GL_FILL);
+    mesh->DrawFill();
+
+    // Draw the wireframe overlay (always untextured)
+    Texture2D::Unbind();
+    if (IsSelected()) {
+        state->SetLineWidth(3.0f);
+        glColor3f(1.0f, 0.5f, 0.0f);  // bright orange outline if selected
+    }
+    else {
+        state->SetLineWidth(1.0f);
+        glColor3f(0.0f, 0.0f, 0.0f);  // black outline otherwise
+    }
+    mesh->DrawEdges();
+
+    // Restore defaults and pop matrix
+    Mesh::Unbind();
+    state->SetLineWidth(1.0f);
+    glPopMatrix();
+}
@@ -3,59 +3,93 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "TransformStore.h"
+
+class Mesh;
+class Texture2D;
 
 class Object3D {
 public:
+    // Registers a slot in the active TransformStore; the object itself is
+    // only a handle to that slot
     Object3D()
-        : position(0.0f),
-        rotation(0.0f),
-        scale(1.0f),
-        selected(false),
-        textured(false),
-        texIndex(0)
+        : store(TransformStore::instance),
+        slot(TransformStore::instance->Allocate(this))
     {}
 
-    virtual ~Object3D() {}
+    virtual ~Object3D() { store->Release(slot); }
 
     // Transform setters
-    void SetPosition(const glm::vec3& pos) { position = pos; }
-    void SetRotation(const glm::vec3& rot) { rotation = rot; }
-    void SetScale(const glm::vec3& scl) { scale = scl; }
-
-    // Model matrix
-    glm::mat4 GetModelMatrix() const {
-        glm::mat4 T = glm::translate(glm::mat4(1.0f), position);
-        glm::mat4 Rx = glm::rotate(glm::mat4(1.0f), rotation.x, glm::vec3(1, 0, 0));
-        glm::mat4 Ry = glm::rotate(glm::mat4(1.0f), rotation.y, glm::vec3(0, 1, 0));
-        glm::mat4 Rz = glm::rotate(glm::mat4(1.0f), rotation.z, glm::vec3(0, 0, 1));
-        glm::mat4 S = glm::scale(glm::mat4(1.0f), scale);
-        return T * Rz * Ry * Rx * S;
-    }
+    void SetPosition(const glm::vec3& pos) { store->positions[slot] = pos; store->MarkDirty(slot); }
+    void SetRotation(const glm::vec3& rot) { store->rotations[slot] = rot; store->MarkDirty(slot); }
+    void SetScale(const glm::vec3& scl) { store->scales[slot] = scl; store->MarkDirty(slot); }
+
+    // Cached model matrix, only rebuilt after the transform changed
+    const glm::mat4& GetModelMatrix() const { return store->GetModelMatrix(slot); }
+
+    glm::vec3 GetPosition() const { return store->positions[slot]; }
+    glm::vec3 GetScale() const { return store->scales[slot]; }
+	glm::vec3 GetRotation() const { return store->rotations[slot]; }
 
-    glm::vec3 GetPosition() const { return position; }
-    glm::vec3 GetScale() const { return scale; }
-	glm::vec3 GetRotation() const { return rotation; }
+    // Draw this object with the fixed-function path
+    virtual void Draw() { DrawMesh(GetMesh()); }
 
-    virtual void Draw() = 0;
+    // Shared GPU geometry for this primitive type
+    virtual Mesh* GetMesh() = 0;
+
+    // Thick orange selection outline of the mesh edges, drawn on top of
+    // whatever was rendered for this object
+    void DrawOutline();
 
     // selection API 
-    void SetSelected(bool s) { selected = s; }
-    bool IsSelected() const { return selected; }
+    void SetSelected(bool s) { SetFlag(TransformStore::FlagSelected, s); }
+    bool IsSelected() const { return HasFlag(TransformStore::FlagSelected); }
 
     // Texturing API
-    void SetTextured(bool on) { textured = on; }
-    bool IsTextured()    const { return textured; }
+    void SetTextured(bool on) { SetFlag(TransformStore::FlagTextured, on); }
+    bool IsTextured()    const { return HasFlag(TransformStore::FlagTextured); }
+
+    void SetTexIndex(int idx) { store->texIndices[slot] = idx; }
+    int  GetTexIndex()   const { return store->texIndices[slot]; }
+
+    // Texture to draw with, or nullptr if untextured / not loaded
+    Texture2D* GetTexture() const;
 
-    void SetTexIndex(int idx) { texIndex = idx; }
-    int  GetTexIndex()   const { return texIndex; }
+    // Bounding volumes: local set by each primitive, world kept in sync
+    // with the model matrix
+    const AABB& GetLocalBounds() const { return store->localBounds[slot]; }
+    const AABB& GetWorldBounds() const { store->GetModelMatrix(slot); return store->worldBounds[slot]; }
+
+    // Exact ray test in local space (origin + t*dir, t >= 0). On a hit
+    // returns the nearest t. The default tests the local bounding box
+    virtual bool IntersectLocalRay(const glm::vec3& origin, const glm::vec3& dir, float& t) const;
+
+    // Same ray test for a world-space ray; t is in the same units as dir
+    bool IntersectRay(const glm::vec3& origin, const glm::vec3& dir, float& t) const;
+
+    // Index of this object's data in its TransformStore
+    uint32_t GetSlot() const { return slot; }
 
 protected:
-    glm::vec3 position;
-    glm::vec3 rotation;
-    glm::vec3 scale;
+    // Called by primitives in their constructors
+    void SetLocalBounds(const AABB& box) { store->SetLocalBounds(slot, box); }
+
+    // Shared draw path: bind this object's texture, then draw the mesh
+    // filled and as a wireframe overlay under the model matrix
+    void DrawMesh(const Mesh* mesh);
 
-    bool selected;
+private:
+    friend class TransformStore;
+
+    Object3D(const Object3D&) = delete;
+    Object3D& operator=(const Object3D&) = delete;
+
+    void SetFlag(TransformStore::Flag flag, bool on) {
+        uint8_t& f = store->flags[slot];
+        f = on ? (uint8_t)(f | flag) : (uint8_t)(f & ~flag);
+    }
+    bool HasFlag(TransformStore::Flag flag) const { return (store->flags[slot] & flag) != 0; }
 
-    bool textured;
-    int texIndex;   
+    TransformStore* store;
+    uint32_t slot;
 };
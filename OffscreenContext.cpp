@@ -0,0 +1,254 @@
+// OffscreenContext.cpp
+#include <GL/glew.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+#include <GL/freeglut.h>
+#include "OffscreenContext.h"
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+bool OffscreenContext::Create(int w, int h)
+{
+    Delete();
+    if (!CreateContext()) {
+        Delete();
+        return false;
+    }
+
+#ifdef _WIN32
+    GLenum glewErr = glewInit();
+#else
+    // glewInit would also look for a GLX display, which EGL contexts lack
+    GLenum glewErr = glewContextInit();
+#endif
+    if (glewErr != GLEW_OK) {
+        std::cerr << "GLEW initialization failed: " << glewGetErrorString(glewErr) << std::endl;
+        Delete();
+        return false;
+    }
+    if (!GLEW_VERSION_3_0 && !GLEW_ARB_framebuffer_object) {
+        std::cerr << "Offscreen rendering needs framebuffer objects\n";
+        Delete();
+        return false;
+    }
+
+    width = w;
+    height = h;
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    // Left bound for good: everything the engine draws lands here
+    glGenFramebuffers(1, &fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Offscreen framebuffer incomplete (" << w << "x" << h << ")\n";
+        Delete();
+        return false;
+    }
+    glViewport(0, 0, w, h);
+
+    std::cout << "Offscreen context: " << w << "x" << h << " on "
+        << (const char*)glGetString(GL_RENDERER) << "\n";
+    return true;
+}
+
+void OffscreenContext::Delete()
+{
+    // The GL objects go with the context, but delete them while it's current
+    if (context) {
+        if (fbo != 0) {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glDeleteFramebuffers(1, &fbo);
+        }
+        if (colorBuffer != 0) glDeleteRenderbuffers(1, &colorBuffer);
+        if (depthBuffer != 0) glDeleteRenderbuffers(1, &depthBuffer);
+    }
+    fbo = colorBuffer = depthBuffer = 0;
+    width = height = 0;
+    DeleteContext();
+}
+
+void OffscreenContext::Swap()
+{
+    glFlush();
+}
+
+bool OffscreenContext::SaveImage(const char* path) const
+{
+    if (fbo == 0) {
+        return false;
+    }
+
+    std::vector<unsigned char> pixels((size_t)width * height * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+    FILE* f = std::fopen(path, "wb");
+    if (!f) {
+        std::cerr << "Cannot write " << path << "\n";
+        return false;
+    }
+    std::fprintf(f, "P6\n%d %d\n255\n", width, height);
+
+    // PPM rows run top-down, GL's bottom-up
+    bool ok = true;
+    const size_t rowBytes = (size_t)width * 3;
+    for (int y = height - 1; y >= 0 && ok; --y) {
+        ok = std::fwrite(&pixels[y * rowBytes], 1, rowBytes, f) == rowBytes;
+    }
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok) {
+        std::cerr << "Failed writing " << path << "\n";
+    }
+    return ok;
+}
+
+#ifdef _WIN32
+
+bool OffscreenContext::CreateContext()
+{
+    // A plain Win32 window (never shown) just to own a pixel format
+    HINSTANCE module = GetModuleHandleA(nullptr);
+    WNDCLASSA wc = {};
+    wc.style = CS_OWNDC;
+    wc.lpfnWndProc = DefWindowProcA;
+    wc.hInstance = module;
+    wc.lpszClassName = "3DEngineOffscreen";
+    RegisterClassA(&wc);    // already registered by an earlier Create is fine
+
+    HWND hwnd = CreateWindowA(wc.lpszClassName, "3D Engine", WS_OVERLAPPEDWINDOW,
+        0, 0, 1, 1, nullptr, nullptr, module, nullptr);
+    if (!hwnd) {
+        std::cerr << "Cannot create the offscreen window\n";
+        return false;
+    }
+    window = hwnd;
+    HDC dc = GetDC(hwnd);
+    display = dc;
+
+    PIXELFORMATDESCRIPTOR pfd = {};
+    pfd.nSize = sizeof(pfd);
+    pfd.nVersion = 1;
+    pfd.dwFlags = PFD_DRAW_TO_WINDOW | PFD_SUPPORT_OPENGL;
+    pfd.iPixelType = PFD_TYPE_RGBA;
+    pfd.cColorBits = 32;
+    pfd.cDepthBits = 24;
+    pfd.iLayerType = PFD_MAIN_PLANE;
+    int format = ChoosePixelFormat(dc, &pfd);
+    if (format == 0 || !SetPixelFormat(dc, format, &pfd)) {
+        std::cerr << "No OpenGL pixel format for the offscreen window\n";
+        return false;
+    }
+
+    HGLRC rc = wglCreateContext(dc);
+    context = rc;
+    if (!rc || !wglMakeCurrent(dc, rc)) {
+        std::cerr << "Cannot create an OpenGL context\n";
+        return false;
+    }
+    return true;
+}
+
+void OffscreenContext::DeleteContext()
+{
+    if (context) {
+        wglMakeCurrent(nullptr, nullptr);
+        wglDeleteContext((HGLRC)context);
+    }
+    if (display) {
+        ReleaseDC((HWND)window, (HDC)display);
+    }
+    if (window) {
+        DestroyWindow((HWND)window);
+    }
+    window = display = surface = context = nullptr;
+}
+
+#else
+
+bool OffscreenContext::CreateContext()
+{
+    EGLDisplay dpy = EGL_NO_DISPLAY;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay) {
+        dpy = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (dpy == EGL_NO_DISPLAY) {
+        dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, nullptr, nullptr)) {
+        std::cerr << "No EGL display for offscreen rendering\n";
+        return false;
+    }
+    display = dpy;
+
+    // Desktop GL (compatibility): the engine uses the fixed-function pipeline
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        std::cerr << "EGL has no desktop OpenGL\n";
+        return false;
+    }
+
+    // Surfaceless first; otherwise a 1x1 pbuffer just to make the context
+    // current (drawing still goes to the framebuffer object)
+    EGLContext ctx = EGL_NO_CONTEXT;
+    EGLSurface surf = EGL_NO_SURFACE;
+    const char* extensions = eglQueryString(dpy, EGL_EXTENSIONS);
+    const bool surfaceless = extensions &&
+        std::strstr(extensions, "EGL_KHR_no_config_context") &&
+        std::strstr(extensions, "EGL_KHR_surfaceless_context");
+    if (surfaceless) {
+        ctx = eglCreateContext(dpy, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, nullptr);
+    }
+    else {
+        const EGLint configAttribs[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+            EGL_NONE
+        };
+        const EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        EGLConfig config;
+        EGLint configCount = 0;
+        if (eglChooseConfig(dpy, configAttribs, &config, 1, &configCount) && configCount > 0) {
+            surf = eglCreatePbufferSurface(dpy, config, pbufferAttribs);
+            surface = surf;
+            ctx = eglCreateContext(dpy, config, EGL_NO_CONTEXT, nullptr);
+        }
+    }
+    context = ctx;
+    if (ctx == EGL_NO_CONTEXT || !eglMakeCurrent(dpy, surf, surf, ctx)) {
+        std::cerr << "Cannot create an offscreen OpenGL context (EGL error 0x"
+            << std::hex << eglGetError() << std::dec << ")\n";
+        return false;
+    }
+    return true;
+}
+
+void OffscreenContext::DeleteContext()
+{
+    if (display) {
+        EGLDisplay dpy = (EGLDisplay)display;
+        eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context) eglDestroyContext(dpy, (EGLContext)context);
+        if (surface) eglDestroySurface(dpy, (EGLSurface)surface);
+        eglTerminate(dpy);
+    }
+    window = display = surface = context = nullptr;
+}
+
+#endif
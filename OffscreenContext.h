@@ -0,0 +1,53 @@
+// OffscreenContext.h
+#pragma once
+#include <GL/freeglut.h>
+
+// A GL context with no window, for rendering on machines without a display
+// (batch renders, performance runs on build servers). Drawing goes to a
+// framebuffer object of the requested size instead of a window's back
+// buffer, so the engine's GL calls work unchanged.
+//
+// On Windows the context belongs to a window that is never shown; elsewhere
+// it comes from EGL, on Mesa's surfaceless platform when available (no X
+// server or GPU needed with llvmpipe) and the default display otherwise.
+class OffscreenContext {
+public:
+    OffscreenContext() = default;
+    ~OffscreenContext() { Delete(); }
+
+    // Create the context, make it current, initialize GLEW and bind a
+    // w x h color + depth framebuffer. Returns false (and cleans up) when
+    // any step fails
+    bool Create(int w, int h);
+
+    // Delete the framebuffer and the context
+    void Delete();
+
+    bool IsCreated() const { return fbo != 0; }
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+
+    // End of a frame: nothing to present, just hand the commands to the GPU
+    void Swap();
+
+    // Write the color buffer to a binary PPM file
+    bool SaveImage(const char* path) const;
+
+private:
+    OffscreenContext(const OffscreenContext&) = delete;
+    OffscreenContext& operator=(const OffscreenContext&) = delete;
+
+    // Platform part of Create / Delete
+    bool CreateContext();
+    void DeleteContext();
+
+    void* window = nullptr;     // HWND (Windows)
+    void* display = nullptr;    // HDC / EGLDisplay
+    void* surface = nullptr;    // EGLSurface, when surfaceless isn't supported
+    void* context = nullptr;    // HGLRC / EGLContext
+
+    GLuint fbo = 0;
+    GLuint colorBuffer = 0;
+    GLuint depthBuffer = 0;
+    int width = 0, height = 0;
+};
@@ -0,0 +1,440 @@
+// PerfHud.cpp
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+#include "PerfHud.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+
+static const int kCharWidth = 8;
+static const int kCharHeight = 11;
+static const int kLineHeight = 13;
+static const int kPadding = 6;
+static const int kMargin = 10;
+static const int kGraphHeight = 60;
+static const double kGraphRangeMs = 50.0;       // top of the graph
+static const int64_t kRefreshNs = 250000000;    // text rebuilt at most 4x a second
+
+// Font atlas: 16 x 6 cells, characters 32..126 then the solid cell
+static const int kAtlasColumns = 16;
+static const int kAtlasWidth = kAtlasColumns * kCharWidth;
+static const int kAtlasHeight = 6 * kCharHeight;
+static const int kSolidCell = 95;
+
+// X11 misc-fixed 8x13 (public domain), rows 1..11 of each glyph top-down,
+// most significant bit leftmost
+static const GLubyte kFont[95 * kCharHeight] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // ' '
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x10, 0x00, 0x00,  // '!'
+    0x24, 0x24, 0x24, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '"'
+    0x00, 0x24, 0x24, 0x7e, 0x24, 0x7e, 0x24, 0x24, 0x00, 0x00, 0x00,  // '#'
+    0x10, 0x3c, 0x50, 0x50, 0x38, 0x14, 0x14, 0x78, 0x10, 0x00, 0x00,  // '$'
+    0x22, 0x52, 0x24, 0x08, 0x08, 0x10, 0x24, 0x2a, 0x44, 0x00, 0x00,  // '%'
+    0x00, 0x00, 0x30, 0x48, 0x48, 0x30, 0x4a, 0x44, 0x3a, 0x00, 0x00,  // '&'
+    0x38, 0x30, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // "'"
+    0x04, 0x08, 0x08, 0x10, 0x10, 0x10, 0x08, 0x08, 0x04, 0x00, 0x00,  // '('
+    0x20, 0x10, 0x10, 0x08, 0x08, 0x08, 0x10, 0x10, 0x20, 0x00, 0x00,  // ')'
+    0x00, 0x00, 0x24, 0x18, 0x7e, 0x18, 0x24, 0x00, 0x00, 0x00, 0x00,  // '*'
+    0x00, 0x00, 0x10, 0x10, 0x7c, 0x10, 0x10, 0x00, 0x00, 0x00, 0x00,  // '+'
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x38, 0x30, 0x40, 0x00,  // ','
+    0x00, 0x00, 0x00, 0x00, 0x7e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '-'
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x38, 0x10, 0x00,  // '.'
+    0x02, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x80, 0x00, 0x00,  // '/'
+    0x18, 0x24, 0x42, 0x42, 0x42, 0x42, 0x42, 0x24, 0x18, 0x00, 0x00,  // '0'
+    0x10, 0x30, 0x50, 0x10, 0x10, 0x10, 0x10, 0x10, 0x7c, 0x00, 0x00,  // '1'
+    0x3c, 0x42, 0x42, 0x02, 0x04, 0x18, 0x20, 0x40, 0x7e, 0x00, 0x00,  // '2'
+    0x7e, 0x02, 0x04, 0x08, 0x1c, 0x02, 0x02, 0x42, 0x3c, 0x00, 0x00,  // '3'
+    0x04, 0x0c, 0x14, 0x24, 0x44, 0x44, 0x7e, 0x04, 0x04, 0x00, 0x00,  // '4'
+    0x7e, 0x40, 0x40, 0x5c, 0x62, 0x02, 0x02, 0x42, 0x3c, 0x00, 0x00,  // '5'
+    0x1c, 0x20, 0x40, 0x40, 0x5c, 0x62, 0x42, 0x42, 0x3c, 0x00, 0x00,  // '6'
+    0x7e, 0x02, 0x04, 0x08, 0x08, 0x10, 0x10, 0x20, 0x20, 0x00, 0x00,  // '7'
+    0x3c, 0x42, 0x42, 0x42, 0x3c, 0x42, 0x42, 0x42, 0x3c, 0x00, 0x00,  // '8'
+    0x3c, 0x42, 0x42, 0x46, 0x3a, 0x02, 0x02, 0x04, 0x38, 0x00, 0x00,  // '9'
+    0x00, 0x00, 0x10, 0x38, 0x10, 0x00, 0x00, 0x10, 0x38, 0x10, 0x00,  // ':'
+    0x00, 0x00, 0x10, 0x38, 0x10, 0x00, 0x00, 0x38, 0x30, 0x40, 0x00,  // ';'
+    0x02, 0x04, 0x08, 0x10, 0x20, 0x10, 0x08, 0x04, 0x02, 0x00, 0x00,  // '<'
+    0x00, 0x00, 0x00, 0x7e, 0x00, 0x00, 0x7e, 0x00, 0x00, 0x00, 0x00,  // '='
+    0x40, 0x20, 0x10, 0x08, 0x04, 0x08, 0x10, 0x20, 0x40, 0x00, 0x00,  // '>'
+    0x3c, 0x42, 0x42, 0x02, 0x04, 0x08, 0x08, 0x00, 0x08, 0x00, 0x00,  // '?'
+    0x3c, 0x42, 0x42, 0x4e, 0x52, 0x56, 0x4a, 0x40, 0x3c, 0x00, 0x00,  // '@'
+    0x18, 0x24, 0x42, 0x42, 0x42, 0x7e, 0x42, 0x42, 0x42, 0x00, 0x00,  // 'A'
+    0xfc, 0x42, 0x42, 0x42, 0x7c, 0x42, 0x42, 0x42, 0xfc, 0x00, 0x00,  // 'B'
+    0x3c, 0x42, 0x40, 0x40, 0x40, 0x40, 0x40, 0x42, 0x3c, 0x00, 0x00,  // 'C'
+    0xfc, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0xfc, 0x00, 0x00,  // 'D'
+    0x7e, 0x40, 0x40, 0x40, 0x78, 0x40, 0x40, 0x40, 0x7e, 0x00, 0x00,  // 'E'
+    0x7e, 0x40, 0x40, 0x40, 0x78, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00,  // 'F'
+    0x3c, 0x42, 0x40, 0x40, 0x40, 0x4e, 0x42, 0x46, 0x3a, 0x00, 0x00,  // 'G'
+    0x42, 0x42, 0x42, 0x42, 0x7e, 0x42, 0x42, 0x42, 0x42, 0x00, 0x00,  // 'H'
+    0x7c, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x7c, 0x00, 0x00,  // 'I'
+    0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x44, 0x38, 0x00, 0x00,  // 'J'
+    0x42, 0x44, 0x48, 0x50, 0x60, 0x50, 0x48, 0x44, 0x42, 0x00, 0x00,  // 'K'
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x7e, 0x00, 0x00,  // 'L'
+    0x82, 0x82, 0xc6, 0xaa, 0x92, 0x92, 0x82, 0x82, 0x82, 0x00, 0x00,  // 'M'
+    0x42, 0x42, 0x62, 0x52, 0x4a, 0x46, 0x42, 0x42, 0x42, 0x00, 0x00,  // 'N'
+    0x3c, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x3c, 0x00, 0x00,  // 'O'
+    0x7c, 0x42, 0x42, 0x42, 0x7c, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00,  // 'P'
+    0x3c, 0x42, 0x42, 0x42, 0x42, 0x42, 0x52, 0x4a, 0x3c, 0x02, 0x00,  // 'Q'
+    0x7c, 0x42, 0x42, 0x42, 0x7c, 0x50, 0x48, 0x44, 0x42, 0x00, 0x00,  // 'R'
+    0x3c, 0x42, 0x40, 0x40, 0x3c, 0x02, 0x02, 0x42, 0x3c, 0x00, 0x00,  // 'S'
+    0xfe, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00,  // 'T'
+    0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x42, 0x3c, 0x00, 0x00,  // 'U'
+    0x82, 0x82, 0x44, 0x44, 0x44, 0x28, 0x28, 0x28, 0x10, 0x00, 0x00,  // 'V'
+    0x82, 0x82, 0x82, 0x82, 0x92, 0x92, 0x92, 0xaa, 0x44, 0x00, 0x00,  // 'W'
+    0x82, 0x82, 0x44, 0x28, 0x10, 0x28, 0x44, 0x82, 0x82, 0x00, 0x00,  // 'X'
+    0x82, 0x82, 0x44, 0x28, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00,  // 'Y'
+    0x7e, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x40, 0x7e, 0x00, 0x00,  // 'Z'
+    0x3c, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x3c, 0x00, 0x00,  // '['
+    0x80, 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x02, 0x00, 0x00,  // '\\'
+    0x78, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x08, 0x78, 0x00, 0x00,  // ']'
+    0x10, 0x28, 0x44, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '^'
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xfe, 0x00,  // '_'
+    0x38, 0x18, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '`'
+    0x00, 0x00, 0x00, 0x3c, 0x02, 0x3e, 0x42, 0x46, 0x3a, 0x00, 0x00,  // 'a'
+    0x40, 0x40, 0x40, 0x5c, 0x62, 0x42, 0x42, 0x62, 0x5c, 0x00, 0x00,  // 'b'
+    0x00, 0x00, 0x00, 0x3c, 0x42, 0x40, 0x40, 0x42, 0x3c, 0x00, 0x00,  // 'c'
+    0x02, 0x02, 0x02, 0x3a, 0x46, 0x42, 0x42, 0x46, 0x3a, 0x00, 0x00,  // 'd'
+    0x00, 0x00, 0x00, 0x3c, 0x42, 0x7e, 0x40, 0x42, 0x3c, 0x00, 0x00,  // 'e'
+    0x1c, 0x22, 0x20, 0x20, 0x7c, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00,  // 'f'
+    0x00, 0x00, 0x00, 0x3a, 0x44, 0x44, 0x38, 0x40, 0x3c, 0x42, 0x3c,  // 'g'
+    0x40, 0x40, 0x40, 0x5c, 0x62, 0x42, 0x42, 0x42, 0x42, 0x00, 0x00,  // 'h'
+    0x00, 0x10, 0x00, 0x30, 0x10, 0x10, 0x10, 0x10, 0x7c, 0x00, 0x00,  // 'i'
+    0x00, 0x04, 0x00, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x44, 0x44, 0x38,  // 'j'
+    0x40, 0x40, 0x40, 0x44, 0x48, 0x70, 0x48, 0x44, 0x42, 0x00, 0x00,  // 'k'
+    0x30, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x7c, 0x00, 0x00,  // 'l'
+    0x00, 0x00, 0x00, 0xec, 0x92, 0x92, 0x92, 0x92, 0x82, 0x00, 0x00,  // 'm'
+    0x00, 0x00, 0x00, 0x5c, 0x62, 0x42, 0x42, 0x42, 0x42, 0x00, 0x00,  // 'n'
+    0x00, 0x00, 0x00, 0x3c, 0x42, 0x42, 0x42, 0x42, 0x3c, 0x00, 0x00,  // 'o'
+    0x00, 0x00, 0x00, 0x5c, 0x62, 0x42, 0x62, 0x5c, 0x40, 0x40, 0x40,  // 'p'
+    0x00, 0x00, 0x00, 0x3a, 0x46, 0x42, 0x46, 0x3a, 0x02, 0x02, 0x02,  // 'q'
+    0x00, 0x00, 0x00, 0x5c, 0x22, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00,  // 'r'
+    0x00, 0x00, 0x00, 0x3c, 0x42, 0x30, 0x0c, 0x42, 0x3c, 0x00, 0x00,  // 's'
+    0x00, 0x20, 0x20, 0x7c, 0x20, 0x20, 0x20, 0x22, 0x1c, 0x00, 0x00,  // 't'
+    0x00, 0x00, 0x00, 0x44, 0x44, 0x44, 0x44, 0x44, 0x3a, 0x00, 0x00,  // 'u'
+    0x00, 0x00, 0x00, 0x44, 0x44, 0x44, 0x28, 0x28, 0x10, 0x00, 0x00,  // 'v'
+    0x00, 0x00, 0x00, 0x82, 0x82, 0x92, 0x92, 0xaa, 0x44, 0x00, 0x00,  // 'w'
+    0x00, 0x00, 0x00, 0x42, 0x24, 0x18, 0x18, 0x24, 0x42, 0x00, 0x00,  // 'x'
+    0x00, 0x00, 0x00, 0x42, 0x42, 0x42, 0x46, 0x3a, 0x02, 0x42, 0x3c,  // 'y'
+    0x00, 0x00, 0x00, 0x7e, 0x04, 0x08, 0x10, 0x20, 0x7e, 0x00, 0x00,  // 'z'
+    0x0e, 0x10, 0x10, 0x08, 0x30, 0x08, 0x10, 0x10, 0x0e, 0x00, 0x00,  // '{'
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00, 0x00,  // '|'
+    0x70, 0x08, 0x08, 0x10, 0x0c, 0x10, 0x08, 0x08, 0x70, 0x00, 0x00,  // '}'
+    0x24, 0x54, 0x48, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,  // '~'
+};
+
+static const GLubyte kPanelColor[4] = { 0, 0, 0, 170 };
+static const GLubyte kGridColor[4] = { 255, 255, 255, 60 };
+static const GLubyte kTitleColor[4] = { 255, 230, 120, 255 };
+static const GLubyte kTextColor[4] = { 235, 235, 235, 255 };
+
+// Bar colour by frame time: up to 60 FPS, up to 30 FPS, slower
+static void FrameColor(double ms, GLubyte color[4])
+{
+    const GLubyte green[4] = { 90, 220, 90, 255 };
+    const GLubyte yellow[4] = { 240, 200, 60, 255 };
+    const GLubyte red[4] = { 240, 70, 60, 255 };
+    const GLubyte* c = ms <= 17.0 ? green : ms <= 34.0 ? yellow : red;
+    std::copy(c, c + 4, color);
+}
+
+// "512 KB" / "6.7 MB"
+static void FormatBytes(size_t bytes, char* out, size_t size)
+{
+    if (bytes < 1024 * 1024) {
+        std::snprintf(out, size, "%.0f KB", bytes / 1024.0);
+    }
+    else {
+        std::snprintf(out, size, "%.1f MB", bytes / (1024.0 * 1024.0));
+    }
+}
+
+PerfHud::PerfHud()
+    : bars(kGraphSamples * 2)
+{
+    for (int i = 0; i < kGraphSamples; ++i) {
+        for (int j = 0; j < 2; ++j) {
+            GraphVertex& v = bars[i * 2 + j];
+            v.x = i + 0.5f;
+            v.y = 0.0f;
+            std::fill(v.color, v.color + 4, (GLubyte)0);
+        }
+    }
+}
+
+void PerfHud::BeginFrame()
+{
+    int64_t now = Profiler::Now();
+    if (lastFrame != 0) {
+        double ms = (now - lastFrame) / 1e6;
+        GraphVertex* bar = &bars[(frameCount % kGraphSamples) * 2];
+        bar[1].y = (float)std::min(ms, kGraphRangeMs);
+        FrameColor(ms, bar[0].color);
+        FrameColor(ms, bar[1].color);
+        ++frameCount;
+
+        ++windowFrames;
+        windowMs += ms;
+        windowMaxMs = std::max(windowMaxMs, ms);
+    }
+    lastFrame = now;
+}
+
+void PerfHud::Create()
+{
+    std::vector<GLubyte> pixels((size_t)kAtlasWidth * kAtlasHeight, 0);
+    for (int c = 0; c <= kSolidCell; ++c) {
+        const int cellX = (c % kAtlasColumns) * kCharWidth;
+        const int cellY = (c / kAtlasColumns) * kCharHeight;
+        for (int row = 0; row < kCharHeight; ++row) {
+            GLubyte bits = c < kSolidCell ? kFont[c * kCharHeight + row] : 0xff;
+            for (int bit = 0; bit < kCharWidth; ++bit) {
+                if (bits & (0x80 >> bit)) {
+                    pixels[(size_t)(cellY + row) * kAtlasWidth + cellX + bit] = 255;
+                }
+            }
+        }
+    }
+
+    glPushAttrib(GL_TEXTURE_BIT);
+    glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glGenTextures(1, &fontTexture);
+    glBindTexture(GL_TEXTURE_2D, fontTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA8, kAtlasWidth, kAtlasHeight, 0,
+        GL_ALPHA, GL_UNSIGNED_BYTE, pixels.data());
+    glPopClientAttrib();
+    glPopAttrib();
+
+    glGenBuffers(1, &textBuffer);
+    glGenBuffers(1, &graphBuffer);
+    glBindBuffer(GL_ARRAY_BUFFER, graphBuffer);
+    glBufferData(GL_ARRAY_BUFFER, bars.size() * sizeof(GraphVertex), bars.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    uploadedCount = frameCount;
+}
+
+void PerfHud::Delete()
+{
+    if (fontTexture != 0) glDeleteTextures(1, &fontTexture);
+    if (textBuffer != 0) glDeleteBuffers(1, &textBuffer);
+    if (graphBuffer != 0) glDeleteBuffers(1, &graphBuffer);
+    fontTexture = textBuffer = graphBuffer = 0;
+    textVertexCount = 0;
+    builtWidth = builtHeight = 0;
+}
+
+void PerfHud::AddRect(float x0, float y0, float x1, float y1, const GLubyte color[4])
+{
+    // Every corner samples the middle of the solid cell
+    const float u = ((kSolidCell % kAtlasColumns) * kCharWidth + kCharWidth * 0.5f) / kAtlasWidth;
+    const float v = ((kSolidCell / kAtlasColumns) * kCharHeight + kCharHeight * 0.5f) / kAtlasHeight;
+    const float corners[4][2] = { { x0, y0 }, { x1, y0 }, { x1, y1 }, { x0, y1 } };
+    for (const auto& p : corners) {
+        TextVertex vertex = { p[0], p[1], u, v, { color[0], color[1], color[2], color[3] } };
+        textVertices.push_back(vertex);
+    }
+}
+
+void PerfHud::AddText(float x, float y, const char* text, const GLubyte color[4])
+{
+    // y is the bottom of the cell; spaces get no quad
+    for (; *text; ++text, x += kCharWidth) {
+        int c = (unsigned char)*text;
+        if (c == ' ') continue;
+        if (c < 32 || c > 126) c = '?';
+        const int cell = c - 32;
+        const float u0 = (float)((cell % kAtlasColumns) * kCharWidth) / kAtlasWidth;
+        const float v0 = (float)((cell / kAtlasColumns) * kCharHeight) / kAtlasHeight;
+        const float u1 = u0 + (float)kCharWidth / kAtlasWidth;
+        const float v1 = v0 + (float)kCharHeight / kAtlasHeight;
+        const TextVertex quad[4] = {
+            { x, y, u0, v1, { color[0], color[1], color[2], color[3] } },
+            { x + kCharWidth, y, u1, v1, { color[0], color[1], color[2], color[3] } },
+            { x + kCharWidth, y + kCharHeight, u1, v0, { color[0], color[1], color[2], color[3] } },
+            { x, y + kCharHeight, u0, v0, { color[0], color[1], color[2], color[3] } },
+        };
+        textVertices.insert(textVertices.end(), quad, quad + 4);
+    }
+}
+
+void PerfHud::BuildText(int w, int h, const Counters& counters, const std::vector<Profiler::PhaseTiming>& phases)
+{
+    // Room for the longest numbers; lines are cut to the panel width below
+    char lines[16][64];
+    const int lineBytes = (int)sizeof(lines[0]);
+    int lineCount = 0;
+
+    // Title line: averages since the last rebuild
+    const double avgMs = windowFrames > 0 ? windowMs / windowFrames : 0.0;
+    std::snprintf(lines[lineCount++], lineBytes, "%.1f FPS  %.2f ms  (max %.2f ms)",
+        avgMs > 0.0 ? 1000.0 / avgMs : 0.0, avgMs, windowMaxMs);
+
+    char bytes[4][16];
+    FormatBytes(counters.textureBytes, bytes[0], sizeof(bytes[0]));
+    FormatBytes(counters.arrayBytes, bytes[1], sizeof(bytes[1]));
+    FormatBytes(counters.streamedBytes, bytes[2], sizeof(bytes[2]));
+    FormatBytes(counters.streamBudget, bytes[3], sizeof(bytes[3]));
+    std::snprintf(lines[lineCount++], lineBytes, "Renderer     %s", counters.renderer);
+    std::snprintf(lines[lineCount++], lineBytes, "Draw calls   %d", counters.drawCalls);
+    std::snprintf(lines[lineCount++], lineBytes, "State calls  %d set, %d skipped",
+        counters.stateChanges, counters.redundantStates);
+    std::snprintf(lines[lineCount++], lineBytes, "Objects      %u visible, %u culled",
+        (unsigned)counters.visibleObjects, (unsigned)counters.culledObjects);
+    std::snprintf(lines[lineCount++], lineBytes, "Textures     %s + %s array", bytes[0], bytes[1]);
+    std::snprintf(lines[lineCount++], lineBytes, "Streamed     %s of %s budget", bytes[2], bytes[3]);
+
+    // The slowest scopes of the last frame (times include nested scopes)
+    std::vector<Profiler::PhaseTiming> top;
+    for (const Profiler::PhaseTiming& phase : phases) {
+        if (phase.cpuMs > 0.0 || phase.gpuMs > 0.0) top.push_back(phase);
+    }
+    std::sort(top.begin(), top.end(), [](const Profiler::PhaseTiming& a, const Profiler::PhaseTiming& b) {
+        return a.cpuMs + a.gpuMs > b.cpuMs + b.gpuMs;
+    });
+    top.resize(std::min(top.size(), (size_t)kMaxPhases));
+    const int phaseTitle = lineCount;
+    std::snprintf(lines[lineCount++], lineBytes, "%-26s%7s%7s", "Phase (ms)", "CPU", "GPU");
+    if (top.empty()) {
+        std::snprintf(lines[lineCount++], lineBytes, "  (no profiler scopes)");
+    }
+    for (const Profiler::PhaseTiming& phase : top) {
+        char gpu[16] = "-";
+        if (phase.gpuMs > 0.0) std::snprintf(gpu, sizeof(gpu), "%.2f", phase.gpuMs);
+        std::snprintf(lines[lineCount++], lineBytes, "%-26.26s%7.2f%7s", phase.name, phase.cpuMs, gpu);
+    }
+    for (int i = 0; i < lineCount; ++i) {
+        lines[i][kColumns] = '\0';
+    }
+
+    // Panel in the top right corner: title, graph, then the other lines
+    const int panelWidth = kGraphSamples + 2 * kPadding;
+    const int panelHeight = 2 * kPadding + 2 * kCharHeight + 8 + kGraphHeight + (lineCount - 2) * kLineHeight;
+    const float left = (float)(w - kMargin - panelWidth);
+    const float top0 = (float)(h - kMargin);
+    const float x = left + kPadding;
+    float y = top0 - kPadding - kCharHeight;
+
+    textVertices.clear();
+    AddRect(left, top0 - panelHeight, left + panelWidth, top0, kPanelColor);
+    AddText(x, y, lines[0], kTitleColor);
+
+    graphX = x;
+    graphY = y - 4 - kGraphHeight;
+    AddRect(graphX, graphY, graphX + kGraphSamples, graphY + 1, kGridColor);
+    for (double ms : { 1000.0 / 60.0, 1000.0 / 30.0 }) {
+        float lineY = graphY + (float)(int)(ms / kGraphRangeMs * kGraphHeight);
+        AddRect(graphX, lineY, graphX + kGraphSamples, lineY + 1, kGridColor);
+    }
+
+    y = graphY - 4 - kCharHeight;
+    for (int i = 1; i < lineCount; ++i, y -= kLineHeight) {
+        AddText(x, y, lines[i], i == phaseTitle ? kTitleColor : kTextColor);
+    }
+
+    // Fresh storage each rebuild; a frame still reading the old one keeps it
+    textVertexCount = (GLsizei)textVertices.size();
+    glBindBuffer(GL_ARRAY_BUFFER, textBuffer);
+    glBufferData(GL_ARRAY_BUFFER, textVertices.size() * sizeof(TextVertex), textVertices.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    builtWidth = w;
+    builtHeight = h;
+    windowFrames = 0;
+    windowMs = windowMaxMs = 0.0;
+}
+
+void PerfHud::UploadGraph()
+{
+    if (uploadedCount == frameCount) {
+        return;
+    }
+
+    // Usually the one bar since the last Draw; all of them after a pause
+    const uint64_t pending = std::min(frameCount - uploadedCount, (uint64_t)kGraphSamples);
+    const int first = (int)((frameCount - pending) % kGraphSamples);
+    const int count = (int)pending;
+    const int tail = std::min(count, kGraphSamples - first);
+    glBindBuffer(GL_ARRAY_BUFFER, graphBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, first * 2 * sizeof(GraphVertex), tail * 2 * sizeof(GraphVertex), &bars[first * 2]);
+    if (count > tail) {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (count - tail) * 2 * sizeof(GraphVertex), bars.data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    uploadedCount = frameCount;
+}
+
+void PerfHud::Draw(int w, int h, const Counters& counters, const std::vector<Profiler::PhaseTiming>& phases)
+{
+    PROFILE_SCOPE("PerfHud::Draw");
+    if (fontTexture == 0) {
+        Create();
+    }
+    const int64_t now = Profiler::Now();
+    if (w != builtWidth || h != builtHeight || now - lastRefresh >= kRefreshNs) {
+        BuildText(w, h, counters, phases);
+        lastRefresh = now;
+    }
+    UploadGraph();
+
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(0, w, 0, h, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+    glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_CURRENT_BIT | GL_TEXTURE_BIT | GL_POLYGON_BIT | GL_LINE_BIT);
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+    glDisable(GL_LIGHTING);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    glLineWidth(1.0f);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+
+    // Panel, grid lines and text: one call
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, fontTexture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, textBuffer);
+    glVertexPointer(2, GL_FLOAT, sizeof(TextVertex), (const void*)offsetof(TextVertex, x));
+    glTexCoordPointer(2, GL_FLOAT, sizeof(TextVertex), (const void*)offsetof(TextVertex, u));
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(TextVertex), (const void*)offsetof(TextVertex, color));
+    glDrawArrays(GL_QUADS, 0, textVertexCount);
+
+    // Bars, oldest on the left: ring slots [head, end) then [0, head),
+    // shifted into place and scaled from milliseconds to pixels
+    glDisable(GL_TEXTURE_2D);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, graphBuffer);
+    glVertexPointer(2, GL_FLOAT, sizeof(GraphVertex), (const void*)offsetof(GraphVertex, x));
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(GraphVertex), (const void*)offsetof(GraphVertex, color));
+    const int head = (int)(frameCount % kGraphSamples);
+    const float scale = (float)(kGraphHeight / kGraphRangeMs);
+    glTranslatef(graphX - head, graphY, 0.0f);
+    glScalef(1.0f, scale, 1.0f);
+    glDrawArrays(GL_LINES, head * 2, (kGraphSamples - head) * 2);
+    if (head > 0) {
+        glLoadIdentity();
+        glTranslatef(graphX + kGraphSamples - head, graphY, 0.0f);
+        glScalef(1.0f, scale, 1.0f);
+        glDrawArrays(GL_LINES, 0, head * 2);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glPopClientAttrib();
+    glPopAttrib();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+}
@@ -0,0 +1,95 @@
+// PerfHud.h
+#pragma once
+#include <GL/freeglut.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Profiler.h"
+
+// Performance overlay in the top right corner: a frame time graph, FPS,
+// the frame's counters and the profiler's per-phase timings.
+//
+// It draws from two vertex buffers with a built-in 8x11 bitmap font, three
+// draw calls in all, instead of a glutBitmapCharacter per glyph, and needs
+// no GLUT (so it works headless too). The text buffer is only rebuilt a
+// few times a second; the graph is a ring of one-pixel bars that gets one
+// new bar per frame. None of its calls go through RenderState, so they
+// don't show up in the counters it displays.
+class PerfHud {
+public:
+    // What the engine counted for the frame being shown
+    struct Counters {
+        int drawCalls;
+        int stateChanges;
+        int redundantStates;
+        size_t visibleObjects;
+        size_t culledObjects;
+        size_t textureBytes;    // loaded textures
+        size_t arrayBytes;      // their copy in the texture array
+        size_t streamedBytes;   // streamed mip levels on the GPU
+        size_t streamBudget;
+        const char* renderer;
+    };
+
+    PerfHud();
+
+    // Frame boundary, called every frame whether the HUD is shown or not,
+    // so the graph is already filled when it is turned on
+    void BeginFrame();
+
+    // Draw over a w x h viewport. Creates the GL objects on first use
+    void Draw(int w, int h, const Counters& counters, const std::vector<Profiler::PhaseTiming>& phases);
+
+    // Free the GL objects
+    void Delete();
+
+private:
+    PerfHud(const PerfHud&) = delete;
+    PerfHud& operator=(const PerfHud&) = delete;
+
+    static const int kColumns = 40;                 // characters per line
+    static const int kGraphSamples = kColumns * 8;  // one bar per pixel across
+    static const int kMaxPhases = 8;
+
+    struct TextVertex {
+        float x, y, u, v;
+        GLubyte color[4];
+    };
+
+    struct GraphVertex {
+        float x, y;
+        GLubyte color[4];
+    };
+
+    // Font atlas (GL_ALPHA, one cell per printable ASCII character plus a
+    // solid cell for rectangles) and the two buffers
+    void Create();
+
+    // Lay out the panel for the numbers now, into textBuffer
+    void BuildText(int w, int h, const Counters& counters, const std::vector<Profiler::PhaseTiming>& phases);
+    void AddRect(float x0, float y0, float x1, float y1, const GLubyte color[4]);
+    void AddText(float x, float y, const char* text, const GLubyte color[4]);
+
+    // Send the bars added since the last Draw to graphBuffer
+    void UploadGraph();
+
+    GLuint fontTexture = 0;
+    GLuint textBuffer = 0;
+    GLuint graphBuffer = 0;
+    GLsizei textVertexCount = 0;
+    std::vector<TextVertex> textVertices;
+    int builtWidth = 0, builtHeight = 0;
+    float graphX = 0.0f, graphY = 0.0f;     // graph origin, from BuildText
+
+    // Frame times: two vertices per bar, slot = frame % kGraphSamples
+    std::vector<GraphVertex> bars;
+    uint64_t frameCount = 0;        // bars written
+    uint64_t uploadedCount = 0;     // of those, in graphBuffer
+    int64_t lastFrame = 0;
+
+    // Frames since the text was last rebuilt, for its averages
+    int64_t lastRefresh = 0;
+    int windowFrames = 0;
+    double windowMs = 0.0;
+    double windowMaxMs = 0.0;
+};
@@ -0,0 +1,137 @@
+// PixelUploadRing.cpp
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+#include "PixelUploadRing.h"
+#include <cstdint>
+#include <cstring>
+
+PixelUploadRing* PixelUploadRing::instance = nullptr;
+
+PixelUploadRing::PixelUploadRing(size_t bytes, int segments)
+    : size(bytes),
+    segmentCount(segments < 2 ? 2 : segments),
+    segmentSize(bytes / (segments < 2 ? 2 : segments))
+{
+}
+
+void PixelUploadRing::Init()
+{
+    if (buffer != 0) {
+        return;
+    }
+
+    if (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)size, nullptr, flags);
+        mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)size, flags);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        if (mapped) {
+            fences = new GLsync[segmentCount]();
+            mode = Mode::Persistent;
+            return;
+        }
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+
+    if (GLEW_VERSION_2_1 || GLEW_ARB_pixel_buffer_object) {
+        glGenBuffers(1, &buffer);
+        mapRange = GLEW_VERSION_3_0 || GLEW_ARB_map_buffer_range;
+        mode = Mode::Orphan;
+    }
+}
+
+void PixelUploadRing::Delete()
+{
+    if (fences) {
+        for (int i = 0; i < segmentCount; ++i) {
+            if (fences[i]) glDeleteSync(fences[i]);
+        }
+        delete[] fences;
+        fences = nullptr;
+    }
+    if (buffer != 0) {
+        if (mapped) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            mapped = nullptr;
+        }
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+    mode = Mode::None;
+    mapRange = false;
+    bound = false;
+}
+
+const void* PixelUploadRing::Stage(const void* data, size_t bytes)
+{
+    // Pointers into client memory must not be read as buffer offsets
+    Finish();
+
+    if (mode == Mode::Orphan) {
+        // Fresh storage every time; the driver keeps the old one alive for
+        // copies still in flight. GL 2.1 without map_buffer_range maps the
+        // whole (just orphaned) buffer instead
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, (GLsizeiptr)bytes, nullptr, GL_STREAM_DRAW);
+        void* dst = mapRange
+            ? glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, (GLsizeiptr)bytes,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT)
+            : glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+        if (dst) {
+            std::memcpy(dst, data, bytes);
+            if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+                bound = true;
+                stagedBytes += bytes;
+                return nullptr;     // offset 0
+            }
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        directBytes += bytes;
+        return data;
+    }
+
+    if (mode != Mode::Persistent || bytes > segmentSize) {
+        directBytes += bytes;
+        return data;
+    }
+
+    size_t offset = (head + 15) & ~(size_t)15;
+    if (offset + bytes > segmentSize) {
+        // Move on only if the GPU is done with the next segment; waiting
+        // here would be the very stall the ring exists to avoid
+        int next = (segment + 1) % segmentCount;
+        if (fences[next]) {
+            GLenum status = glClientWaitSync(fences[next], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+            if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+                directBytes += bytes;
+                return data;
+            }
+            glDeleteSync(fences[next]);
+            fences[next] = 0;
+        }
+        fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        segment = next;
+        offset = 0;
+    }
+
+    size_t start = (size_t)segment * segmentSize + offset;
+    std::memcpy(mapped + start, data, bytes);
+    head = offset + bytes;
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+    bound = true;
+    stagedBytes += bytes;
+    return reinterpret_cast<const void*>((uintptr_t)start);
+}
+
+void PixelUploadRing::Finish()
+{
+    if (bound) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        bound = false;
+    }
+}
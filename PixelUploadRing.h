@@ -0,0 +1,66 @@
+// PixelUploadRing.h
+#pragma once
+#include <GL/freeglut.h>
+#include <cstddef>
+
+// Staging memory for texture uploads in a pixel-unpack buffer, so
+// glTexImage2D returns once the copy is queued instead of after the
+// driver has read the caller's pixels.
+//
+// With ARB_buffer_storage the buffer is mapped once (persistent, coherent)
+// and split into segments used round-robin; leaving a segment fences it,
+// and it is written again only after the GPU has passed that fence.
+// Without it every upload orphans the buffer and maps fresh storage
+// (with glMapBuffer where glMapBufferRange is missing).
+// Data that doesn't fit (or would have to wait for the GPU) is handed
+// back for a plain client-memory upload rather than stalling the frame.
+class PixelUploadRing {
+public:
+    // The ring for the current GL context (set by the Engine that owns it)
+    static PixelUploadRing* instance;
+
+    explicit PixelUploadRing(size_t bytes = 32u * 1024 * 1024, int segments = 4);
+
+    // Create the buffer; needs the GL context. Unsupported GL leaves the
+    // ring disabled and Stage hands every upload back
+    void Init();
+
+    // Free the buffer and fences
+    void Delete();
+
+    bool IsSupported() const { return mode != Mode::None; }
+    bool IsPersistent() const { return mode == Mode::Persistent; }
+
+    // Copy size bytes into staging memory and leave the buffer bound to
+    // GL_PIXEL_UNPACK_BUFFER. Returns what to pass as the pixel pointer:
+    // an offset into the buffer, or data itself (nothing bound) when the
+    // upload can't be staged
+    const void* Stage(const void* data, size_t size);
+
+    // Unbind the buffer after the GL calls that read the staged data
+    void Finish();
+
+    // Bytes that went through the buffer / were uploaded from client memory
+    size_t GetStagedBytes() const { return stagedBytes; }
+    size_t GetDirectBytes() const { return directBytes; }
+
+private:
+    PixelUploadRing(const PixelUploadRing&) = delete;
+    PixelUploadRing& operator=(const PixelUploadRing&) = delete;
+
+    enum class Mode { None, Persistent, Orphan };
+
+    Mode   mode = Mode::None;
+    bool   mapRange = false;                // orphan mode: glMapBufferRange available
+    GLuint buffer = 0;
+    size_t size;
+    int    segmentCount;
+    size_t segmentSize;
+    unsigned char* mapped = nullptr;    // persistent mapping
+    GLsync* fences = nullptr;           // one per segment, 0 when free
+    int    segment = 0;                 // segment being filled
+    size_t head = 0;                    // next free byte in it
+    bool   bound = false;
+    size_t stagedBytes = 0;
+    size_t directBytes = 0;
+};
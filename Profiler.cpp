@@ -0,0 +1,311 @@
+// Profiler.cpp
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+Profiler* Profiler::instance = nullptr;
+
+static std::atomic<uint64_t> nextProfilerId(1);
+
+Profiler::Profiler()
+    : profilerId(nextProfilerId.fetch_add(1)),
+    capturing(false),
+    recording(false)
+{
+    gpuTrack = AddBuffer("GPU");
+}
+
+Profiler::~Profiler()
+{
+    if (instance == this) {
+        instance = nullptr;
+    }
+}
+
+int64_t Profiler::Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Profiler::ThreadBuffer* Profiler::AddBuffer(const std::string& name)
+{
+    std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+    buffer->events.reset(new Event[kRingSize]);
+    buffer->head.store(0);
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffer->id = (int)buffers.size();
+    buffer->name = name.empty() ? "Thread " + std::to_string(buffer->id) : name;
+    buffers.push_back(std::move(buffer));
+    return buffers.back().get();
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+{
+    // Cached per thread; the id keeps a later Profiler from reusing a
+    // buffer that belonged to an earlier one
+    thread_local uint64_t owner = 0;
+    thread_local ThreadBuffer* buffer = nullptr;
+    if (owner != profilerId) {
+        buffer = AddBuffer("");
+        owner = profilerId;
+    }
+    return buffer;
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+    ThreadBuffer* buffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffer->name = name;
+}
+
+void Profiler::Push(ThreadBuffer& buffer, const char* name, int64_t start, int64_t end)
+{
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    Event& e = buffer.events[head & (kRingSize - 1)];
+    e.name = name;
+    e.start = start;
+    e.end = end;
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::Record(const char* name, int64_t start, int64_t end)
+{
+    Push(*GetThreadBuffer(), name, start, end);
+}
+
+void Profiler::StartCapture(int frames, const std::string& path)
+{
+    if (IsCapturing()) {
+        return;
+    }
+    framesLeft = frames > 0 ? frames : 1;
+    framesCaptured = 0;
+    capturePath = path;
+    frameStarts.clear();
+    captureStart = Now();
+    capturing.store(true, std::memory_order_relaxed);
+    recording.store(true, std::memory_order_relaxed);
+}
+
+void Profiler::SetLiveTimings(bool value)
+{
+    if (value && !liveTimings) {
+        // Start summing from now, not from whatever a capture left behind
+        phaseHead = GetThreadBuffer()->head.load(std::memory_order_relaxed);
+        phases.clear();
+        gpuPending.clear();
+    }
+    liveTimings = value;
+    recording.store(value || IsCapturing(), std::memory_order_relaxed);
+}
+
+void Profiler::BeginFrame()
+{
+    CollectGpu(false);
+    if (liveTimings) {
+        SumCpuPhases();
+    }
+    ++frameIndex;
+    if (!IsCapturing()) {
+        return;
+    }
+    if (framesLeft == 0) {
+        Finish();
+        return;
+    }
+    --framesLeft;
+    ++framesCaptured;
+    frameStarts.push_back(Now());
+}
+
+void Profiler::Finish()
+{
+    if (!IsCapturing()) {
+        return;
+    }
+    capturing.store(false, std::memory_order_relaxed);
+    recording.store(liveTimings, std::memory_order_relaxed);
+    CollectGpu(true);
+    WriteTrace();
+}
+
+void Profiler::Delete()
+{
+    for (const GpuQuery& q : pendingQueries) {
+        freeQueries.push_back(q.query);
+    }
+    pendingQueries.clear();
+    if (!freeQueries.empty()) {
+        glDeleteQueries((GLsizei)freeQueries.size(), freeQueries.data());
+        freeQueries.clear();
+    }
+}
+
+GLuint Profiler::BeginGpu()
+{
+    if (gpuSupport < 0) {
+        gpuSupport = (GLEW_VERSION_3_3 || GLEW_ARB_timer_query) ? 1 : 0;
+        if (!gpuSupport) {
+            std::cerr << "No GL timer queries, profiling CPU time only\n";
+        }
+    }
+    if (!gpuSupport || gpuActive) {
+        return 0;
+    }
+
+    GLuint query;
+    if (freeQueries.empty()) {
+        glGenQueries(1, &query);
+    }
+    else {
+        query = freeQueries.back();
+        freeQueries.pop_back();
+    }
+    glBeginQuery(GL_TIME_ELAPSED, query);
+    gpuActive = true;
+    return query;
+}
+
+void Profiler::EndGpu(GLuint query, const char* name, int64_t start)
+{
+    glEndQuery(GL_TIME_ELAPSED);
+    gpuActive = false;
+    pendingQueries.push_back({ query, name, start, frameIndex });
+}
+
+void Profiler::CollectGpu(bool all)
+{
+    // Queries finish in the order they were issued
+    size_t done = 0;
+    for (; done < pendingQueries.size(); ++done) {
+        const GpuQuery& q = pendingQueries[done];
+        if (!all) {
+            GLuint available = 0;
+            glGetQueryObjectuiv(q.query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                break;
+            }
+        }
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(q.query, GL_QUERY_RESULT, &ns);
+        Push(*gpuTrack, q.name, q.start, q.start + (int64_t)ns);
+        if (liveTimings) {
+            AddGpuPhase(q.name, q.frame, (int64_t)ns);
+        }
+        freeQueries.push_back(q.query);
+    }
+    pendingQueries.erase(pendingQueries.begin(), pendingQueries.begin() + done);
+}
+
+size_t Profiler::FindPhase(const char* name)
+{
+    // The same literal in two files may have two addresses
+    for (size_t i = 0; i < phases.size(); ++i) {
+        if (phases[i].name == name) return i;
+    }
+    for (size_t i = 0; i < phases.size(); ++i) {
+        if (std::strcmp(phases[i].name, name) == 0) return i;
+    }
+    phases.push_back({ name, 0.0, 0.0 });
+    gpuPending.push_back(0.0);
+    return phases.size() - 1;
+}
+
+void Profiler::SumCpuPhases()
+{
+    // Only this thread writes its ring, so no need to check for overwrites
+    ThreadBuffer* buffer = GetThreadBuffer();
+    uint64_t end = buffer->head.load(std::memory_order_relaxed);
+    uint64_t begin = std::max(phaseHead, end > kRingSize ? end - kRingSize : 0);
+    for (PhaseTiming& phase : phases) {
+        phase.cpuMs = 0.0;
+    }
+    for (uint64_t i = begin; i < end; ++i) {
+        const Event& e = buffer->events[i & (kRingSize - 1)];
+        phases[FindPhase(e.name)].cpuMs += (e.end - e.start) / 1e6;
+    }
+    phaseHead = end;
+}
+
+void Profiler::AddGpuPhase(const char* name, uint64_t frame, int64_t ns)
+{
+    // Results come in issue order: the first one of a newer frame means
+    // the sums for the previous frame are complete
+    if (frame != gpuPhaseFrame) {
+        for (size_t i = 0; i < phases.size(); ++i) {
+            phases[i].gpuMs = gpuPending[i];
+            gpuPending[i] = 0.0;
+        }
+        gpuPhaseFrame = frame;
+    }
+    size_t i = FindPhase(name);
+    gpuPending[i] += ns / 1e6;
+}
+
+void Profiler::WriteTrace()
+{
+    FILE* f = std::fopen(capturePath.c_str(), "w");
+    if (!f) {
+        std::cerr << "Cannot write profile to " << capturePath << "\n";
+        return;
+    }
+
+    std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    std::fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"3D Engine\"}}");
+
+    size_t eventCount = 0;
+    std::vector<Event> events;
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (const std::unique_ptr<ThreadBuffer>& buffer : buffers) {
+        // Copy the ring, then drop entries the thread may have overwritten
+        // while we were reading
+        uint64_t end = buffer->head.load(std::memory_order_acquire);
+        uint64_t begin = end > kRingSize ? end - kRingSize : 0;
+        events.clear();
+        for (uint64_t i = begin; i < end; ++i) {
+            events.push_back(buffer->events[i & (kRingSize - 1)]);
+        }
+        uint64_t after = buffer->head.load(std::memory_order_acquire);
+        size_t skip = after > kRingSize + begin ? (size_t)(after - kRingSize - begin) : 0;
+
+        const int tid = buffer->id + 1;
+        std::fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            tid, buffer->name.c_str());
+        std::fprintf(f, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"sort_index\":%d}}",
+            tid, tid);
+        bool dropped = end - begin == kRingSize;
+        for (size_t i = skip; i < events.size(); ++i) {
+            const Event& e = events[i];
+            if (e.start < captureStart) {
+                dropped = false;    // the ring reaches back past the capture
+                continue;
+            }
+            std::fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                e.name, buffer.get() == gpuTrack ? "gpu" : "cpu", tid,
+                (e.start - captureStart) / 1000.0, (e.end - e.start) / 1000.0);
+            ++eventCount;
+        }
+        if (dropped) {
+            std::cerr << "Profile: \"" << buffer->name << "\" recorded more than "
+                << kRingSize << " events, the oldest are missing\n";
+        }
+    }
+
+    // Frame boundaries as global instant events
+    for (size_t i = 0; i < frameStarts.size(); ++i) {
+        std::fprintf(f, ",\n{\"name\":\"Frame %u\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":%.3f}",
+            (unsigned)i, (frameStarts[i] - captureStart) / 1000.0);
+    }
+    std::fprintf(f, "\n]}\n");
+    std::fclose(f);
+
+    std::cout << "Profile of " << framesCaptured << " frames (" << eventCount
+        << " events) written to " << capturePath << "\n";
+}
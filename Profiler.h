@@ -0,0 +1,187 @@
+// Profiler.h
+#pragma once
+#include <GL/freeglut.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Build with ENGINE_PROFILER=0 to compile every scope out
+#ifndef ENGINE_PROFILER
+#define ENGINE_PROFILER 1
+#endif
+
+// Frame profiler: named CPU scopes on any thread, plus GL_TIME_ELAPSED
+// scopes on the GL thread, captured for a number of frames and written as a
+// Chrome trace (open it in chrome://tracing or ui.perfetto.dev).
+//
+// Every thread records into its own fixed-size ring of events, so closing a
+// scope is a few stores and one atomic increment, without locks. Outside a
+// capture a scope costs one relaxed load and a branch. GPU timings are read
+// back a few frames later, once their queries are done, and shown on a GPU
+// track starting where their CPU side began. GL allows one elapsed-time
+// query at a time, so a GPU scope opened inside another records nothing.
+//
+// Live timings (for the performance HUD) keep scopes recording outside a
+// capture too and sum the GL thread's scopes per name every frame.
+class Profiler {
+public:
+    // The profiler the scope macros record into (set by the Engine owning it)
+    static Profiler* instance;
+
+    Profiler();
+    ~Profiler();
+
+    // Record the next `frames` frames, then write them to path
+    void StartCapture(int frames, const std::string& path);
+    bool IsCapturing() const { return capturing.load(std::memory_order_relaxed); }
+
+    // Whether scopes record now: during a capture or with live timings on
+    bool IsRecording() const { return recording.load(std::memory_order_relaxed); }
+
+    // Per-frame totals of the scopes named `name` on the GL thread: CPU time
+    // of the last frame, GPU time of the newest frame whose queries are done
+    struct PhaseTiming {
+        const char* name;
+        double cpuMs;
+        double gpuMs;
+    };
+
+    // Sum scopes into GetPhaseTimings at every BeginFrame (off by default)
+    void SetLiveTimings(bool value);
+    bool GetLiveTimings() const { return liveTimings; }
+    const std::vector<PhaseTiming>& GetPhaseTimings() const { return phases; }
+
+    // Frame boundary, on the GL thread before the frame's first scope:
+    // collects finished GPU timings and ends a capture whose frames are done
+    void BeginFrame();
+
+    // End a capture still running now (waiting for its GPU timings) and
+    // write it out. Needs the GL context
+    void Finish();
+
+    // Delete the GL queries (GL thread)
+    void Delete();
+
+    // Track name for the calling thread (default "Thread N")
+    void SetThreadName(const char* name);
+
+    // For the scope classes below
+    static int64_t Now();       // nanoseconds, steady clock
+    void Record(const char* name, int64_t start, int64_t end);
+    GLuint BeginGpu();          // 0: not timed
+    void EndGpu(GLuint query, const char* name, int64_t start);
+
+private:
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    static const uint64_t kRingSize = 1 << 16;     // events per thread
+
+    struct Event {
+        const char* name;
+        int64_t start, end;
+    };
+
+    // One producer (its thread) and readers that check head again after
+    // copying, dropping whatever may have been overwritten meanwhile
+    struct ThreadBuffer {
+        std::unique_ptr<Event[]> events;
+        std::atomic<uint64_t> head;
+        int id;
+        std::string name;
+    };
+
+    struct GpuQuery {
+        GLuint query;
+        const char* name;
+        int64_t start;
+        uint64_t frame;
+    };
+
+    static void Push(ThreadBuffer& buffer, const char* name, int64_t start, int64_t end);
+    ThreadBuffer* GetThreadBuffer();
+    ThreadBuffer* AddBuffer(const std::string& name);
+
+    // Move finished GPU timings to gpuTrack; wait for all of them if `all`
+    void CollectGpu(bool all);
+
+    void WriteTrace();
+
+    // Live timings: sum the GL thread's scopes since the last frame, and
+    // the GPU results of frame `frame` as they are collected
+    size_t FindPhase(const char* name);
+    void SumCpuPhases();
+    void AddGpuPhase(const char* name, uint64_t frame, int64_t ns);
+
+    const uint64_t profilerId;          // tells thread_local caches apart
+    std::atomic<bool> capturing;
+    std::atomic<bool> recording;
+    int framesLeft = 0;
+    int framesCaptured = 0;
+    int64_t captureStart = 0;
+    std::string capturePath;
+    std::vector<int64_t> frameStarts;
+
+    std::mutex buffersMutex;            // registration and names only
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    ThreadBuffer* gpuTrack = nullptr;
+
+    int gpuSupport = -1;                // -1: not checked yet
+    bool gpuActive = false;
+    std::vector<GLuint> freeQueries;
+    std::vector<GpuQuery> pendingQueries;
+
+    bool liveTimings = false;
+    uint64_t frameIndex = 0;
+    uint64_t phaseHead = 0;             // GL thread's ring, summed up to here
+    uint64_t gpuPhaseFrame = 0;         // frame the gpuPending sums are for
+    std::vector<PhaseTiming> phases;
+    std::vector<double> gpuPending;     // per phase, frame gpuPhaseFrame
+};
+
+// CPU time of the enclosing block
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name)
+        : name(name),
+        start(Profiler::instance && Profiler::instance->IsRecording() ? Profiler::Now() : -1)
+    {}
+    ~ProfileScope() {
+        if (start >= 0) Profiler::instance->Record(name, start, Profiler::Now());
+    }
+
+private:
+    const char* name;
+    int64_t start;
+};
+
+// GPU time of the GL commands issued in the enclosing block (GL thread)
+class GpuProfileScope {
+public:
+    explicit GpuProfileScope(const char* name)
+        : name(name),
+        query(Profiler::instance && Profiler::instance->IsRecording() ? Profiler::instance->BeginGpu() : 0),
+        start(query != 0 ? Profiler::Now() : 0)
+    {}
+    ~GpuProfileScope() {
+        if (query != 0) Profiler::instance->EndGpu(query, name, start);
+    }
+
+private:
+    const char* name;
+    GLuint query;
+    int64_t start;
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#if ENGINE_PROFILER
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_GPU_SCOPE(name) ((void)0)
+#endif
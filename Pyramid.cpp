@@ -1,164 +1,52 @@
 ﻿// Pyramid.cpp
-#include <GL/glew.h>
-#include <GL/freeglut.h>
-#include <glm/gtc/type_ptr.hpp>
 #include "Pyramid.h"
 #include "Engine.h"
+#include "Mesh.h"
+#include <cmath>
 
-void Pyramid::Draw() {
-    //Bind the correct texture or unbind if none
-    if (Engine::instance && !Engine::instance->textures.empty()) {
-        if (IsTextured()) {
-            int idx = GetTexIndex() % (int)Engine::instance->textures.size();
-            Texture2D* tex = Engine::instance->textures[idx];
-            if (tex && tex->GetID() != 0) {
-                tex->Bind();
-            }
-            else {
-                Texture2D::Unbind();
-            }
-        }
-        else {
-            Texture2D::Unbind();
-        }
-    }
-    else {
-        // If no textures have been loaded ensure none is bound
-        Texture2D::Unbind();
-    }
-
-    // Apply this object's transform
-    glm::mat4 model = GetModelMatrix();
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glMultMatrixf(glm::value_ptr(model));
-
-    // Draw the filled faces (textured if bound, else flat white)
-    glEnable(GL_TEXTURE_2D);
-    glColor3f(1.0f, 1.0f, 1.0f);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-    // Triangular sides
-    glBegin(GL_TRIANGLES);
-    // Front
-    glNormal3f(0.0f, 0.4472f, 0.8944f);
-    if (IsTextured()) glTexCoord2f(0.5f, 1.0f);
-    glVertex3f(0.0f, 0.5f, 0.0f);
-    if (IsTextured()) glTexCoord2f(0.0f, 0.0f);
-    glVertex3f(-0.5f, -0.5f, 0.5f);
-    if (IsTextured()) glTexCoord2f(1.0f, 0.0f);
-    glVertex3f(0.5f, -0.5f, 0.5f);
-
-    // Right
-    glNormal3f(0.8944f, 0.4472f, 0.0f);
-    if (IsTextured()) glTexCoord2f(0.5f, 1.0f);
-    glVertex3f(0.0f, 0.5f, 0.0f);
-    if (IsTextured()) glTexCoord2f(0.0f, 0.0f);
-    glVertex3f(0.5f, -0.5f, 0.5f);
-    if (IsTextured()) glTexCoord2f(1.0f, 0.0f);
-    glVertex3f(0.5f, -0.5f, -0.5f);
-
-    // Back
-    glNormal3f(0.0f, 0.4472f, -0.8944f);
-    if (IsTextured()) glTexCoord2f(0.5f, 1.0f);
-    glVertex3f(0.0f, 0.5f, 0.0f);
-    if (IsTextured()) glTexCoord2f(0.0f, 0.0f);
-    glVertex3f(0.5f, -0.5f, -0.5f);
-    if (IsTextured()) glTexCoord2f(1.0f, 0.0f);
-    glVertex3f(-0.5f, -0.5f, -0.5f);
-
-    // Left
-    glNormal3f(-0.8944f, 0.4472f, 0.0f);
-    if (IsTextured()) glTexCoord2f(0.5f, 1.0f);
-    glVertex3f(0.0f, 0.5f, 0.0f);
-    if (IsTextured()) glTexCoord2f(0.0f, 0.0f);
-    glVertex3f(-0.5f, -0.5f, -0.5f);
-    if (IsTextured()) glTexCoord2f(1.0f, 0.0f);
-    glVertex3f(-0.5f, -0.5f, 0.5f);
-    glEnd();
-
-    // square base (textured if bound, else flat white)
-    glBegin(GL_QUADS);
-    glNormal3f(0.0f, -1.0f, 0.0f);
-    if (IsTextured()) glTexCoord2f(0.0f, 0.0f);
-    glVertex3f(-0.5f, -0.5f, 0.5f);
-    if (IsTextured()) glTexCoord2f(1.0f, 0.0f);
-    glVertex3f(0.5f, -0.5f, 0.5f);
-    if (IsTextured()) glTexCoord2f(1.0f, 1.0f);
-    glVertex3f(0.5f, -0.5f, -0.5f);
-    if (IsTextured()) glTexCoord2f(0.0f, 1.0f);
-    glVertex3f(-0.5f, -0.5f, -0.5f);
-    glEnd();
-
-    // Wireframe pass thin black edges for all faces
-    Texture2D::Unbind();               // ensure no texture when drawing lines
-    glLineWidth(1.0f);
-    glColor3f(0.0f, 0.0f, 0.0f);       // black
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-
-    // Triangular sides
-    glBegin(GL_TRIANGLES);
-    // Front
-    glVertex3f(0.0f, 0.5f, 0.0f);
-    glVertex3f(-0.5f, -0.5f, 0.5f);
-    glVertex3f(0.5f, -0.5f, 0.5f);
-    // Right
-    glVertex3f(0.0f, 0.5f, 0.0f);
-    glVertex3f(0.5f, -0.5f, 0.5f);
-    glVertex3f(0.5f, -0.5f, -0.5f);
-    // Back
-    glVertex3f(0.0f, 0.5f, 0.0f);
-    glVertex3f(0.5f, -0.5f, -0.5f);
-    glVertex3f(-0.5f, -0.5f, -0.5f);
-    // Left
-    glVertex3f(0.0f, 0.5f, 0.0f);
-    glVertex3f(-0.5f, -0.5f, -0.5f);
-    glVertex3f(-0.5f, -0.5f, 0.5f);
-    glEnd();
-
-    // Base quad edges
-    glBegin(GL_QUADS);
-    glVertex3f(-0.5f, -0.5f, 0.5f);
-    glVertex3f(0.5f, -0.5f, 0.5f);
-    glVertex3f(0.5f, -0.5f, -0.5f);
-    glVertex3f(-0.5f, -0.5f, -0.5f);
-    glEnd();
-
-    // Overlay thick orange edges if selected
-    if (IsSelected()) {
-        glLineWidth(3.0f);
-        glColor3f(1.0f, 0.5f, 0.0f);   // orange
-
-        // Triangular sides again
-        glBegin(GL_TRIANGLES);
-        glVertex3f(0.0f, 0.5f, 0.0f);
-        glVertex3f(-0.5f, -0.5f, 0.5f);
-        glVertex3f(0.5f, -0.5f, 0.5f);
-
-        glVertex3f(0.0f, 0.5f, 0.0f);
-        glVertex3f(0.5f, -0.5f, 0.5f);
-        glVertex3f(0.5f, -0.5f, -0.5f);
-
-        glVertex3f(0.0f, 0.5f, 0.0f);
-        glVertex3f(0.5f, -0.5f, -0.5f);
-        glVertex3f(-0.5f, -0.5f, -0.5f);
+Mesh* Pyramid::GetMesh() {
+    // Geometry lives in the engine's shared pyramid mesh, uploaded once in Init
+    return Engine::instance ? Engine::instance->pyramidMesh : nullptr;
+}
 
-        glVertex3f(0.0f, 0.5f, 0.0f);
-        glVertex3f(-0.5f, -0.5f, -0.5f);
-        glVertex3f(-0.5f, -0.5f, 0.5f);
-        glEnd();
+// Moller-Trumbore ray/triangle test
+static bool RayTriangle(const glm::vec3& o, const glm::vec3& d,
+    const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, float& t) {
+    glm::vec3 e1 = b - a;
+    glm::vec3 e2 = c - a;
+    glm::vec3 p = glm::cross(d, e2);
+    float det = glm::dot(e1, p);
+    if (std::fabs(det) < 1e-12f) return false;
+    float invDet = 1.0f / det;
+    glm::vec3 s = o - a;
+    float u = glm::dot(s, p) * invDet;
+    if (u < 0.0f || u > 1.0f) return false;
+    glm::vec3 q = glm::cross(s, e1);
+    float v = glm::dot(d, q) * invDet;
+    if (v < 0.0f || u + v > 1.0f) return false;
+    t = glm::dot(e2, q) * invDet;
+    return t >= 0.0f;
+}
 
-        // Base quad again
-        glBegin(GL_QUADS);
-        glVertex3f(-0.5f, -0.5f, 0.5f);
-        glVertex3f(0.5f, -0.5f, 0.5f);
-        glVertex3f(0.5f, -0.5f, -0.5f);
-        glVertex3f(-0.5f, -0.5f, -0.5f);
-        glEnd();
+bool Pyramid::IntersectLocalRay(const glm::vec3& origin, const glm::vec3& dir, float& t) const {
+    const glm::vec3 apex(0.0f, 0.5f, 0.0f);
+    const glm::vec3 base[4] = {
+        {-0.5f, -0.5f,  0.5f},{ 0.5f, -0.5f,  0.5f},
+        { 0.5f, -0.5f, -0.5f},{-0.5f, -0.5f, -0.5f}
+    };
+
+    bool hit = false;
+    float best = 1e30f;
+    float ti;
+    for (int i = 0; i < 4; ++i) {
+        if (RayTriangle(origin, dir, apex, base[i], base[(i + 1) % 4], ti) && ti < best) {
+            best = ti;
+            hit = true;
+        }
     }
+    if (RayTriangle(origin, dir, base[0], base[1], base[2], ti) && ti < best) { best = ti; hit = true; }
+    if (RayTriangle(origin, dir, base[0], base[2], base[3], ti) && ti < best) { best = ti; hit = true; }
 
-    // Restore defaults and pop matrix
-    glLineWidth(1.0f);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    glPopMatrix();
+    if (hit) t = best;
+    return hit;
 }
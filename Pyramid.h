@@ -3,5 +3,11 @@
 
 class Pyramid : public Object3D {
 public:
-    void Draw() override;
+    // Square base at y=-0.5, apex at y=+0.5
+    Pyramid() { SetLocalBounds(AABB(glm::vec3(-0.5f), glm::vec3(0.5f))); }
+
+    Mesh* GetMesh() override;
+
+    // Ray against the four sides and the base
+    bool IntersectLocalRay(const glm::vec3& origin, const glm::vec3& dir, float& t) const override;
 };
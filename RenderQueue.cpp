@@ -0,0 +1,194 @@
+// RenderQueue.cpp
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+#include <glm/gtc/type_ptr.hpp>
+#include "RenderQueue.h"
+#include "Object3D.h"
+#include "Texture2D.h"
+#include "Mesh.h"
+#include "Profiler.h"
+#include "RenderState.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static const int kPassShift = 60;
+static const int kMeshShift = 48;
+static const int kTextureShift = 32;
+static const uint64_t kMeshMask = 0xFFF;
+static const uint64_t kTextureMask = 0xFFFF;
+static const uint32_t kDepthMax = (1u << 24) - 1;
+
+template <typename T>
+uint32_t RenderQueue::Intern(std::vector<T*>& table, T* ptr)
+{
+    if (!ptr) return 0;
+    // A handful of distinct values per frame, usually repeated back to back
+    if (table.size() > 1 && table.back() == ptr) {
+        return (uint32_t)table.size() - 1;
+    }
+    for (size_t i = 1; i < table.size(); ++i) {
+        if (table[i] == ptr) return (uint32_t)i;
+    }
+    table.push_back(ptr);
+    return (uint32_t)table.size() - 1;
+}
+
+void RenderQueue::Clear()
+{
+    items.clear();
+    entries.clear();
+    runs.clear();
+    meshes.assign(1, nullptr);
+    textures.assign(1, nullptr);
+    selected = nullptr;
+    saturated = false;
+}
+
+void RenderQueue::Submit(Object3D* obj, Pass pass, float depth)
+{
+    Mesh* mesh = obj->GetMesh();
+    if (!mesh) return;
+
+    uint64_t meshId = Intern(meshes, mesh);
+    uint64_t texId = Intern(textures, obj->GetTexture());
+    if (meshId > kMeshMask || texId > kTextureMask) {
+        // Out of key bits: ids past the limit all get the largest id, and
+        // Sort tells their meshes and textures apart by pointer instead
+        if (!saturated) {
+            static bool warned = false;
+            if (!warned) {
+                std::cerr << "RenderQueue: more than " << kMeshMask << " meshes or "
+                    << kTextureMask << " textures in a frame, the rest are not batched\n";
+                warned = true;
+            }
+            saturated = true;
+        }
+        meshId = std::min(meshId, kMeshMask);
+        texId = std::min(texId, kTextureMask);
+    }
+    float d = std::min(std::max(depth, 0.0f), 1.0f);
+    uint64_t depthBits = (uint64_t)(d * (float)kDepthMax);
+
+    Entry e;
+    e.key = ((uint64_t)pass << kPassShift) | (meshId << kMeshShift) |
+        (texId << kTextureShift) | depthBits;
+    e.item = (uint32_t)items.size();
+    entries.push_back(e);
+    items.push_back(obj);
+
+    if (obj->IsSelected()) selected = obj;
+}
+
+void RenderQueue::Sort()
+{
+    PROFILE_SCOPE("RenderQueue::Sort");
+
+    // LSD radix sort, 8 bits per pass. Bytes that are the same in every key
+    // (unused bits, a single pass or mesh) are skipped
+    const size_t n = entries.size();
+    runs.clear();
+    if (n == 0) return;
+    scratch.resize(n);
+    Entry* src = entries.data();
+    Entry* dst = scratch.data();
+    size_t counts[256];
+    for (int shift = 0; shift < 64; shift += 8) {
+        std::memset(counts, 0, sizeof(counts));
+        for (size_t i = 0; i < n; ++i) {
+            ++counts[(src[i].key >> shift) & 0xFF];
+        }
+        if (counts[(src[0].key >> shift) & 0xFF] == n) {
+            continue;
+        }
+        size_t offset = 0;
+        for (int b = 0; b < 256; ++b) {
+            size_t c = counts[b];
+            counts[b] = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            dst[counts[(src[i].key >> shift) & 0xFF]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+    if (src != entries.data()) {
+        entries.swap(scratch);
+    }
+
+    // Split into runs of equal pass / mesh / texture. With saturated ids
+    // a key no longer names one mesh and texture, so ask the objects
+    const uint64_t groupMask = ~(uint64_t)0 << kTextureShift;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t key = entries[i].key;
+        Mesh* mesh = meshes[(key >> kMeshShift) & kMeshMask];
+        Texture2D* texture = textures[(key >> kTextureShift) & kTextureMask];
+        if (saturated) {
+            Object3D* obj = items[entries[i].item];
+            mesh = obj->GetMesh();
+            texture = obj->GetTexture();
+        }
+        if (runs.empty() || ((entries[i - 1].key ^ key) & groupMask) != 0 ||
+            runs.back().mesh != mesh || runs.back().texture != texture) {
+            Run r;
+            r.pass = (Pass)(key >> kPassShift);
+            r.mesh = mesh;
+            r.texture = texture;
+            r.first = i;
+            r.count = 0;
+            runs.push_back(r);
+        }
+        ++runs.back().count;
+    }
+}
+
+void RenderQueue::Execute() const
+{
+    if (runs.empty()) return;
+    PROFILE_SCOPE("RenderQueue::Execute");
+    PROFILE_GPU_SCOPE("Per-object draws");
+
+    RenderState* state = RenderState::instance;
+    glMatrixMode(GL_MODELVIEW);
+    glEnable(GL_TEXTURE_2D);
+    state->SetPolygonMode(GL_FILL);
+
+    const Mesh* boundMesh = nullptr;
+    for (const Run& run : runs) {
+        // Runs are sorted by mesh, so each mesh is bound once
+        if (run.mesh != boundMesh) {
+            run.mesh->Bind();
+            boundMesh = run.mesh;
+        }
+
+        // Filled faces (textured if bound, else flat white)
+        if (run.texture) run.texture->Bind();
+        else             Texture2D::Unbind();
+        glColor3f(1.0f, 1.0f, 1.0f);
+        for (size_t i = run.first; i < run.first + run.count; ++i) {
+            glPushMatrix();
+            glMultMatrixf(glm::value_ptr(GetObject(i)->GetModelMatrix()));
+            run.mesh->DrawFill();
+            glPopMatrix();
+        }
+
+        // Thin black wireframe overlay (always untextured). The selected
+        // object only gets its outline, drawn last
+        Texture2D::Unbind();
+        state->SetLineWidth(1.0f);
+        glColor3f(0.0f, 0.0f, 0.0f);
+        for (size_t i = run.first; i < run.first + run.count; ++i) {
+            Object3D* obj = GetObject(i);
+            if (obj == selected) continue;
+            glPushMatrix();
+            glMultMatrixf(glm::value_ptr(obj->GetModelMatrix()));
+            run.mesh->DrawEdges();
+            glPopMatrix();
+        }
+    }
+    Mesh::Unbind();
+
+    if (selected) {
+        selected->DrawOutline();
+    }
+}
@@ -0,0 +1,79 @@
+// RenderQueue.h
+#pragma once
+#include <cstdint>
+#include <vector>
+
+class Object3D;
+class Mesh;
+class Texture2D;
+
+// Per-frame list of draws, each reduced to a 64-bit sort key:
+//
+//   63..60  pass           passes run in numeric order
+//   59..48  mesh id        interned per frame
+//   47..32  texture id     interned per frame, 0 = untextured
+//   23..0   depth          quantized view depth, front-to-back
+//
+// After a radix sort, draws sharing a mesh and texture are adjacent (one
+// bind per run) and opaque draws inside a run go nearest first, so the
+// depth test rejects hidden fragments early. Past 4095 meshes or 65535
+// textures in a frame the extra ids share the top id: their draws still
+// come out grouped by pass, but runs may repeat binds.
+class RenderQueue {
+public:
+    enum Pass : uint32_t {
+        PassOpaque = 0
+    };
+
+    // Consecutive sorted draws with the same pass, mesh and texture
+    struct Run {
+        Pass       pass;
+        Mesh*      mesh;
+        Texture2D* texture;
+        size_t     first;     // index into the sorted order
+        size_t     count;
+    };
+
+    RenderQueue() { Clear(); }
+
+    // Drop last frame's draws (keeps the allocations)
+    void Clear();
+
+    // Queue obj for pass. depth is its view depth mapped to [0, 1]
+    // (near to far); values outside are clamped. Objects without a mesh
+    // are ignored
+    void Submit(Object3D* obj, Pass pass, float depth);
+
+    // Radix-sort the keys and build the runs
+    void Sort();
+
+    // Draw everything with the fixed-function path: per run, one mesh and
+    // texture bind, the filled pass, then the wireframe pass. The selected
+    // object's outline goes on top
+    void Execute() const;
+
+    // Sorted access for other backends (valid after Sort)
+    const std::vector<Run>& GetRuns() const { return runs; }
+    Object3D* GetObject(size_t sortedIndex) const { return items[entries[sortedIndex].item]; }
+    Object3D* GetSelected() const { return selected; }
+    size_t GetSize() const { return entries.size(); }
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint32_t item;        // index into items
+    };
+
+    // Small per-frame id for a pointer; 0 is reserved for nullptr
+    template <typename T>
+    static uint32_t Intern(std::vector<T*>& table, T* ptr);
+
+    std::vector<Object3D*> items;
+    std::vector<Entry> entries;
+    std::vector<Entry> scratch;   // radix sort ping-pong buffer
+    std::vector<Mesh*> meshes;    // meshes[id]
+    std::vector<Texture2D*> textures;
+    std::vector<Run> runs;
+    Object3D* selected = nullptr;
+    bool saturated = false;       // some ids didn't fit their key bits
+};
@@ -0,0 +1,75 @@
+// RenderState.cpp
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+#include "RenderState.h"
+
+RenderState* RenderState::instance = nullptr;
+
+RenderState::RenderState()
+    : texture(0),
+    polygonMode(GL_FILL),
+    lineWidth(1.0f),
+    textureKnown(false),
+    polygonModeKnown(false),
+    lineWidthKnown(false),
+    issuedCalls(0),
+    skippedCalls(0),
+    drawCalls(0)
+{}
+
+void RenderState::BindTexture(GLuint id)
+{
+    if (textureKnown && texture == id) {
+        ++skippedCalls;
+        return;
+    }
+    glBindTexture(GL_TEXTURE_2D, id);
+    texture = id;
+    textureKnown = true;
+    ++issuedCalls;
+}
+
+void RenderState::SetPolygonMode(GLenum mode)
+{
+    if (polygonModeKnown && polygonMode == mode) {
+        ++skippedCalls;
+        return;
+    }
+    glPolygonMode(GL_FRONT_AND_BACK, mode);
+    polygonMode = mode;
+    polygonModeKnown = true;
+    ++issuedCalls;
+}
+
+void RenderState::SetLineWidth(float width)
+{
+    if (lineWidthKnown && lineWidth == width) {
+        ++skippedCalls;
+        return;
+    }
+    glLineWidth(width);
+    lineWidth = width;
+    lineWidthKnown = true;
+    ++issuedCalls;
+}
+
+void RenderState::OnTextureDeleted(GLuint id)
+{
+    if (textureKnown && texture == id) {
+        texture = 0;
+    }
+}
+
+void RenderState::Invalidate()
+{
+    textureKnown = false;
+    polygonModeKnown = false;
+    lineWidthKnown = false;
+}
+
+void RenderState::BeginFrame()
+{
+    issuedCalls = 0;
+    skippedCalls = 0;
+    drawCalls = 0;
+}
@@ -0,0 +1,51 @@
+// RenderState.h
+#pragma once
+#include <GL/freeglut.h>
+
+// Shadow copy of the GL state the draw paths change per object: the bound
+// 2D texture, the polygon mode and the line width. Setting a value that is
+// already current is skipped, so back-to-back objects sharing a texture or
+// line width don't pay for the same call again.
+class RenderState {
+public:
+    // The tracker for the current GL context (set by the Engine that owns it)
+    static RenderState* instance;
+
+    RenderState();
+
+    // Tracked equivalents of glBindTexture(GL_TEXTURE_2D, ...), glPolygonMode
+    // (GL_FRONT_AND_BACK) and glLineWidth
+    void BindTexture(GLuint id);
+    void SetPolygonMode(GLenum mode);
+    void SetLineWidth(float width);
+
+    // GL drops the binding of a deleted texture back to 0
+    void OnTextureDeleted(GLuint id);
+
+    // Forget the cached values; the next set of each state always reaches GL.
+    // Use after code that changes these states behind the tracker's back
+    void Invalidate();
+
+    // Reset the per-frame call counters
+    void BeginFrame();
+
+    // Calls passed on to GL / skipped as redundant since BeginFrame
+    int GetIssuedCalls() const { return issuedCalls; }
+    int GetSkippedCalls() const { return skippedCalls; }
+
+    // Draw calls since BeginFrame; the draw paths report each one here
+    void CountDraw() { ++drawCalls; }
+    int GetDrawCalls() const { return drawCalls; }
+
+private:
+    GLuint texture;
+    GLenum polygonMode;
+    float  lineWidth;
+    bool   textureKnown;
+    bool   polygonModeKnown;
+    bool   lineWidthKnown;
+
+    int issuedCalls;
+    int skippedCalls;
+    int drawCalls;
+};
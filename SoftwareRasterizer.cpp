@@ -0,0 +1,690 @@
+// SoftwareRasterizer.cpp
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+#include "SoftwareRasterizer.h"
+#include "BlockCompressor.h"
+#include "Mesh.h"
+#include "Object3D.h"
+#include "Profiler.h"
+#include "RenderQueue.h"
+#include "Texture2D.h"
+#include "TextureStreamer.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define RASTER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+static const int kTileSize = 64;
+
+// Vertices snap to 1/16 pixel, so edge functions at pixel centers are
+// exact multiples of 1/256 and the top-left rule can be a constant bias
+static const float kSubpixel = 16.0f;
+
+// Edges lie on their own faces; pull them forward so they aren't hidden
+static const float kLineDepthBias = 1e-4f;
+
+// LIGHT0 as Engine::Init sets it up: fixed in eye space (the modelview was
+// identity then), 0.2 ambient plus the 0.2 global ambient, 0.8 diffuse
+static const glm::vec3 kLightPos(10.0f, 10.0f, 10.0f);
+static const float kAmbient = 0.4f;
+static const float kDiffuse = 0.8f;
+
+// Clip planes besides the frustum test: near (z >= -w) and the four sides
+// of the guard band (|x|, |y| <= g * w)
+static const int kClipPlanes = 5;
+
+static float PlaneDistance(const glm::vec4& p, int plane, float g)
+{
+    switch (plane) {
+    case 0:  return p.z + p.w;
+    case 1:  return g * p.w - p.x;
+    case 2:  return g * p.w + p.x;
+    case 3:  return g * p.w - p.y;
+    default: return g * p.w + p.y;
+    }
+}
+
+// Frustum planes p is outside of, one bit each
+static int OutCode(const glm::vec4& p)
+{
+    return (p.x > p.w ? 1 : 0) | (p.x < -p.w ? 2 : 0) |
+        (p.y > p.w ? 4 : 0) | (p.y < -p.w ? 8 : 0) |
+        (p.z > p.w ? 16 : 0) | (p.z < -p.w ? 32 : 0);
+}
+
+// RGBA8 in memory order (little-endian), as glDrawPixels reads it
+static uint32_t PackColor(float r, float g, float b)
+{
+    auto to8 = [](float v) { return (uint32_t)(std::min(std::max(v, 0.0f), 1.0f) * 255.0f + 0.5f); };
+    return to8(r) | (to8(g) << 8) | (to8(b) << 16) | 0xff000000u;
+}
+
+static inline int Wrap(int i, int n)
+{
+    i %= n;
+    return i < 0 ? i + n : i;
+}
+
+SoftwareRasterizer::SoftwareRasterizer(unsigned threads)
+    : threadCount(threads), steals(0)
+{
+}
+
+void SoftwareRasterizer::Resize(int w, int h)
+{
+    width = std::max(w, 1);
+    height = std::max(h, 1);
+    stride = (width + 3) & ~3;
+    tilesX = (stride + kTileSize - 1) / kTileSize;
+    tilesY = (height + kTileSize - 1) / kTileSize;
+    color.assign((size_t)stride * height, 0);
+    depth.assign((size_t)stride * height, 1.0f);
+}
+
+const SoftwareRasterizer::CpuTexture* SoftwareRasterizer::GetTexture(const Texture2D* tex, const TextureStreamer& streamer)
+{
+    const uint64_t generation = streamer.GetGeneration(tex);
+    auto it = textures.find(tex);
+    if (it != textures.end() && it->second.generation == generation) {
+        return it->second.levels.empty() ? nullptr : &it->second;
+    }
+
+    // An empty entry remembers textures without a CPU-side chain (until
+    // they are adopted)
+    CpuTexture& cpu = textures[tex];
+    cpu.levels.clear();
+    cpu.generation = generation;
+    const TextureImage* img = streamer.GetImage(tex);
+    if (!img || (img->format == BlockCompressor::Format::None &&
+        img->channels != 1 && img->channels != 3 && img->channels != 4)) {
+        return nullptr;
+    }
+
+    cpu.levels.resize(img->levels.size());
+    for (size_t level = 0; level < img->levels.size(); ++level) {
+        MipLevel& m = cpu.levels[level];
+        m.width = std::max(1, img->width >> level);
+        m.height = std::max(1, img->height >> level);
+        m.texels.resize((size_t)m.width * m.height);
+        const unsigned char* src = img->levels[level];
+        if (img->format != BlockCompressor::Format::None) {
+            BlockCompressor::Decompress(img->format, src, m.width, m.height,
+                reinterpret_cast<unsigned char*>(m.texels.data()));
+            continue;
+        }
+        // GL_RED samples as (r, 0, 0, 1), GL_RGB with alpha 1
+        for (size_t i = 0; i < m.texels.size(); ++i, src += img->channels) {
+            uint32_t r = src[0];
+            uint32_t g = img->channels >= 3 ? src[1] : 0;
+            uint32_t b = img->channels >= 3 ? src[2] : 0;
+            uint32_t a = img->channels == 4 ? src[3] : 255;
+            m.texels[i] = r | (g << 8) | (b << 16) | (a << 24);
+        }
+    }
+    return &cpu;
+}
+
+void SoftwareRasterizer::Render(const RenderQueue& queue, const glm::mat4& viewMatrix,
+    const glm::mat4& projectionMatrix, bool lightingOn, bool smoothOn,
+    const glm::vec3& clearColor, const TextureStreamer& streamer)
+{
+    PROFILE_SCOPE("SoftwareRasterizer::Render");
+    if (color.empty()) {
+        return;
+    }
+    if (!pool) {
+        pool.reset(new ThreadPool(threadCount));
+        laneCount = (int)pool->GetThreadCount() + 1;
+        laneQueues.reset(new std::atomic<uint64_t>[laneCount]);
+    }
+
+    view = viewMatrix;
+    projection = projectionMatrix;
+    lighting = lightingOn;
+    smooth = smoothOn;
+    clearValue = PackColor(clearColor.x, clearColor.y, clearColor.z);
+    guardBand = std::max(1.0f, 16384.0f / (float)std::max(width, height));
+
+    // Flatten the queue; textures are decoded here, on the calling thread
+    draws.clear();
+    Object3D* selected = queue.GetSelected();
+    for (const RenderQueue::Run& run : queue.GetRuns()) {
+        const CpuTexture* tex = run.texture ? GetTexture(run.texture, streamer) : nullptr;
+        for (size_t i = run.first; i < run.first + run.count; ++i) {
+            Object3D* obj = queue.GetObject(i);
+            draws.push_back({ obj, run.mesh, tex, obj == selected });
+        }
+    }
+
+    // Geometry: transform, light, clip and bin in parallel chunks
+    const int tileCount = tilesX * tilesY;
+    const size_t chunkCount = std::min(draws.size(), (size_t)laneCount * 4);
+    chunkSize = chunkCount > 0 ? (draws.size() + chunkCount - 1) / chunkCount : 1;
+    chunks.resize(chunkCount);
+    pool->ParallelFor(chunkCount, [&](size_t c) {
+        PROFILE_SCOPE("Software geometry chunk");
+        Chunk& chunk = chunks[c];
+        chunk.triangles.clear();
+        chunk.lines.clear();
+        chunk.triangleBins.resize(tileCount);
+        chunk.lineBins.resize(tileCount);
+        for (std::vector<uint32_t>& bin : chunk.triangleBins) bin.clear();
+        for (std::vector<uint32_t>& bin : chunk.lineBins) bin.clear();
+
+        size_t first = c * chunkSize;
+        if (first < draws.size()) {
+            TransformChunk(chunk, first, std::min(chunkSize, draws.size() - first));
+        }
+    });
+    triangleCount = 0;
+    for (const Chunk& chunk : chunks) {
+        triangleCount += chunk.triangles.size();
+    }
+
+    // Raster: each lane owns a contiguous run of tiles, then steals
+    tileOrder.resize(tileCount);
+    for (int i = 0; i < tileCount; ++i) {
+        tileOrder[i] = i;
+    }
+    for (int lane = 0; lane < laneCount; ++lane) {
+        uint64_t begin = (uint64_t)tileCount * lane / laneCount;
+        uint64_t end = (uint64_t)tileCount * (lane + 1) / laneCount;
+        laneQueues[lane] = (end << 32) | begin;
+    }
+    steals = 0;
+    pool->ParallelFor((size_t)laneCount, [&](size_t lane) {
+        PROFILE_SCOPE("Software raster lane");
+        int tile;
+        while (PopFront((int)lane, tile)) {
+            RasterTile(tile);
+        }
+        for (int k = 1; k < laneCount; ++k) {
+            int victim = ((int)lane + k) % laneCount;
+            while (StealBack(victim, tile)) {
+                ++steals;
+                RasterTile(tile);
+            }
+        }
+    });
+    stealCount = steals;
+}
+
+bool SoftwareRasterizer::PopFront(int lane, int& tile)
+{
+    std::atomic<uint64_t>& q = laneQueues[lane];
+    uint64_t range = q.load();
+    for (;;) {
+        uint32_t begin = (uint32_t)range, end = (uint32_t)(range >> 32);
+        if (begin >= end) {
+            return false;
+        }
+        if (q.compare_exchange_weak(range, ((uint64_t)end << 32) | (begin + 1))) {
+            tile = tileOrder[begin];
+            return true;
+        }
+    }
+}
+
+bool SoftwareRasterizer::StealBack(int lane, int& tile)
+{
+    std::atomic<uint64_t>& q = laneQueues[lane];
+    uint64_t range = q.load();
+    for (;;) {
+        uint32_t begin = (uint32_t)range, end = (uint32_t)(range >> 32);
+        if (begin >= end) {
+            return false;
+        }
+        if (q.compare_exchange_weak(range, ((uint64_t)(end - 1) << 32) | begin)) {
+            tile = tileOrder[end - 1];
+            return true;
+        }
+    }
+}
+
+void SoftwareRasterizer::TransformChunk(Chunk& chunk, size_t first, size_t count)
+{
+    const uint32_t black = PackColor(0.0f, 0.0f, 0.0f);
+    const uint32_t orange = PackColor(1.0f, 0.5f, 0.0f);
+
+    for (size_t d = first; d < first + count; ++d) {
+        const Draw& draw = draws[d];
+        const Mesh* mesh = draw.mesh;
+        const std::vector<Mesh::Vertex>& verts = mesh->GetVertices();
+        const glm::mat4 modelView = view * draw.object->GetModelMatrix();
+        const glm::mat4 mvp = projection * modelView;
+        const glm::mat3 normalMat = glm::transpose(glm::inverse(glm::mat3(modelView)));
+
+        chunk.vertices.resize(verts.size());
+        for (size_t i = 0; i < verts.size(); ++i) {
+            ClipVertex& cv = chunk.vertices[i];
+            glm::vec4 p(verts[i].position, 1.0f);
+            cv.pos = mvp * p;
+            cv.uv = verts[i].uv;
+            cv.light = 1.0f;
+            if (lighting) {
+                glm::vec3 eye(modelView * p);
+                glm::vec3 n = glm::normalize(normalMat * verts[i].normal);
+                glm::vec3 l = glm::normalize(kLightPos - eye);
+                cv.light = std::min(kAmbient + kDiffuse * std::max(glm::dot(n, l), 0.0f), 1.0f);
+            }
+        }
+
+        // Filled faces; flat shading takes the last vertex's light, like GL
+        const GLuint* tris = mesh->GetTriangleIndices();
+        for (GLsizei i = 0; i + 2 < mesh->GetTriangleIndexCount(); i += 3) {
+            ClipVertex tri[3] = { chunk.vertices[tris[i]], chunk.vertices[tris[i + 1]],
+                                  chunk.vertices[tris[i + 2]] };
+            ClipTriangle(chunk, tri, smooth ? -1.0f : tri[2].light, draw.texture);
+        }
+
+        // Thin black edges, or the selected object's thick orange outline
+        const GLuint* edges = mesh->GetEdgeIndices();
+        for (GLsizei i = 0; i + 1 < mesh->GetEdgeIndexCount(); i += 2) {
+            ClipLine(chunk, chunk.vertices[edges[i]], chunk.vertices[edges[i + 1]],
+                draw.selected ? orange : black, draw.selected ? 3 : 1, draw.selected);
+        }
+    }
+}
+
+void SoftwareRasterizer::ClipTriangle(Chunk& chunk, const ClipVertex* tri, float flatLight, const CpuTexture* texture)
+{
+    if (OutCode(tri[0].pos) & OutCode(tri[1].pos) & OutCode(tri[2].pos)) {
+        return;     // entirely outside one frustum plane
+    }
+
+    bool inside = true;
+    for (int plane = 0; plane < kClipPlanes && inside; ++plane) {
+        for (int i = 0; i < 3; ++i) {
+            if (PlaneDistance(tri[i].pos, plane, guardBand) < 0.0f) {
+                inside = false;
+            }
+        }
+    }
+    if (inside) {
+        SetupTriangle(chunk, tri[0], tri[1], tri[2], flatLight, texture);
+        return;
+    }
+
+    // Sutherland-Hodgman; each plane adds at most one vertex
+    ClipVertex poly[2][3 + kClipPlanes];
+    int n = 3, cur = 0;
+    std::copy(tri, tri + 3, poly[0]);
+    for (int plane = 0; plane < kClipPlanes && n >= 3; ++plane) {
+        const ClipVertex* in = poly[cur];
+        ClipVertex* out = poly[cur ^ 1];
+        int m = 0;
+        for (int i = 0; i < n; ++i) {
+            const ClipVertex& p = in[i];
+            const ClipVertex& q = in[(i + 1) % n];
+            float dp = PlaneDistance(p.pos, plane, guardBand);
+            float dq = PlaneDistance(q.pos, plane, guardBand);
+            if (dp >= 0.0f) {
+                out[m++] = p;
+            }
+            if ((dp >= 0.0f) != (dq >= 0.0f)) {
+                float t = dp / (dp - dq);
+                ClipVertex& v = out[m++];
+                v.pos = p.pos + (q.pos - p.pos) * t;
+                v.uv = p.uv + (q.uv - p.uv) * t;
+                v.light = p.light + (q.light - p.light) * t;
+            }
+        }
+        n = m;
+        cur ^= 1;
+    }
+    for (int i = 1; i + 1 < n; ++i) {
+        SetupTriangle(chunk, poly[cur][0], poly[cur][i], poly[cur][i + 1], flatLight, texture);
+    }
+}
+
+void SoftwareRasterizer::SetupTriangle(Chunk& chunk, const ClipVertex& a, const ClipVertex& b,
+    const ClipVertex& c, float flatLight, const CpuTexture* texture)
+{
+    const ClipVertex* v[3] = { &a, &b, &c };
+    float x[3], y[3], z[3], iw[3];
+    for (int k = 0; k < 3; ++k) {
+        iw[k] = 1.0f / v[k]->pos.w;
+        x[k] = std::floor((v[k]->pos.x * iw[k] * 0.5f + 0.5f) * width * kSubpixel + 0.5f) / kSubpixel;
+        y[k] = std::floor((v[k]->pos.y * iw[k] * 0.5f + 0.5f) * height * kSubpixel + 0.5f) / kSubpixel;
+        z[k] = v[k]->pos.z * iw[k] * 0.5f + 0.5f;
+    }
+    const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+    if (area == 0.0f) {
+        return;     // degenerate or edge-on
+    }
+
+    Triangle t;
+    t.minX = std::max(0, (int)std::floor(std::min(x[0], std::min(x[1], x[2]))));
+    t.minY = std::max(0, (int)std::floor(std::min(y[0], std::min(y[1], y[2]))));
+    t.maxX = std::min(width - 1, (int)std::ceil(std::max(x[0], std::max(x[1], x[2]))));
+    t.maxY = std::min(height - 1, (int)std::ceil(std::max(y[0], std::max(y[1], y[2]))));
+    if (t.minX > t.maxX || t.minY > t.maxY) {
+        return;
+    }
+
+    // Edge k joins the two other vertices; flip so the inside is positive
+    const float sign = area > 0.0f ? 1.0f : -1.0f;
+    for (int k = 0; k < 3; ++k) {
+        int i = (k + 1) % 3, j = (k + 2) % 3;
+        Plane& e = t.edge[k];
+        e.a = (y[i] - y[j]) * sign;
+        e.b = (x[j] - x[i]) * sign;
+        e.c = (x[i] * y[j] - x[j] * y[i]) * sign;
+
+        // Top-left rule: a pixel center exactly on an edge shared by two
+        // triangles goes to only one of them
+        bool topLeft = e.a > 0.0f || (e.a == 0.0f && e.b > 0.0f);
+        if (!topLeft) {
+            e.c -= 0.5f / (kSubpixel * kSubpixel);
+        }
+    }
+
+    // Attribute planes; those divided by w interpolate perspective-correct
+    auto plane = [&](float f0, float f1, float f2) {
+        Plane p;
+        p.a = ((f1 - f0) * (y[2] - y[0]) - (f2 - f0) * (y[1] - y[0])) / area;
+        p.b = ((f2 - f0) * (x[1] - x[0]) - (f1 - f0) * (x[2] - x[0])) / area;
+        p.c = f0 - p.a * x[0] - p.b * y[0];
+        return p;
+    };
+    t.z = plane(z[0], z[1], z[2]);
+    t.invW = plane(iw[0], iw[1], iw[2]);
+    t.u = plane(a.uv.x * iw[0], b.uv.x * iw[1], c.uv.x * iw[2]);
+    t.v = plane(a.uv.y * iw[0], b.uv.y * iw[1], c.uv.y * iw[2]);
+    if (flatLight >= 0.0f) {
+        t.light = { t.invW.a * flatLight, t.invW.b * flatLight, t.invW.c * flatLight };
+    }
+    else {
+        t.light = plane(a.light * iw[0], b.light * iw[1], c.light * iw[2]);
+    }
+
+    // One mip level per triangle, from its texel-to-pixel area ratio
+    t.texture = nullptr;
+    if (texture) {
+        const MipLevel& base = texture->levels[0];
+        float uvArea = std::fabs((b.uv.x - a.uv.x) * (c.uv.y - a.uv.y) -
+            (c.uv.x - a.uv.x) * (b.uv.y - a.uv.y)) * base.width * base.height;
+        float lod = uvArea > 0.0f ? 0.5f * std::log2(uvArea / std::fabs(area)) : 0.0f;
+        int level = lod > 0.0f ? (int)(lod + 0.5f) : 0;
+        t.texture = &texture->levels[std::min(level, (int)texture->levels.size() - 1)];
+    }
+
+    uint32_t index = (uint32_t)chunk.triangles.size();
+    chunk.triangles.push_back(t);
+    for (int ty = t.minY / kTileSize; ty <= t.maxY / kTileSize; ++ty) {
+        for (int tx = t.minX / kTileSize; tx <= t.maxX / kTileSize; ++tx) {
+            chunk.triangleBins[ty * tilesX + tx].push_back(index);
+        }
+    }
+}
+
+void SoftwareRasterizer::ClipLine(Chunk& chunk, ClipVertex a, ClipVertex b, uint32_t lineColor,
+    int lineWidth, bool outline)
+{
+    if (OutCode(a.pos) & OutCode(b.pos)) {
+        return;
+    }
+
+    // Parametric clip against the near plane and the guard band
+    float t0 = 0.0f, t1 = 1.0f;
+    for (int plane = 0; plane < kClipPlanes; ++plane) {
+        float da = PlaneDistance(a.pos, plane, guardBand);
+        float db = PlaneDistance(b.pos, plane, guardBand);
+        if (da < 0.0f && db < 0.0f) {
+            return;
+        }
+        if (da < 0.0f) {
+            t0 = std::max(t0, da / (da - db));
+        }
+        else if (db < 0.0f) {
+            t1 = std::min(t1, da / (da - db));
+        }
+    }
+    if (t0 > t1) {
+        return;
+    }
+    glm::vec4 p0 = a.pos + (b.pos - a.pos) * t0;
+    glm::vec4 p1 = a.pos + (b.pos - a.pos) * t1;
+
+    Line l;
+    l.x0 = (p0.x / p0.w * 0.5f + 0.5f) * width;
+    l.y0 = (p0.y / p0.w * 0.5f + 0.5f) * height;
+    l.z0 = p0.z / p0.w * 0.5f + 0.5f;
+    l.x1 = (p1.x / p1.w * 0.5f + 0.5f) * width;
+    l.y1 = (p1.y / p1.w * 0.5f + 0.5f) * height;
+    l.z1 = p1.z / p1.w * 0.5f + 0.5f;
+    l.color = lineColor;
+    l.width = lineWidth;
+    l.outline = outline;
+
+    int pad = lineWidth / 2 + 1;
+    int minX = std::max(0, (int)std::floor(std::min(l.x0, l.x1)) - pad);
+    int minY = std::max(0, (int)std::floor(std::min(l.y0, l.y1)) - pad);
+    int maxX = std::min(width - 1, (int)std::ceil(std::max(l.x0, l.x1)) + pad);
+    int maxY = std::min(height - 1, (int)std::ceil(std::max(l.y0, l.y1)) + pad);
+    if (minX > maxX || minY > maxY) {
+        return;
+    }
+
+    uint32_t index = (uint32_t)chunk.lines.size();
+    chunk.lines.push_back(l);
+    for (int ty = minY / kTileSize; ty <= maxY / kTileSize; ++ty) {
+        for (int tx = minX / kTileSize; tx <= maxX / kTileSize; ++tx) {
+            chunk.lineBins[ty * tilesX + tx].push_back(index);
+        }
+    }
+}
+
+void SoftwareRasterizer::RasterTile(int tile)
+{
+    const int x0 = (tile % tilesX) * kTileSize;
+    const int y0 = (tile / tilesX) * kTileSize;
+    const int x1 = std::min(x0 + kTileSize, stride) - 1;
+    const int y1 = std::min(y0 + kTileSize, height) - 1;
+
+    for (int y = y0; y <= y1; ++y) {
+        std::fill(&color[(size_t)y * stride + x0], &color[(size_t)y * stride + x1] + 1, clearValue);
+        std::fill(&depth[(size_t)y * stride + x0], &depth[(size_t)y * stride + x1] + 1, 1.0f);
+    }
+
+    for (const Chunk& chunk : chunks) {
+        for (uint32_t index : chunk.triangleBins[tile]) {
+            const Triangle& t = chunk.triangles[index];
+            RasterTriangle(t, std::max(x0, t.minX), std::max(y0, t.minY),
+                std::min(x1, t.maxX), std::min(y1, t.maxY));
+        }
+    }
+
+    // Edges over every face of the tile, the selection outline last
+    for (int pass = 0; pass < 2; ++pass) {
+        for (const Chunk& chunk : chunks) {
+            for (uint32_t index : chunk.lineBins[tile]) {
+                const Line& l = chunk.lines[index];
+                if (l.outline == (pass == 1)) {
+                    RasterLine(l, x0, y0, x1, y1);
+                }
+            }
+        }
+    }
+}
+
+// Bilinear, GL_REPEAT
+static uint32_t SampleBilinear(const std::vector<uint32_t>& texels, int w, int h, float u, float v)
+{
+    float fu = std::min(std::max(u * w - 0.5f, -1e6f), 1e6f);
+    float fv = std::min(std::max(v * h - 0.5f, -1e6f), 1e6f);
+    float flu = std::floor(fu), flv = std::floor(fv);
+    uint32_t fx = (uint32_t)((fu - flu) * 256.0f);
+    uint32_t fy = (uint32_t)((fv - flv) * 256.0f);
+    int x0 = Wrap((int)flu, w), y0 = Wrap((int)flv, h);
+    int x1 = x0 + 1 < w ? x0 + 1 : 0;
+    int y1 = y0 + 1 < h ? y0 + 1 : 0;
+    uint32_t t00 = texels[(size_t)y0 * w + x0], t10 = texels[(size_t)y0 * w + x1];
+    uint32_t t01 = texels[(size_t)y1 * w + x0], t11 = texels[(size_t)y1 * w + x1];
+
+    uint32_t out = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        uint32_t top = ((t00 >> shift) & 255) * (256 - fx) + ((t10 >> shift) & 255) * fx;
+        uint32_t bottom = ((t01 >> shift) & 255) * (256 - fx) + ((t11 >> shift) & 255) * fx;
+        out |= ((top * (256 - fy) + bottom * fy) >> 16) << shift;
+    }
+    return out;
+}
+
+void SoftwareRasterizer::ShadeGroup(const Triangle& t, int x, float py, int mask, uint32_t* dst)
+{
+    for (int i = 0; i < 4; ++i) {
+        if (!(mask & (1 << i))) {
+            continue;
+        }
+        float px = x + i + 0.5f;
+        float w = 1.0f / (t.invW.a * px + t.invW.b * py + t.invW.c);
+        float light = std::min(std::max((t.light.a * px + t.light.b * py + t.light.c) * w, 0.0f), 1.0f);
+        uint32_t l8 = (uint32_t)(light * 256.0f);
+        if (l8 > 256) l8 = 256;
+
+        if (t.texture) {
+            float u = (t.u.a * px + t.u.b * py + t.u.c) * w;
+            float v = (t.v.a * px + t.v.b * py + t.v.c) * w;
+            uint32_t texel = SampleBilinear(t.texture->texels, t.texture->width, t.texture->height, u, v);
+            // GL_MODULATE with a grey lit color: scale RGB, keep alpha
+            uint32_t r = ((texel & 255) * l8) >> 8;
+            uint32_t g = (((texel >> 8) & 255) * l8) >> 8;
+            uint32_t b = (((texel >> 16) & 255) * l8) >> 8;
+            dst[i] = r | (g << 8) | (b << 16) | (texel & 0xff000000u);
+        }
+        else {
+            uint32_t c = (255 * l8) >> 8;
+            dst[i] = c | (c << 8) | (c << 16) | 0xff000000u;
+        }
+    }
+}
+
+void SoftwareRasterizer::RasterTriangle(const Triangle& t, int x0, int y0, int x1, int y1)
+{
+    if (x0 > x1 || y0 > y1) {
+        return;
+    }
+    // Groups of four start on a multiple of 4, which never leaves the tile
+    const int xs = x0 & ~3;
+
+#if RASTER_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 lanes = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+    const __m128 ea0 = _mm_set1_ps(t.edge[0].a), ea1 = _mm_set1_ps(t.edge[1].a), ea2 = _mm_set1_ps(t.edge[2].a);
+    const __m128 za = _mm_set1_ps(t.z.a);
+    const __m128 step0 = _mm_set1_ps(t.edge[0].a * 4.0f);
+    const __m128 step1 = _mm_set1_ps(t.edge[1].a * 4.0f);
+    const __m128 step2 = _mm_set1_ps(t.edge[2].a * 4.0f);
+    const __m128 zStep = _mm_set1_ps(t.z.a * 4.0f);
+
+    for (int y = y0; y <= y1; ++y) {
+        const float py = y + 0.5f;
+        const __m128 px = _mm_add_ps(_mm_set1_ps((float)xs), lanes);
+        __m128 e0 = _mm_add_ps(_mm_mul_ps(ea0, px), _mm_set1_ps(t.edge[0].b * py + t.edge[0].c));
+        __m128 e1 = _mm_add_ps(_mm_mul_ps(ea1, px), _mm_set1_ps(t.edge[1].b * py + t.edge[1].c));
+        __m128 e2 = _mm_add_ps(_mm_mul_ps(ea2, px), _mm_set1_ps(t.edge[2].b * py + t.edge[2].c));
+        __m128 z = _mm_add_ps(_mm_mul_ps(za, px), _mm_set1_ps(t.z.b * py + t.z.c));
+        uint32_t* colorRow = &color[(size_t)y * stride];
+        float* depthRow = &depth[(size_t)y * stride];
+
+        for (int x = xs; x <= x1; x += 4) {
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                _mm_cmpge_ps(e2, zero));
+            if (_mm_movemask_ps(inside)) {
+                __m128 d = _mm_loadu_ps(depthRow + x);
+                __m128 pass = _mm_and_ps(inside, _mm_cmplt_ps(z, d));
+                int mask = _mm_movemask_ps(pass);
+                if (mask) {
+                    _mm_storeu_ps(depthRow + x, _mm_or_ps(_mm_and_ps(pass, z), _mm_andnot_ps(pass, d)));
+                    ShadeGroup(t, x, py, mask, colorRow + x);
+                }
+            }
+            e0 = _mm_add_ps(e0, step0);
+            e1 = _mm_add_ps(e1, step1);
+            e2 = _mm_add_ps(e2, step2);
+            z = _mm_add_ps(z, zStep);
+        }
+    }
+#else
+    for (int y = y0; y <= y1; ++y) {
+        const float py = y + 0.5f;
+        uint32_t* colorRow = &color[(size_t)y * stride];
+        float* depthRow = &depth[(size_t)y * stride];
+        for (int x = xs; x <= x1; x += 4) {
+            int mask = 0;
+            for (int i = 0; i < 4; ++i) {
+                float px = x + i + 0.5f;
+                bool inside = true;
+                for (int k = 0; k < 3; ++k) {
+                    inside = inside && t.edge[k].a * px + t.edge[k].b * py + t.edge[k].c >= 0.0f;
+                }
+                float z = t.z.a * px + t.z.b * py + t.z.c;
+                if (inside && z < depthRow[x + i]) {
+                    depthRow[x + i] = z;
+                    mask |= 1 << i;
+                }
+            }
+            if (mask) {
+                ShadeGroup(t, x, py, mask, colorRow + x);
+            }
+        }
+    }
+#endif
+}
+
+void SoftwareRasterizer::RasterLine(const Line& l, int x0, int y0, int x1, int y1)
+{
+    // One pixel per column (or row, for steep lines) along the major axis,
+    // widened across the minor one; tested against the faces' depth
+    const float dx = l.x1 - l.x0, dy = l.y1 - l.y0, dz = l.z1 - l.z0;
+    const bool steep = std::fabs(dy) > std::fabs(dx);
+    const float major0 = steep ? l.y0 : l.x0;
+    const float dMajor = steep ? dy : dx;
+    const float dMinor = steep ? dx : dy;
+    const float minor0 = steep ? l.x0 : l.y0;
+    if (dMajor == 0.0f) {
+        return;     // zero length
+    }
+
+    const int lo = std::max(steep ? y0 : x0, (int)std::ceil(std::min(major0, major0 + dMajor) - 0.5f));
+    const int hi = std::min(steep ? y1 : x1, (int)std::floor(std::max(major0, major0 + dMajor) - 0.5f));
+    const int half = l.width / 2;
+    for (int m = lo; m <= hi; ++m) {
+        float t = (m + 0.5f - major0) / dMajor;
+        float z = l.z0 + t * dz - kLineDepthBias;
+        int n = (int)std::floor(minor0 + t * dMinor);
+        for (int o = n - half; o <= n + half; ++o) {
+            int px = steep ? o : m;
+            int py = steep ? m : o;
+            if (px < x0 || px > x1 || py < y0 || py > y1) {
+                continue;
+            }
+            size_t i = (size_t)py * stride + px;
+            if (z < depth[i]) {
+                color[i] = l.color;
+            }
+        }
+    }
+}
+
+void SoftwareRasterizer::Present() const
+{
+    if (color.empty()) {
+        return;
+    }
+    PROFILE_SCOPE("SoftwareRasterizer::Present");
+    PROFILE_GPU_SCOPE("Software frame upload");
+    glPushAttrib(GL_ENABLE_BIT);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_TEXTURE_2D);
+    glWindowPos2i(0, 0);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, stride);
+    glDrawPixels(width, height, GL_RGBA, GL_UNSIGNED_BYTE, color.data());
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPopAttrib();
+}
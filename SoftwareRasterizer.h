@@ -0,0 +1,171 @@
+// SoftwareRasterizer.h
+#pragma once
+#include <GL/freeglut.h>
+#include <glm/glm.hpp>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+#include "ThreadPool.h"
+
+class Mesh;
+class Object3D;
+class RenderQueue;
+class Texture2D;
+class TextureStreamer;
+
+// CPU renderer for the engine's RenderQueue, for machines without a usable
+// GPU. It reproduces the fixed-function setup the engine uses: LIGHT0 lit
+// per vertex, smooth or flat shading, GL_MODULATE texturing, black
+// wireframe edges and the selected object's orange outline.
+//
+// Objects are transformed and lit in parallel chunks, their triangles
+// clipped (near plane and a guard band) and binned into 64x64 screen
+// tiles. Tiles are rasterized in parallel: every worker starts on its own
+// run of tiles and, once that is done, steals from the far end of the
+// others'. A tile walks its triangles four pixels at a time with SSE2 edge
+// functions and a depth buffer, sampling textures bilinearly and
+// perspective-correct from a CPU copy of their mip chain (one level per
+// triangle, picked by its texel-to-pixel ratio).
+class SoftwareRasterizer {
+public:
+    // threads = 0 lets ThreadPool pick; the calling thread renders too
+    explicit SoftwareRasterizer(unsigned threads = 0);
+
+    // Size of the color and depth buffers in pixels
+    void Resize(int w, int h);
+
+    // Draw a sorted queue as seen through view and projection. Textures are
+    // read from the full chains streamer keeps for them; others draw white
+    void Render(const RenderQueue& queue, const glm::mat4& view, const glm::mat4& projection,
+        bool lighting, bool smooth, const glm::vec3& clearColor, const TextureStreamer& streamer);
+
+    // Copy the color buffer into the GL back buffer (GL thread)
+    void Present() const;
+
+    // RGBA8 pixels, rows bottom-up like glReadPixels, GetStride() pixels apart
+    const uint32_t* GetColor() const { return color.data(); }
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+    int GetStride() const { return stride; }
+
+    // Triangles that reached setup (after clipping) and tiles stolen by
+    // another worker in the last Render
+    size_t GetTriangleCount() const { return triangleCount; }
+    size_t GetStealCount() const { return stealCount; }
+
+    // Forget the CPU copies of the textures (they are kept between frames,
+    // so the engine calls this when it stops rendering in software)
+    void ReleaseTextures() { textures.clear(); }
+
+private:
+    SoftwareRasterizer(const SoftwareRasterizer&) = delete;
+    SoftwareRasterizer& operator=(const SoftwareRasterizer&) = delete;
+
+    // a * x + b * y + c over window coordinates
+    struct Plane {
+        float a, b, c;
+    };
+
+    struct MipLevel {
+        int width, height;
+        std::vector<uint32_t> texels;   // RGBA8, rows bottom-up
+    };
+
+    struct CpuTexture {
+        std::vector<MipLevel> levels;
+        uint64_t generation = 0;        // streamer generation it was copied from
+    };
+
+    // One object to draw
+    struct Draw {
+        Object3D* object;
+        const Mesh* mesh;
+        const CpuTexture* texture;
+        bool selected;
+    };
+
+    // Vertex after transform and lighting
+    struct ClipVertex {
+        glm::vec4 pos;      // clip space
+        glm::vec2 uv;
+        float light;        // lit intensity of the (white) material
+    };
+
+    struct Triangle {
+        Plane edge[3];      // >= 0 inside (top-left rule folded into c)
+        Plane z;            // window depth
+        Plane invW;         // 1/w, and the attributes divided by w
+        Plane u, v, light;
+        int minX, minY, maxX, maxY;
+        const MipLevel* texture;
+    };
+
+    struct Line {
+        float x0, y0, z0, x1, y1, z1;
+        uint32_t color;
+        int width;
+        bool outline;       // drawn after every other line
+    };
+
+    // A worker's share of the geometry stage; tiles read every chunk's
+    // bins in order, so the result doesn't depend on the thread count
+    struct Chunk {
+        std::vector<ClipVertex> vertices;
+        std::vector<Triangle> triangles;
+        std::vector<Line> lines;
+        std::vector<std::vector<uint32_t>> triangleBins;    // per tile
+        std::vector<std::vector<uint32_t>> lineBins;
+    };
+
+    // CPU copy of tex's chain from streamer; nullptr if it has none. Copies
+    // are keyed by pointer and redone when the streamer's generation for the
+    // texture changes, so a reloaded texture or a new one at a freed address
+    // is never drawn with stale texels
+    const CpuTexture* GetTexture(const Texture2D* tex, const TextureStreamer& streamer);
+
+    void TransformChunk(Chunk& chunk, size_t first, size_t count);
+    void ClipTriangle(Chunk& chunk, const ClipVertex* tri, float flatLight, const CpuTexture* texture);
+    void SetupTriangle(Chunk& chunk, const ClipVertex& a, const ClipVertex& b, const ClipVertex& c,
+        float flatLight, const CpuTexture* texture);
+    void ClipLine(Chunk& chunk, ClipVertex a, ClipVertex b, uint32_t color, int lineWidth, bool outline);
+
+    void RasterTile(int tile);
+    void RasterTriangle(const Triangle& t, int x0, int y0, int x1, int y1);
+    void RasterLine(const Line& l, int x0, int y0, int x1, int y1);
+
+    // Shade the pixels of a 4-wide group whose bits are set in mask
+    static void ShadeGroup(const Triangle& t, int x, float py, int mask, uint32_t* dst);
+
+    // Work-stealing tile queues: each packs [begin, end) into tileOrder
+    bool PopFront(int lane, int& tile);
+    bool StealBack(int lane, int& tile);
+
+    unsigned threadCount;
+    std::unique_ptr<ThreadPool> pool;   // started by the first Render
+
+    int width = 0, height = 0;
+    int stride = 0;                     // width rounded up to 4
+    int tilesX = 0, tilesY = 0;
+    std::vector<uint32_t> color;
+    std::vector<float> depth;
+
+    // Per-frame state shared with the workers
+    glm::mat4 view, projection;
+    bool lighting = true;
+    bool smooth = true;
+    uint32_t clearValue = 0;
+    float guardBand = 1.0f;             // clip |x|, |y| to guardBand * w
+    std::vector<Draw> draws;
+    std::vector<Chunk> chunks;
+    size_t chunkSize = 1;
+    std::vector<int> tileOrder;
+    std::unique_ptr<std::atomic<uint64_t>[]> laneQueues;
+    int laneCount = 0;
+    std::atomic<size_t> steals;
+
+    std::map<const Texture2D*, CpuTexture> textures;
+    size_t triangleCount = 0;
+    size_t stealCount = 0;
+};
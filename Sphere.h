@@ -1,7 +1,28 @@
 #pragma once
 #include "Object3D.h"
+#include <memory>
 
 class Sphere : public Object3D {
 public:
-    void Draw() override;
+    Sphere(int slices = 32, int stacks = 32)
+        : slices(slices), stacks(stacks)
+    {
+        // Radius 0.5 around the origin
+        SetLocalBounds(AABB(glm::vec3(-0.5f), glm::vec3(0.5f)));
+    }
+
+    Mesh* GetMesh() override;
+
+    // Ray against the radius 0.5 sphere
+    bool IntersectLocalRay(const glm::vec3& origin, const glm::vec3& dir, float& t) const override;
+
+    int GetSlices() const { return slices; }
+    int GetStacks() const { return stacks; }
+
+private:
+    int slices;
+    int stacks;
+
+    // Tessellation shared with every sphere of the same (slices, stacks)
+    std::shared_ptr<Mesh> mesh;
 };
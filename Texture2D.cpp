@@ -2,77 +2,196 @@
 #include <GL/glew.h>
 #include <GL/freeglut.h>
 #include "Texture2D.h"
+#include "MipGenerator.h"
+#include "PixelUploadRing.h"
+#include "Profiler.h"
+#include "RenderState.h"
 #include <iostream>
+#include <vector>
 
-#define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
 Texture2D::Texture2D(const char* filepath)
 {
+    PROFILE_SCOPE("Texture2D load");
+
     // Load the image from disk with stb_image
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char* data = stbi_load(filepath, &width, &height, &numChan, 0);
+    int w, h, chan;
+    unsigned char* data = Decode(filepath, w, h, chan);
     if (!data) {
         std::cerr << "Failed to load texture \"" << filepath << "\"\n";
         return; // id remains 0
     }
+    Upload(data, w, h, chan, filepath);
+    FreeImage(data);
+}
+
+unsigned char* Texture2D::Decode(const char* filepath, int& w, int& h, int& channels)
+{
+    // GL expects the first row at the bottom; the flag is per thread
+    stbi_set_flip_vertically_on_load_thread(true);
+    return stbi_load(filepath, &w, &h, &channels, 0);
+}
+
+void Texture2D::FreeImage(unsigned char* pixels)
+{
+    stbi_image_free(pixels);
+}
+
+bool Texture2D::Upload(const unsigned char* pixels, int w, int h, int channels, const char* name)
+{
+    PROFILE_SCOPE("Texture2D::Upload");
+
+    // Build the mips on the CPU rather than with glGenerateMipmap, which
+    // some drivers run as a slow software path
+    std::vector<std::vector<unsigned char>> chain(1);
+    chain[0].assign(pixels, pixels + (size_t)w * h * channels);
+    MipGenerator::BuildChain(w, h, channels, chain);
+
+    std::vector<const unsigned char*> levels;
+    for (const std::vector<unsigned char>& level : chain) {
+        levels.push_back(level.data());
+    }
+    return UploadMipChain(levels.data(), (int)levels.size(), w, h, channels, name);
+}
 
-    //Figure out format (GL_RED, GL_RGB, or GL_RGBA)
-    GLenum format = GL_RGB;
-    if (numChan == 1) format = GL_RED;
-    else if (numChan == 3) format = GL_RGB;
-    else if (numChan == 4) format = GL_RGBA;
+GLenum Texture2D::GLFormat(BlockCompressor::Format format, int channels)
+{
+    switch (format) {
+    case BlockCompressor::Format::None:
+        return channels == 1 ? GL_RED : channels == 3 ? GL_RGB : channels == 4 ? GL_RGBA : 0;
+    case BlockCompressor::Format::BC1:
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case BlockCompressor::Format::BC3:
+        return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case BlockCompressor::Format::BC7:
+        return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    default:
+        return 0;
+    }
+}
+
+void Texture2D::Bind() const
+{
+    // Go through the state tracker when there is one so repeat binds are skipped
+    if (RenderState::instance) {
+        RenderState::instance->BindTexture(id);
+    }
+    else {
+        glBindTexture(GL_TEXTURE_2D, id);
+    }
+}
+
+void Texture2D::Unbind()
+{
+    if (RenderState::instance) {
+        RenderState::instance->BindTexture(0);
+    }
     else {
-        std::cerr << "Unsupported channel count (" << numChan
-            << ") in texture \"" << filepath << "\"\n";
-        stbi_image_free(data);
-        return;
-    }
-
-    // Generate a single GL texture name and bind it
-    glGenTextures(1, &id);
-    glBindTexture(GL_TEXTURE_2D, id);
-
-    // Upload the pixel data to the GPU (level 0)
-    glTexImage2D(
-        GL_TEXTURE_2D,
-        0,             // mipmap level
-        format,        // internal format
-        width, height,
-        0,             // border (must be 0)
-        format,        // data format
-        GL_UNSIGNED_BYTE,
-        data           // pointer to the image data
-    );
-
-    // Generate mipmaps 
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    // Set wrap/filter parameters
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+}
+
+bool Texture2D::UploadMipChain(const unsigned char* const* levels, int levelCount,
+    int w, int h, int channels, const char* name)
+{
+    PROFILE_SCOPE("Texture2D::UploadMipChain");
+    GLenum format = GLFormat(BlockCompressor::Format::None, channels);
+    if (format == 0) {
+        std::cerr << "Unsupported channel count (" << channels
+            << ") in texture \"" << name << "\"\n";
+        return false;
+    }
+    width = w;
+    height = h;
+    numChan = channels;
+
+    if (id == 0) {
+        glGenTextures(1, &id);
+    }
+    Bind();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // No glGenerateMipmap: every level comes from the caller. Levels go
+    // through the staging ring when there is one, so GL needn't copy them
+    // out of our memory before returning
+    PixelUploadRing* ring = PixelUploadRing::instance;
+    byteSize = 0;
+    int lw = w, lh = h;
+    for (int level = 0; level < levelCount; ++level) {
+        size_t bytes = (size_t)lw * lh * channels;
+        const void* src = ring ? ring->Stage(levels[level], bytes) : levels[level];
+        glTexImage2D(GL_TEXTURE_2D, level, format, lw, lh, 0, format, GL_UNSIGNED_BYTE, src);
+        byteSize += bytes;
+        lw = lw > 1 ? lw / 2 : 1;
+        lh = lh > 1 ? lh / 2 : 1;
+    }
+    if (ring) {
+        ring->Finish();
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    // Unbind and free the CPU memory
-    glBindTexture(GL_TEXTURE_2D, 0);
-    stbi_image_free(data);
+    Unbind();
+    return true;
 }
 
-void Texture2D::Bind() const
+bool Texture2D::UploadCompressedMipChain(const unsigned char* const* levels, int levelCount,
+    int w, int h, BlockCompressor::Format format, const char* name)
 {
-    glBindTexture(GL_TEXTURE_2D, id);
-}
+    PROFILE_SCOPE("Texture2D::UploadCompressedMipChain");
+    int channels = format == BlockCompressor::Format::BC1 ? 3 : 4;
+    GLenum internalFormat = GLFormat(format, channels);
+    if (format == BlockCompressor::Format::None || internalFormat == 0) {
+        std::cerr << "Unsupported compressed format in texture \"" << name << "\"\n";
+        return false;
+    }
+    width = w;
+    height = h;
+    numChan = channels;
 
-void Texture2D::Unbind()
-{
-    glBindTexture(GL_TEXTURE_2D, 0);
+    if (id == 0) {
+        glGenTextures(1, &id);
+    }
+    Bind();
+
+    PixelUploadRing* ring = PixelUploadRing::instance;
+    byteSize = 0;
+    int lw = w, lh = h;
+    for (int level = 0; level < levelCount; ++level) {
+        GLsizei size = (GLsizei)BlockCompressor::LevelSize(format, lw, lh);
+        const void* src = ring ? ring->Stage(levels[level], size) : levels[level];
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, lw, lh, 0, size, src);
+        byteSize += size;
+        lw = lw > 1 ? lw / 2 : 1;
+        lh = lh > 1 ? lh / 2 : 1;
+    }
+    if (ring) {
+        ring->Finish();
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    Unbind();
+    return true;
 }
 
 void Texture2D::Delete()
 {
     if (id != 0) {
         glDeleteTextures(1, &id);
+        if (RenderState::instance) {
+            RenderState::instance->OnTextureDeleted(id);
+        }
         id = 0;
     }
 }
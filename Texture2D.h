@@ -1,12 +1,43 @@
 #pragma once
 #include <GL/freeglut.h>
 #include <string>
+#include "BlockCompressor.h"
 
 class Texture2D {
 public:
+    // Empty texture (id=0), filled in later with Upload
+    Texture2D() = default;
+
     // Load a 2D texture from disk (using stb_image), if fails id=0
     Texture2D(const char* filepath);
 
+    // Decode an image file into bottom-up rows ready for upload. Safe to
+    // call from any thread. Returns nullptr on failure; free with FreeImage
+    static unsigned char* Decode(const char* filepath, int& w, int& h, int& channels);
+    static void FreeImage(unsigned char* pixels);
+
+    // Create the GL texture from decoded pixels, building the mip chain on
+    // the CPU. Needs the GL context; name is only used in error messages.
+    // Returns false on failure
+    bool Upload(const unsigned char* pixels, int w, int h, int channels, const char* name);
+
+    // Create the GL texture from a prebuilt mip chain (level 0 first, each
+    // level half the size of the one above), uploading every level as given
+    bool UploadMipChain(const unsigned char* const* levels, int levelCount,
+        int w, int h, int channels, const char* name);
+
+    // Same for a block-compressed chain (glCompressedTexImage2D); each level
+    // holds BlockCompressor::LevelSize bytes. The GL must support format
+    bool UploadCompressedMipChain(const unsigned char* const* levels, int levelCount,
+        int w, int h, BlockCompressor::Format format, const char* name);
+
+    // GL format for pixels of the given encoding (internal and external
+    // format for raw pixels); 0 if there is none
+    static GLenum GLFormat(BlockCompressor::Format format, int channels);
+
+    // True while an asynchronous load for this texture is still in flight
+    bool IsPending() const { return pending; }
+
     // Bind this texture (GL_TEXTURE_2D) on the active texture unit
     void Bind() const;
 
@@ -21,9 +52,23 @@ public:
     int    GetWidth()  const { return width; }
     int    GetHeight() const { return height; }
 
+    // GPU memory held by the full mip chain (0 if not uploaded)
+    size_t GetByteSize() const { return id != 0 ? byteSize : 0; }
+
+    // Layer holding a copy of this texture in the TextureArray, or -1
+    int    GetArrayLayer() const { return arrayLayer; }
+
 private:
+    friend class TextureLoader;
+    friend class TextureStreamer;
+    friend class TextureArray;
+
     GLuint id = 0;
     int    width = 0;
     int    height = 0;
     int    numChan = 0;
+    size_t byteSize = 0;
+    bool   pending = false;
+    int    streamSlot = -1;     // entry in the TextureStreamer managing it, if any
+    int    arrayLayer = -1;     // layer in the TextureArray, if any
 };
@@ -0,0 +1,144 @@
+// TextureArray.cpp
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+#include "TextureArray.h"
+#include "Texture2D.h"
+#include "TextureStreamer.h"
+#include "PixelUploadRing.h"
+#include <algorithm>
+#include <iostream>
+
+// Same size, encoding and mip count: can share one array
+static bool SameShape(const TextureImage& a, const TextureImage& b)
+{
+    return a.width == b.width && a.height == b.height && a.channels == b.channels &&
+        a.format == b.format && a.levels.size() == b.levels.size();
+}
+
+int TextureArray::Build(const std::vector<std::shared_ptr<Texture2D>>& textures, const TextureStreamer& streamer)
+{
+    Delete();
+    if (!GLEW_VERSION_3_0 && !GLEW_EXT_texture_array) {
+        std::cerr << "Texture arrays not supported, binding textures per draw\n";
+        return 0;
+    }
+
+    // Distinct textures whose full chain is still around to copy from
+    std::vector<std::shared_ptr<Texture2D>> candidates;
+    for (const std::shared_ptr<Texture2D>& tex : textures) {
+        if (tex && streamer.GetImage(tex.get()) &&
+            std::find(candidates.begin(), candidates.end(), tex) == candidates.end()) {
+            candidates.push_back(tex);
+        }
+    }
+
+    // The most common shape gets the array
+    const TextureImage* shape = nullptr;
+    int shapeCount = 0;
+    for (const std::shared_ptr<Texture2D>& a : candidates) {
+        const TextureImage& img = *streamer.GetImage(a.get());
+        int count = (int)std::count_if(candidates.begin(), candidates.end(),
+            [&](const std::shared_ptr<Texture2D>& b) { return SameShape(img, *streamer.GetImage(b.get())); });
+        if (count > shapeCount) {
+            shape = &img;
+            shapeCount = count;
+        }
+    }
+    if (shapeCount < 2) {
+        return 0;   // a single layer saves no binds
+    }
+
+    const GLenum format = Texture2D::GLFormat(shape->format, shape->channels);
+    const bool compressed = shape->format != BlockCompressor::Format::None;
+    const int levelCount = (int)shape->levels.size();
+    if (format == 0) {
+        return 0;
+    }
+
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // Storage for every layer first, then one sub-upload per layer and level
+    for (int level = 0; level < levelCount; ++level) {
+        int w = std::max(1, shape->width >> level);
+        int h = std::max(1, shape->height >> level);
+        size_t bytes = (size_t)TextureFile::LevelBytes(shape->format, w, h, shape->channels);
+        if (compressed) {
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, format, w, h, shapeCount, 0,
+                (GLsizei)(bytes * shapeCount), nullptr);
+        }
+        else {
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, format, w, h, shapeCount, 0,
+                format, GL_UNSIGNED_BYTE, nullptr);
+        }
+        byteSize += bytes * shapeCount;
+    }
+
+    PixelUploadRing* ring = PixelUploadRing::instance;
+    for (const std::shared_ptr<Texture2D>& tex : candidates) {
+        const TextureImage& img = *streamer.GetImage(tex.get());
+        if (!SameShape(img, *shape)) {
+            continue;
+        }
+        int layer = (int)layers.size();
+        for (int level = 0; level < levelCount; ++level) {
+            int w = std::max(1, img.width >> level);
+            int h = std::max(1, img.height >> level);
+            size_t bytes = (size_t)TextureFile::LevelBytes(img.format, w, h, img.channels);
+            const void* src = ring ? ring->Stage(img.levels[level], bytes) : img.levels[level];
+            if (compressed) {
+                glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, w, h, 1,
+                    format, (GLsizei)bytes, src);
+            }
+            else {
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, w, h, 1,
+                    format, GL_UNSIGNED_BYTE, src);
+            }
+        }
+        tex->arrayLayer = layer;
+        layers.push_back(tex);
+    }
+    if (ring) {
+        ring->Finish();
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    return (int)layers.size();
+}
+
+void TextureArray::Delete()
+{
+    for (const std::weak_ptr<Texture2D>& layer : layers) {
+        if (std::shared_ptr<Texture2D> tex = layer.lock()) {
+            tex->arrayLayer = -1;
+        }
+    }
+    layers.clear();
+    if (id != 0) {
+        glDeleteTextures(1, &id);
+        id = 0;
+    }
+    byteSize = 0;
+}
+
+void TextureArray::Bind(int unit) const
+{
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void TextureArray::Unbind(int unit)
+{
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glActiveTexture(GL_TEXTURE0);
+}
@@ -0,0 +1,38 @@
+// TextureArray.h
+#pragma once
+#include <GL/freeglut.h>
+#include <memory>
+#include <vector>
+
+class Texture2D;
+class TextureStreamer;
+
+// One GL_TEXTURE_2D_ARRAY holding copies of the engine's textures, one per
+// layer, so objects with different textures can share an instanced draw
+// and pick their texture by layer index instead of by bind. Layers must
+// all have the same size, format and mip count; Build takes the largest
+// set of textures that agree and leaves the rest to their own binds.
+class TextureArray {
+public:
+    // Pack textures (duplicates share a layer) from the full mip chains
+    // streamer keeps for them. Needs the GL context and EXT_texture_array.
+    // Returns the number of layers; 0 leaves the array empty
+    int Build(const std::vector<std::shared_ptr<Texture2D>>& textures, const TextureStreamer& streamer);
+
+    // Delete the GL texture and clear the textures' layer indices
+    void Delete();
+
+    bool   IsBuilt() const { return id != 0; }
+    GLuint GetID() const { return id; }
+    int    GetLayerCount() const { return (int)layers.size(); }
+    size_t GetByteSize() const { return byteSize; }
+
+    // Bind the array on texture unit `unit`, leaving unit 0 active
+    void Bind(int unit) const;
+    static void Unbind(int unit);
+
+private:
+    GLuint id = 0;
+    size_t byteSize = 0;
+    std::vector<std::weak_ptr<Texture2D>> layers;
+};
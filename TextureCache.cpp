@@ -0,0 +1,97 @@
+// TextureCache.cpp
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+#include "TextureCache.h"
+#include "TextureLoader.h"
+#include "Texture2D.h"
+#include "TextureFile.h"
+#include <cstdlib>
+#include <set>
+#ifdef _WIN32
+#include <cctype>
+#else
+#include <climits>
+#endif
+
+// Absolute path with symlinks / ".." resolved, so different spellings of
+// the same file share one key. Falls back to the path as given
+static std::string CanonicalPath(const char* path)
+{
+#ifdef _WIN32
+    char buf[_MAX_PATH];
+    if (!_fullpath(buf, path, _MAX_PATH)) {
+        return path;
+    }
+    // NTFS is case-insensitive and accepts either slash
+    std::string s(buf);
+    for (char& c : s) {
+        c = (c == '/') ? '\\' : (char)std::tolower((unsigned char)c);
+    }
+    return s;
+#else
+    char buf[PATH_MAX];
+    if (!realpath(path, buf)) {
+        return path;
+    }
+    return buf;
+#endif
+}
+
+TextureCache::TextureCache(TextureLoader& loader)
+    : loader(loader)
+{}
+
+std::shared_ptr<Texture2D> TextureCache::Get(const char* path)
+{
+    std::string key = CanonicalPath(path);
+    std::weak_ptr<Texture2D>& entry = byPath[key];
+    if (std::shared_ptr<Texture2D> tex = entry.lock()) {
+        ++dedupCount;
+        return tex;
+    }
+
+    // Same bytes under another name: share that texture too. The hash comes
+    // from the file's .texcache header, so nothing is read in full here;
+    // without a valid cache file (first run) the copies load separately
+    uint64_t hash;
+    bool hashed = TextureFile::CachedHash(key, hash);
+    if (hashed) {
+        if (std::shared_ptr<Texture2D> tex = byHash[hash].lock()) {
+            entry = tex;
+            ++dedupCount;
+            return tex;
+        }
+    }
+
+    std::shared_ptr<Texture2D> tex = loader.Load(path);
+    entry = tex;
+    if (hashed) {
+        byHash[hash] = tex;
+    }
+    return tex;
+}
+
+size_t TextureCache::GetLiveCount() const
+{
+    std::set<const Texture2D*> live;
+    for (const auto& entry : byPath) {
+        if (std::shared_ptr<Texture2D> tex = entry.second.lock()) {
+            live.insert(tex.get());
+        }
+    }
+    return live.size();
+}
+
+size_t TextureCache::GetResidentBytes() const
+{
+    // Several paths can map to one texture; count each texture once
+    std::set<const Texture2D*> seen;
+    size_t bytes = 0;
+    for (const auto& entry : byPath) {
+        std::shared_ptr<Texture2D> tex = entry.second.lock();
+        if (tex && seen.insert(tex.get()).second) {
+            bytes += tex->GetByteSize();
+        }
+    }
+    return bytes;
+}
@@ -0,0 +1,36 @@
+// TextureCache.h
+#pragma once
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+class Texture2D;
+class TextureLoader;
+
+class TextureCache {
+public:
+    // New textures are decoded and uploaded through loader
+    explicit TextureCache(TextureLoader& loader);
+
+    // Shared texture for an image file. Requests for the same file (by
+    // canonical path) or for a file with identical contents (by the hash
+    // its .texcache records) get the same handle; the GL texture is freed
+    // when the last handle goes
+    std::shared_ptr<Texture2D> Get(const char* path);
+
+    // Distinct textures currently alive
+    size_t GetLiveCount() const;
+
+    // GPU bytes held by the live textures, mip chains included
+    size_t GetResidentBytes() const;
+
+    // Requests answered with an existing texture instead of a new load
+    size_t GetDedupCount() const { return dedupCount; }
+
+private:
+    TextureLoader& loader;
+    std::map<std::string, std::weak_ptr<Texture2D>> byPath;
+    std::map<uint64_t, std::weak_ptr<Texture2D>> byHash;
+    size_t dedupCount = 0;
+};
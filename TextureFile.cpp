@@ -0,0 +1,326 @@
+// TextureFile.cpp
+#include "TextureFile.h"
+#include "MappedFile.h"
+#include "MipGenerator.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+namespace TextureFile {
+
+static const char     kMagic[4] = { 'T', 'X', 'C', '1' };
+static const uint32_t kVersion = 3;     // 2: block compression, 3: mip filter
+
+struct Header {
+    char     magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    uint32_t levelCount;
+    uint64_t sourceSize;
+    int64_t  sourceMtime;
+    uint64_t sourceHash;
+    uint32_t format;        // BlockCompressor::Format of the levels
+    uint32_t quality;       // BlockCompressor::Quality they were encoded with
+    uint32_t mipFilter;     // MipGenerator::Filter of levels 1..N
+    uint32_t mipFlags;      // kGammaCorrectMips
+};
+
+static const uint32_t kGammaCorrectMips = 1;
+
+struct LevelEntry {
+    uint64_t offset;     // from the start of the file, 16-byte aligned
+    uint64_t size;
+};
+
+static uint64_t AlignUp(uint64_t v)
+{
+    return (v + 15) & ~(uint64_t)15;
+}
+
+bool HashFile(const std::string& path, uint64_t& hash)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    hash = 14695981039346656037ull;
+    std::vector<char> buf(1 << 16);
+    while (in) {
+        in.read(buf.data(), buf.size());
+        std::streamsize n = in.gcount();
+        for (std::streamsize i = 0; i < n; ++i) {
+            hash ^= (unsigned char)buf[i];
+            hash *= 1099511628211ull;
+        }
+    }
+    return true;
+}
+
+bool ReadSourceInfo(const std::string& path, SourceInfo& info)
+{
+#ifdef _WIN32
+    struct _stat64 st;
+    if (_stat64(path.c_str(), &st) != 0) {
+        return false;
+    }
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+#endif
+    info.size = (uint64_t)st.st_size;
+    info.mtime = (int64_t)st.st_mtime;
+    info.hash = 0;
+    info.hashed = false;
+    return true;
+}
+
+bool HashSource(const std::string& path, SourceInfo& info)
+{
+    if (!info.hashed) {
+        info.hashed = HashFile(path, info.hash);
+    }
+    return info.hashed;
+}
+
+bool CachedHash(const std::string& path, uint64_t& hash)
+{
+    SourceInfo source;
+    if (!ReadSourceInfo(path, source)) {
+        return false;
+    }
+    FILE* f = std::fopen(CachePath(path).c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    Header h;
+    bool ok = std::fread(&h, sizeof(h), 1, f) == 1;
+    std::fclose(f);
+    if (!ok || std::memcmp(h.magic, kMagic, 4) != 0 || h.version != kVersion ||
+        h.sourceSize != source.size || h.sourceMtime != source.mtime) {
+        return false;
+    }
+    hash = h.sourceHash;
+    return true;
+}
+
+std::string CachePath(const std::string& sourcePath)
+{
+    return sourcePath + ".texcache";
+}
+
+uint64_t LevelBytes(BlockCompressor::Format format, int w, int h, int channels)
+{
+    if (format == BlockCompressor::Format::None) {
+        return (uint64_t)w * h * channels;
+    }
+    return BlockCompressor::LevelSize(format, w, h);
+}
+
+// Record the source's new mtime in an existing cache file's header
+static bool UpdateSourceMtime(const std::string& cachePath, int64_t mtime)
+{
+    FILE* f = std::fopen(cachePath.c_str(), "r+b");
+    if (!f) {
+        return false;
+    }
+    bool ok = std::fseek(f, (long)offsetof(Header, sourceMtime), SEEK_SET) == 0 &&
+        std::fwrite(&mtime, sizeof(mtime), 1, f) == 1;
+    ok = (std::fclose(f) == 0) && ok;
+    return ok;
+}
+
+bool Map(const std::string& cachePath, const std::string& sourcePath, SourceInfo& source,
+    const Options& options, TextureImage& image)
+{
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+    if (!file->Open(cachePath) || file->GetSize() < sizeof(Header)) {
+        return false;
+    }
+
+    Header h;
+    std::memcpy(&h, file->GetData(), sizeof(h));
+    if (std::memcmp(h.magic, kMagic, 4) != 0 || h.version != kVersion ||
+        h.sourceSize != source.size) {
+        return false;
+    }
+
+    // Same size and mtime: trust it. A touched or copied source is still
+    // fine if its bytes are the same, and the header takes the new mtime so
+    // the next start (or CachedHash) doesn't hash it again. The mapping is
+    // dropped meanwhile: Windows won't open a mapped file for writing
+    if (h.sourceMtime != source.mtime) {
+        if (!HashSource(sourcePath, source) || h.sourceHash != source.hash) {
+            return false;
+        }
+        file.reset();
+        UpdateSourceMtime(cachePath, source.mtime);
+        file = std::make_shared<MappedFile>();
+        if (!file->Open(cachePath) || file->GetSize() < sizeof(Header)) {
+            return false;
+        }
+        std::memcpy(&h, file->GetData(), sizeof(h));
+    }
+    if (h.width == 0 || h.height == 0 || h.channels < 1 || h.channels > 4 ||
+        h.levelCount == 0 || h.levelCount > 32 ||
+        file->GetSize() < sizeof(Header) + h.levelCount * sizeof(LevelEntry)) {
+        return false;
+    }
+
+    // Stale if written with another compression or mip setting
+    BlockCompressor::Format wanted = BlockCompressor::Resolve(options.format, (int)h.channels);
+    if (h.format != (uint32_t)wanted ||
+        (wanted != BlockCompressor::Format::None && h.quality != (uint32_t)options.quality) ||
+        h.mipFilter != (uint32_t)options.mipFilter ||
+        h.mipFlags != (options.gammaCorrectMips ? kGammaCorrectMips : 0)) {
+        return false;
+    }
+
+    // Every level must be the expected size and lie inside the file
+    const LevelEntry* table = reinterpret_cast<const LevelEntry*>(file->GetData() + sizeof(Header));
+    std::vector<const unsigned char*> levels;
+    uint32_t w = h.width, hgt = h.height;
+    for (uint32_t i = 0; i < h.levelCount; ++i) {
+        LevelEntry e;
+        std::memcpy(&e, &table[i], sizeof(e));
+        if (e.size != LevelBytes(wanted, (int)w, (int)hgt, (int)h.channels) || e.offset > file->GetSize() ||
+            e.size > file->GetSize() - e.offset) {
+            return false;
+        }
+        levels.push_back(file->GetData() + e.offset);
+        w = w > 1 ? w / 2 : 1;
+        hgt = hgt > 1 ? hgt / 2 : 1;
+    }
+
+    image.width = (int)h.width;
+    image.height = (int)h.height;
+    image.channels = (int)h.channels;
+    image.format = wanted;
+    image.levels.swap(levels);
+    image.storage.clear();
+    image.mapping = file;
+    image.fromCache = true;
+    return true;
+}
+
+bool Write(const std::string& cachePath, const SourceInfo& source, const Options& options,
+    const TextureImage& image)
+{
+    Header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, kMagic, 4);
+    h.version = kVersion;
+    h.width = (uint32_t)image.width;
+    h.height = (uint32_t)image.height;
+    h.channels = (uint32_t)image.channels;
+    h.levelCount = (uint32_t)image.levels.size();
+    h.sourceSize = source.size;
+    h.sourceMtime = source.mtime;
+    h.sourceHash = source.hash;
+    h.format = (uint32_t)image.format;
+    h.quality = (uint32_t)options.quality;
+    h.mipFilter = (uint32_t)options.mipFilter;
+    h.mipFlags = options.gammaCorrectMips ? kGammaCorrectMips : 0;
+
+    std::vector<LevelEntry> table(image.levels.size());
+    uint64_t offset = AlignUp(sizeof(Header) + table.size() * sizeof(LevelEntry));
+    int w = image.width, hgt = image.height;
+    for (size_t i = 0; i < table.size(); ++i) {
+        table[i].offset = offset;
+        table[i].size = LevelBytes(image.format, w, hgt, image.channels);
+        offset = AlignUp(offset + table[i].size);
+        w = w > 1 ? w / 2 : 1;
+        hgt = hgt > 1 ? hgt / 2 : 1;
+    }
+
+    // Write to a temporary name first so a reader never maps a partial file
+    std::string tmpPath = cachePath + ".tmp";
+    FILE* f = std::fopen(tmpPath.c_str(), "wb");
+    if (!f) {
+        return false;
+    }
+    bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1 &&
+        std::fwrite(table.data(), sizeof(LevelEntry), table.size(), f) == table.size();
+    static const char zeros[16] = {};
+    uint64_t pos = sizeof(h) + table.size() * sizeof(LevelEntry);
+    for (size_t i = 0; ok && i < table.size(); ++i) {
+        ok = std::fwrite(zeros, 1, (size_t)(table[i].offset - pos), f) == table[i].offset - pos &&
+            std::fwrite(image.levels[i], 1, (size_t)table[i].size, f) == table[i].size;
+        pos = table[i].offset + table[i].size;
+    }
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    std::remove(cachePath.c_str());
+    return std::rename(tmpPath.c_str(), cachePath.c_str()) == 0;
+}
+
+bool Load(const std::string& path, bool useCache, const Options& options, TextureImage& image)
+{
+    SourceInfo source;
+    bool haveSource = useCache && ReadSourceInfo(path, source);
+    std::string cachePath = CachePath(path);
+    if (haveSource && Map(cachePath, path, source, options, image)) {
+        return true;
+    }
+
+    // Cold path: decode and flip on this thread, then build the mip chain
+    // (rows shared with options.pool)
+    int w, h, channels;
+    stbi_set_flip_vertically_on_load_thread(true);
+    unsigned char* pixels = stbi_load(path.c_str(), &w, &h, &channels, 0);
+    if (!pixels) {
+        return false;
+    }
+    image.width = w;
+    image.height = h;
+    image.channels = channels;
+    image.storage.resize(1);
+    image.storage[0].assign(pixels, pixels + (size_t)w * h * channels);
+    stbi_image_free(pixels);
+    MipGenerator::Settings mips;
+    mips.filter = options.mipFilter;
+    mips.gammaCorrect = options.gammaCorrectMips;
+    mips.pool = options.pool;
+    MipGenerator::BuildChain(w, h, channels, image.storage, mips);
+
+    // Block-compress every level in place of the raw pixels
+    image.format = BlockCompressor::Resolve(options.format, channels);
+    if (image.format != BlockCompressor::Format::None) {
+        int lw = w, lh = h;
+        for (std::vector<unsigned char>& level : image.storage) {
+            std::vector<unsigned char> blocks(BlockCompressor::LevelSize(image.format, lw, lh));
+            BlockCompressor::Compress(image.format, options.quality, level.data(),
+                lw, lh, channels, blocks.data(), options.pool);
+            level.swap(blocks);
+            lw = lw > 1 ? lw / 2 : 1;
+            lh = lh > 1 ? lh / 2 : 1;
+        }
+    }
+
+    image.levels.clear();
+    for (const std::vector<unsigned char>& level : image.storage) {
+        image.levels.push_back(level.data());
+    }
+    image.mapping.reset();
+    image.fromCache = false;
+
+    // A failed write (read-only asset folder, ...) only costs the next start
+    if (haveSource && HashSource(path, source)) {
+        Write(cachePath, source, options, image);
+    }
+    return true;
+}
+
+}
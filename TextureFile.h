@@ -0,0 +1,93 @@
+// TextureFile.h
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "BlockCompressor.h"
+#include "MipGenerator.h"
+
+class MappedFile;
+class ThreadPool;
+
+// Decoded texture with its whole mip chain, level 0 first, rows bottom-up
+// and tightly packed (ready for glTexImage2D), or block-compressed levels
+// ready for glCompressedTexImage2D when format is not None
+struct TextureImage {
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    BlockCompressor::Format format = BlockCompressor::Format::None;
+    std::vector<const unsigned char*> levels;
+    bool fromCache = false;     // mapped from a .texcache file
+
+    // What levels point into: owned buffers, or the mapped cache file
+    std::vector<std::vector<unsigned char>> storage;
+    std::shared_ptr<MappedFile> mapping;
+};
+
+// Binary texture cache stored next to each source image as
+// "<source>.texcache": a header, a level table and every mip level,
+// already flipped. It is memory-mapped and uploaded as is, skipping PNG
+// decoding and mip generation. A cache file is rebuilt when the source's
+// size or content hash no longer match its header, or when it was written
+// with a different block compression or mip filter setting. The source is
+// only hashed when its mtime differs from the header's (or to write one).
+namespace TextureFile {
+
+// How Load builds and encodes the levels
+struct Options {
+    BlockCompressor::Format  format = BlockCompressor::Format::None;
+    BlockCompressor::Quality quality = BlockCompressor::Quality::Normal;
+    MipGenerator::Filter     mipFilter = MipGenerator::Filter::Box;
+    bool gammaCorrectMips = false;
+    ThreadPool* pool = nullptr;     // spreads mip building and block compression when set
+};
+
+// Identity of a source image, recorded in the cache header
+struct SourceInfo {
+    uint64_t size;
+    int64_t  mtime;
+    uint64_t hash;     // FNV-1a of the file's bytes, once hashed
+    bool     hashed;
+};
+
+// FNV-1a over a file's bytes; false if it can't be read
+bool HashFile(const std::string& path, uint64_t& hash);
+
+// Size and mtime of a source file, not yet hashed; false if it can't be read
+bool ReadSourceInfo(const std::string& path, SourceInfo& info);
+
+// Hash the source into info unless already done; false if it can't be read
+bool HashSource(const std::string& path, SourceInfo& info);
+
+// Content hash of the source at path as recorded in its cache file, if
+// that file's size and mtime still match the source. Costs a stat and a
+// header read, no hashing
+bool CachedHash(const std::string& path, uint64_t& hash);
+
+std::string CachePath(const std::string& sourcePath);
+
+// Bytes of one w x h level stored as format (raw pixels for None)
+uint64_t LevelBytes(BlockCompressor::Format format, int w, int h, int channels);
+
+// Fill image for the image file at path. With useCache, a valid cache file
+// is mapped, and a missing or stale one is rebuilt after decoding.
+// Without it the PNG is always decoded and nothing is written. Levels are
+// block-compressed as options asks (formats the image's channel count
+// can't use stay raw). Safe to call from worker threads. Returns false if
+// the image can't be decoded
+bool Load(const std::string& path, bool useCache, const Options& options, TextureImage& image);
+
+// Map cachePath if it is a well-formed cache file for source, built the
+// way options asks (the format resolved against the image's channels).
+// Hashes sourcePath into source when the mtimes differ
+bool Map(const std::string& cachePath, const std::string& sourcePath, SourceInfo& source,
+    const Options& options, TextureImage& image);
+
+// Write image (all levels) as a cache file for source (hashed), recording
+// the options it was built with
+bool Write(const std::string& cachePath, const SourceInfo& source, const Options& options,
+    const TextureImage& image);
+
+}
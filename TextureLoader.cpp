@@ -0,0 +1,127 @@
+// TextureLoader.cpp
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+#include "TextureLoader.h"
+#include "Texture2D.h"
+#include "Profiler.h"
+#include "TextureStreamer.h"
+#include <iostream>
+
+TextureLoader::~TextureLoader()
+{
+    pool.Wait();
+}
+
+void TextureLoader::SetCompression(BlockCompressor::Format format, BlockCompressor::Quality quality)
+{
+    options.format = format;
+    options.quality = quality;
+}
+
+void TextureLoader::SetMipFilter(MipGenerator::Filter filter, bool gammaCorrect)
+{
+    options.mipFilter = filter;
+    options.gammaCorrectMips = gammaCorrect;
+}
+
+std::shared_ptr<Texture2D> TextureLoader::Load(const char* path)
+{
+    if (pendingCount == 0) {
+        firstLoad = std::chrono::steady_clock::now();
+    }
+
+    std::shared_ptr<Texture2D> texture(new Texture2D(), [](Texture2D* t) {
+        t->Delete();
+        delete t;
+    });
+    texture->pending = true;
+    ++pendingCount;
+
+    std::string file(path);
+    std::weak_ptr<Texture2D> target = texture;
+    TextureFile::Options opts = options;
+    opts.pool = &pool;      // mip / block rows go to whichever workers are idle
+    pool.Submit([this, target, file, opts]() {
+        PROFILE_SCOPE("Texture decode");
+        Decoded d;
+        d.texture = target;
+        d.path = file;
+        d.ok = TextureFile::Load(file, true, opts, d.image);
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.push_back(std::move(d));
+    });
+    return texture;
+}
+
+int TextureLoader::PumpUploads(double budgetMs)
+{
+    if (uploading.empty()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        uploading.swap(finished);
+    }
+    if (uploading.empty()) {
+        return 0;
+    }
+    PROFILE_SCOPE("TextureLoader::PumpUploads");
+    PROFILE_GPU_SCOPE("Texture uploads");
+
+    auto start = std::chrono::steady_clock::now();
+    int uploaded = 0;
+    size_t next = 0;
+    while (next < uploading.size()) {
+        Decoded& d = uploading[next++];
+        std::shared_ptr<Texture2D> texture = d.texture.lock();
+        if (!d.ok) {
+            std::cerr << "Failed to load texture \"" << d.path << "\"\n";
+        }
+        else if (texture) {
+            const TextureImage& img = d.image;
+            if (img.format != BlockCompressor::Format::None) {
+                // Tiny levels pad up to a whole block, so compare the totals
+                uint64_t raw = 0, packed = 0;
+                int lw = img.width, lh = img.height;
+                for (size_t level = 0; level < img.levels.size(); ++level) {
+                    raw += TextureFile::LevelBytes(BlockCompressor::Format::None, lw, lh, img.channels);
+                    packed += TextureFile::LevelBytes(img.format, lw, lh, img.channels);
+                    lw = lw > 1 ? lw / 2 : 1;
+                    lh = lh > 1 ? lh / 2 : 1;
+                }
+                if (raw > packed) {
+                    bytesSaved += (size_t)(raw - packed);
+                }
+            }
+
+            if (streamer) {
+                // Uploads the small levels now and keeps the image for the rest
+                streamer->Adopt(texture, std::move(d.image), d.path);
+            }
+            else if (img.format == BlockCompressor::Format::None) {
+                texture->UploadMipChain(img.levels.data(), (int)img.levels.size(),
+                    img.width, img.height, img.channels, d.path.c_str());
+            }
+            else {
+                texture->UploadCompressedMipChain(img.levels.data(), (int)img.levels.size(),
+                    img.width, img.height, img.format, d.path.c_str());
+            }
+            ++uploaded;
+        }
+        d.image = TextureImage();    // release pixels / unmap now
+        if (texture) {
+            texture->pending = false;
+        }
+        --pendingCount;
+
+        double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        if (ms >= budgetMs) break;
+    }
+    // Keep whatever didn't fit in this call's budget for the next one
+    uploading.erase(uploading.begin(), uploading.begin() + next);
+
+    if (pendingCount == 0) {
+        double total = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - firstLoad).count();
+        std::cout << "All textures resident after " << total << " ms\n";
+    }
+    return uploaded;
+}
@@ -0,0 +1,69 @@
+// TextureLoader.h
+#pragma once
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "ThreadPool.h"
+#include "TextureFile.h"
+
+class Texture2D;
+class TextureStreamer;
+
+// Loads image files on a thread pool (from the binary texture cache when
+// it is valid, else by decoding and building the mip chain) and uploads
+// the results on the GL thread. Textures handed out by Load stay empty (and IsPending) until
+// PumpUploads has uploaded them, so startup costs roughly the slowest
+// decode instead of the sum of all of them.
+class TextureLoader {
+public:
+    // Waits for in-flight decodes
+    ~TextureLoader();
+
+    // Queue path for decoding; returns a new pending texture whose GL
+    // storage is freed with the last handle. Call from the GL thread
+    std::shared_ptr<Texture2D> Load(const char* path);
+
+    // Upload finished decodes until budgetMs has been spent (at least one
+    // per call). GL thread only. Returns how many textures became resident
+    int PumpUploads(double budgetMs);
+
+    // Block until every queued decode has finished (uploads still need PumpUploads)
+    void WaitForDecodes() { pool.Wait(); }
+
+    // Textures still decoding or waiting for upload
+    size_t GetPendingCount() const { return pendingCount; }
+
+    // Block compression for textures loaded from now on (default: none).
+    // The GL must be able to sample the formats this can resolve to
+    void SetCompression(BlockCompressor::Format format, BlockCompressor::Quality quality);
+
+    // Mip filter for textures loaded from now on (default: box, not gamma-correct)
+    void SetMipFilter(MipGenerator::Filter filter, bool gammaCorrect);
+
+    // Hand finished textures to streamer instead of uploading their whole
+    // chain (nullptr: upload everything, the default)
+    void SetStreamer(TextureStreamer* s) { streamer = s; }
+
+    // GPU bytes saved so far by compressed rather than raw mip chains
+    size_t GetBytesSaved() const { return bytesSaved; }
+
+private:
+    struct Decoded {
+        std::weak_ptr<Texture2D> texture;  // skipped if released meanwhile
+        std::string  path;
+        TextureImage image;
+        bool         ok;
+    };
+
+    ThreadPool pool;
+    std::mutex mutex;
+    std::vector<Decoded> finished;   // guarded by mutex
+    std::vector<Decoded> uploading;  // GL thread's batch, swapped out of finished
+    size_t pendingCount = 0;
+    size_t bytesSaved = 0;
+    TextureFile::Options options;
+    TextureStreamer* streamer = nullptr;
+    std::chrono::steady_clock::time_point firstLoad;
+};
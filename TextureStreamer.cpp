@@ -0,0 +1,290 @@
+// TextureStreamer.cpp
+#include <GL/glew.h>
+#include <GL/freeglut.h>
+#include "TextureStreamer.h"
+#include "Texture2D.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+
+// Levels at most this many texels across stay resident for good, so every
+// texture can be drawn (blurry) from the moment it is adopted
+static const int kTailSize = 64;
+
+TextureStreamer::TextureStreamer(size_t budgetBytes)
+    : budget(budgetBytes)
+{
+}
+
+size_t TextureStreamer::ChainBytes(const Entry& e, int base) const
+{
+    size_t bytes = 0;
+    for (int level = base; level < e.levelCount; ++level) {
+        int w = std::max(1, e.image.width >> level);
+        int h = std::max(1, e.image.height >> level);
+        bytes += (size_t)TextureFile::LevelBytes(e.image.format, w, h, e.image.channels);
+    }
+    return bytes;
+}
+
+void TextureStreamer::Adopt(const std::shared_ptr<Texture2D>& texture, TextureImage&& image, const std::string& name)
+{
+    int slot;
+    if (!freeSlots.empty()) {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    else {
+        slot = (int)entries.size();
+        entries.emplace_back();
+    }
+
+    Entry& e = entries[slot];
+    e.texture = texture;
+    e.image = std::move(image);
+    e.name = name;
+    e.levelCount = (int)e.image.levels.size();
+    e.tailBase = 0;
+    while (e.tailBase < e.levelCount - 1 &&
+        std::max(e.image.width >> e.tailBase, e.image.height >> e.tailBase) > kTailSize) {
+        ++e.tailBase;
+    }
+    e.residentBase = e.levelCount;      // nothing on the GPU yet
+    e.wantedBase = e.tailBase;
+    e.lastUsed = 0;
+    e.generation = ++adoptions;
+    e.live = true;
+    texture->streamSlot = slot;
+
+    UploadFrom(e, e.tailBase);
+}
+
+int TextureStreamer::BaseFor(const Entry& e, float pixelSize) const
+{
+    // Coarsest level that still has a texel for every pixel drawn
+    int size = std::max(e.image.width, e.image.height);
+    int base = 0;
+    while (base < e.tailBase && (float)(size >> (base + 1)) >= pixelSize) {
+        ++base;
+    }
+    return base;
+}
+
+void TextureStreamer::Request(const Texture2D* texture, float pixelSize)
+{
+    if (!texture || texture->streamSlot < 0) {
+        return;
+    }
+    Entry& e = entries[texture->streamSlot];
+
+    int base = BaseFor(e, pixelSize);
+    if (e.lastUsed != frame) {
+        e.lastUsed = frame;
+        e.wantedBase = base;
+    }
+    else {
+        e.wantedBase = std::min(e.wantedBase, base);
+    }
+}
+
+void TextureStreamer::Prefetch(const Texture2D* texture, float pixelSize)
+{
+    if (!texture || texture->streamSlot < 0) {
+        return;
+    }
+    Entry& e = entries[texture->streamSlot];
+
+    int base = BaseFor(e, pixelSize);
+    if (e.prefetched != frame) {
+        e.prefetched = frame;
+        e.prefetchBase = base;
+    }
+    else {
+        e.prefetchBase = std::min(e.prefetchBase, base);
+    }
+}
+
+bool TextureStreamer::IsResident(const Texture2D* texture, float pixelSize) const
+{
+    if (!texture || texture->streamSlot < 0) {
+        return true;
+    }
+    const Entry& e = entries[texture->streamSlot];
+    return e.residentBase <= BaseFor(e, pixelSize);
+}
+
+const TextureImage* TextureStreamer::GetImage(const Texture2D* texture) const
+{
+    if (!texture || texture->streamSlot < 0) {
+        return nullptr;
+    }
+    return &entries[texture->streamSlot].image;
+}
+
+uint64_t TextureStreamer::GetGeneration(const Texture2D* texture) const
+{
+    if (!texture || texture->streamSlot < 0) {
+        return 0;
+    }
+    return entries[texture->streamSlot].generation;
+}
+
+void TextureStreamer::UploadFrom(Entry& e, int base)
+{
+    std::shared_ptr<Texture2D> texture = e.texture.lock();
+    if (!texture) {
+        return;
+    }
+
+    // Re-specifying from level 0 replaces the old, larger levels
+    const TextureImage& img = e.image;
+    int w = std::max(1, img.width >> base);
+    int h = std::max(1, img.height >> base);
+    int count = e.levelCount - base;
+    if (img.format == BlockCompressor::Format::None) {
+        texture->UploadMipChain(img.levels.data() + base, count, w, h, img.channels, e.name.c_str());
+    }
+    else {
+        texture->UploadCompressedMipChain(img.levels.data() + base, count, w, h, img.format, e.name.c_str());
+    }
+    residentBytes = residentBytes - ChainBytes(e, e.residentBase) + ChainBytes(e, base);
+    e.residentBase = base;
+    ++uploadCount;
+}
+
+bool TextureStreamer::CanEvict(const Entry& e, const Entry* keep, bool forPrefetch) const
+{
+    return e.live && &e != keep && e.lastUsed < frame && e.residentBase < e.tailBase &&
+        !(forPrefetch && e.prefetched == frame);
+}
+
+bool TextureStreamer::MakeRoom(size_t bytes, const Entry* keep, bool forPrefetch)
+{
+    if (residentBytes + bytes <= Available()) {
+        return true;
+    }
+
+    // Evict nothing unless it makes enough room; a request that fails
+    // anyway would drop levels for nothing, and again every frame. Just
+    // enforcing the budget (bytes 0) evicts what it can
+    size_t evictable = 0;
+    for (const Entry& e : entries) {
+        if (CanEvict(e, keep, forPrefetch)) {
+            evictable += ChainBytes(e, e.residentBase) - ChainBytes(e, e.tailBase);
+        }
+    }
+    if (bytes > 0 && residentBytes + bytes > Available() + evictable) {
+        return false;
+    }
+
+    while (residentBytes + bytes > Available()) {
+        // Least recently used texture with a level to spare, not drawn this frame
+        Entry* victim = nullptr;
+        for (Entry& e : entries) {
+            if (CanEvict(e, keep, forPrefetch) && (!victim || e.lastUsed < victim->lastUsed)) {
+                victim = &e;
+            }
+        }
+        if (!victim) {
+            return false;
+        }
+
+        // Drop as many of its top levels as the shortfall needs, in one upload
+        int base = victim->residentBase;
+        size_t freed = 0;
+        while (base < victim->tailBase && residentBytes + bytes - freed > Available()) {
+            freed += ChainBytes(*victim, base) - ChainBytes(*victim, base + 1);
+            ++base;
+        }
+        evictionCount += base - victim->residentBase;
+        UploadFrom(*victim, base);
+    }
+    return true;
+}
+
+void TextureStreamer::Release(int slot)
+{
+    Entry& e = entries[slot];
+    residentBytes -= ChainBytes(e, e.residentBase);
+    e = Entry();
+    freeSlots.push_back(slot);
+}
+
+void TextureStreamer::Update(double budgetMs)
+{
+    PROFILE_SCOPE("TextureStreamer::Update");
+    PROFILE_GPU_SCOPE("Texture streaming");
+    auto start = std::chrono::steady_clock::now();
+
+    // Forget textures whose last handle is gone (their GL storage went with it)
+    for (int slot = 0; slot < (int)entries.size(); ++slot) {
+        if (entries[slot].live && entries[slot].texture.expired()) {
+            Release(slot);
+        }
+    }
+
+    // Textures drawn this frame that need finer levels, most starved first
+    std::vector<int> wanted;
+    for (int slot = 0; slot < (int)entries.size(); ++slot) {
+        const Entry& e = entries[slot];
+        if (e.live && e.lastUsed == frame && e.wantedBase < e.residentBase) {
+            wanted.push_back(slot);
+        }
+    }
+    std::sort(wanted.begin(), wanted.end(), [this](int a, int b) {
+        return entries[a].residentBase - entries[a].wantedBase >
+            entries[b].residentBase - entries[b].wantedBase;
+    });
+
+    auto timeUp = [&]() {
+        return std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count() >= budgetMs;
+    };
+
+    bool outOfTime = false;
+    for (int slot : wanted) {
+        Entry& e = entries[slot];
+
+        // Settle for fewer levels when the budget can't hold them all
+        int base = e.wantedBase;
+        while (base < e.residentBase &&
+            !MakeRoom(ChainBytes(e, base) - ChainBytes(e, e.residentBase), &e)) {
+            ++base;
+        }
+        if (base < e.residentBase) {
+            UploadFrom(e, base);
+        }
+
+        if (timeUp()) {
+            outOfTime = true;
+            break;
+        }
+    }
+
+    // Prefetched textures not drawn this frame, with whatever time is left
+    for (int slot = 0; slot < (int)entries.size() && !outOfTime; ++slot) {
+        Entry& e = entries[slot];
+        if (!e.live || e.prefetched != frame || e.lastUsed == frame ||
+            e.prefetchBase >= e.residentBase) {
+            continue;
+        }
+
+        int base = e.prefetchBase;
+        while (base < e.residentBase &&
+            !MakeRoom(ChainBytes(e, base) - ChainBytes(e, e.residentBase), &e, true)) {
+            ++base;
+        }
+        if (base < e.residentBase) {
+            UploadFrom(e, base);
+            ++prefetchCount;
+        }
+        outOfTime = timeUp();
+    }
+
+    // A lowered budget (or a grown reservation) is enforced even without
+    // new requests
+    if (residentBytes > Available()) {
+        MakeRoom(0, nullptr);
+    }
+    ++frame;
+}
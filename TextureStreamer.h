@@ -0,0 +1,120 @@
+// TextureStreamer.h
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "TextureFile.h"
+
+class Texture2D;
+
+// Residency manager for loaded textures. A texture handed over by the
+// loader starts with only its small mip levels on the GPU; its full chain
+// stays on the CPU side (usually just the mapped .texcache file). Larger
+// levels are uploaded once a visible object needs them, and when that
+// would exceed the memory budget the top levels of the least recently
+// used textures are dropped first. Uploads are spread over frames by a
+// per-frame time budget.
+class TextureStreamer {
+public:
+    explicit TextureStreamer(size_t budgetBytes = 128u * 1024 * 1024);
+
+    // GPU memory the streamed textures may occupy together
+    void   SetBudget(size_t bytes) { budget = bytes; }
+    size_t GetBudget() const { return budget; }
+
+    // GPU memory held for the same textures outside the streamer (the
+    // texture array), charged against the budget. Applied at the next Update
+    void   SetReservedBytes(size_t bytes) { reservedBytes = bytes; }
+    size_t GetReservedBytes() const { return reservedBytes; }
+
+    // Take over a freshly loaded texture: upload its small levels now and
+    // keep image to stream the rest from. GL thread only
+    void Adopt(const std::shared_ptr<Texture2D>& texture, TextureImage&& image, const std::string& name);
+
+    // Note that texture is drawn this frame covering about pixelSize
+    // pixels across. Textures not adopted here are ignored
+    void Request(const Texture2D* texture, float pixelSize);
+
+    // Note that texture may be drawn soon at about pixelSize pixels across.
+    // Its levels are uploaded after this frame's requests, if time is left,
+    // and only by evicting textures neither drawn nor prefetched this frame
+    void Prefetch(const Texture2D* texture, float pixelSize);
+
+    // True if texture already has the levels for drawing it pixelSize pixels
+    // across on the GPU (always true for textures not adopted here)
+    bool IsResident(const Texture2D* texture, float pixelSize) const;
+
+    // Once per frame after drawing: upload the levels requested this frame,
+    // evicting as needed, then prefetched ones, until budgetMs has been
+    // spent. GL thread only
+    void Update(double budgetMs);
+
+    // Full mip chain kept for an adopted texture, or nullptr
+    const TextureImage* GetImage(const Texture2D* texture) const;
+
+    // Changes whenever texture is adopted, so a copy of its image can tell
+    // a reload (or a new texture at a freed address) from the one it was
+    // made from. 0 for textures not adopted here
+    uint64_t GetGeneration(const Texture2D* texture) const;
+
+    // Bytes currently on the GPU for the streamed textures
+    size_t GetResidentBytes() const { return residentBytes; }
+
+    // Textures managed, level uploads (prefetches included), uploads for
+    // prefetches and top-level evictions so far
+    size_t GetTextureCount() const { return entries.size() - freeSlots.size(); }
+    size_t GetUploadCount() const { return uploadCount; }
+    size_t GetPrefetchCount() const { return prefetchCount; }
+    size_t GetEvictionCount() const { return evictionCount; }
+
+private:
+    struct Entry {
+        std::weak_ptr<Texture2D> texture;  // slot is freed when this expires
+        TextureImage image;
+        std::string  name;
+        int levelCount = 0;
+        int tailBase = 0;       // levels from here on are always resident
+        int residentBase = 0;   // first level on the GPU
+        int wantedBase = 0;     // first level requested this frame
+        uint64_t lastUsed = 0;  // frame of the last Request
+        int prefetchBase = 0;   // first level prefetched this frame
+        uint64_t prefetched = 0; // frame of the last Prefetch
+        uint64_t generation = 0; // adoption this entry holds
+        bool live = false;
+    };
+
+    // First level e needs to be drawn pixelSize pixels across
+    int BaseFor(const Entry& e, float pixelSize) const;
+
+    // Bytes of levels [base, levelCount) of e
+    size_t ChainBytes(const Entry& e, int base) const;
+
+    // Re-specify e's GL texture with levels [base, levelCount)
+    void UploadFrom(Entry& e, int base);
+
+    // Drop top levels of least recently used textures (other than keep)
+    // until bytes more fit in the budget; false, evicting nothing, if they
+    // can't (with bytes 0 it gets as close as it can). Room for a prefetch
+    // is never taken from other textures prefetched this frame
+    bool MakeRoom(size_t bytes, const Entry* keep, bool forPrefetch = false);
+
+    // True if MakeRoom may drop levels of e
+    bool CanEvict(const Entry& e, const Entry* keep, bool forPrefetch) const;
+
+    // Budget left for streamed levels after the reserved bytes
+    size_t Available() const { return budget > reservedBytes ? budget - reservedBytes : 0; }
+
+    void Release(int slot);
+
+    std::vector<Entry> entries;
+    std::vector<int> freeSlots;
+    size_t budget;
+    size_t reservedBytes = 0;
+    size_t residentBytes = 0;
+    size_t uploadCount = 0;
+    size_t prefetchCount = 0;
+    size_t evictionCount = 0;
+    uint64_t frame = 1;
+    uint64_t adoptions = 0;
+};
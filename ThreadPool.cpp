@@ -0,0 +1,115 @@
+// ThreadPool.cpp
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+    if (threads == 0) {
+        unsigned hw = std::thread::hardware_concurrency();
+        threads = hw > 1 ? hw - 1 : 1;
+    }
+    workers.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobReady.notify_all();
+    for (std::thread& t : workers) {
+        t.join();
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    jobReady.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]() { return jobs.empty() && running == 0; });
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& fn)
+{
+    if (count == 0) {
+        return;
+    }
+
+    // Shared with the helper jobs, which may only start after we returned;
+    // by then every index is claimed and they exit without calling fn
+    struct State {
+        std::function<void(size_t)> fn;
+        size_t count;
+        std::atomic<size_t> next;
+        std::atomic<size_t> done;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    std::shared_ptr<State> state = std::make_shared<State>();
+    state->fn = fn;
+    state->count = count;
+    state->next = 0;
+    state->done = 0;
+
+    auto work = [state]() {
+        size_t i;
+        while ((i = state->next++) < state->count) {
+            state->fn(i);
+            if (++state->done == state->count) {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->finished.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = std::min<size_t>(workers.size(), count - 1);
+    for (size_t h = 0; h < helpers; ++h) {
+        Submit(work);
+    }
+    work();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&]() { return state->done == state->count; });
+}
+
+void ThreadPool::WorkerLoop()
+{
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobReady.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            // Drain the queue before honouring a stop request
+            if (jobs.empty()) {
+                return;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+            ++running;
+        }
+
+        job();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --running;
+            if (jobs.empty() && running == 0) {
+                idle.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,46 @@
+// ThreadPool.h
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads pulling jobs from a shared FIFO queue
+class ThreadPool {
+public:
+    // threads = 0 picks one less than the hardware thread count (at least 1)
+    explicit ThreadPool(unsigned threads = 0);
+
+    // Finishes the queued jobs, then joins the workers
+    ~ThreadPool();
+
+    // Queue a job to run on some worker
+    void Submit(std::function<void()> job);
+
+    // Block until the queue is empty and no job is running
+    void Wait();
+
+    // Run fn(i) for every i in [0, count) on the workers and the calling
+    // thread, returning once all calls are done. Indices are claimed one at
+    // a time, so this is safe to call from inside a job: if every worker is
+    // busy the caller simply runs the whole range itself
+    void ParallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+    unsigned GetThreadCount() const { return (unsigned)workers.size(); }
+
+private:
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void WorkerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable jobReady;
+    std::condition_variable idle;
+    unsigned running = 0;
+    bool stopping = false;
+};
@@ -0,0 +1,169 @@
+// TransformStore.cpp
+#include "TransformStore.h"
+#include "Object3D.h"
+#include "ModelMatrixBatch.h"
+#include "Frustum.h"
+#include "Profiler.h"
+
+TransformStore* TransformStore::instance = nullptr;
+
+uint32_t TransformStore::Allocate(Object3D* owner)
+{
+    positions.push_back(glm::vec3(0.0f));
+    rotations.push_back(glm::vec3(0.0f));
+    scales.push_back(glm::vec3(1.0f));
+    flags.push_back(0);
+    texIndices.push_back(0);
+    owners.push_back(owner);
+    models.push_back(glm::mat4(1.0f));
+    localBounds.push_back(AABB(glm::vec3(-0.5f), glm::vec3(0.5f)));
+    worldBounds.push_back(localBounds.back());
+    proxies.push_back(tree.CreateProxy(worldBounds.back(), owner));
+    return (uint32_t)(owners.size() - 1);
+}
+
+void TransformStore::Release(uint32_t slot)
+{
+    uint32_t last = (uint32_t)(owners.size() - 1);
+    tree.DestroyProxy(proxies[slot]);
+    if (slot != last) {
+        positions[slot] = positions[last];
+        rotations[slot] = rotations[last];
+        scales[slot] = scales[last];
+        flags[slot] = flags[last];
+        texIndices[slot] = texIndices[last];
+        owners[slot] = owners[last];
+        models[slot] = models[last];
+        localBounds[slot] = localBounds[last];
+        worldBounds[slot] = worldBounds[last];
+        proxies[slot] = proxies[last];
+        owners[slot]->slot = slot;
+        if (flags[slot] & FlagDirty) {
+            dirtySlots.push_back(slot);
+        }
+    }
+    positions.pop_back();
+    rotations.pop_back();
+    scales.pop_back();
+    flags.pop_back();
+    texIndices.pop_back();
+    owners.pop_back();
+    models.pop_back();
+    localBounds.pop_back();
+    worldBounds.pop_back();
+    proxies.pop_back();
+}
+
+void TransformStore::SetFlagAll(Flag flag, bool on)
+{
+    for (uint8_t& f : flags) {
+        f = on ? (uint8_t)(f | flag) : (uint8_t)(f & ~flag);
+    }
+}
+
+glm::mat4 TransformStore::ComputeModelMatrix(uint32_t slot) const
+{
+    return ModelMatrixBatch::BuildOne(positions[slot], rotations[slot], scales[slot]);
+}
+
+void TransformStore::Refresh(uint32_t slot)
+{
+    models[slot] = ComputeModelMatrix(slot);
+    worldBounds[slot] = localBounds[slot].Transformed(models[slot]);
+    tree.MoveProxy(proxies[slot], worldBounds[slot]);
+    flags[slot] &= ~FlagDirty;
+}
+
+const glm::mat4& TransformStore::GetModelMatrix(uint32_t slot)
+{
+    if (flags[slot] & FlagDirty) {
+        Refresh(slot);
+    }
+    return models[slot];
+}
+
+size_t TransformStore::UpdateModelMatrices()
+{
+    PROFILE_SCOPE("TransformStore::UpdateModelMatrices");
+
+    // When a large share of a big scene moved, one vectorized sweep over
+    // every slot is cheaper than scattered single-matrix updates
+    const size_t kSweepMinObjects = 256;
+    if (owners.size() >= kSweepMinObjects && dirtySlots.size() * 4 >= owners.size()) {
+        ModelMatrixBatch::Build(positions.data(), rotations.data(), scales.data(),
+            models.data(), owners.size());
+        for (size_t i = 0; i < owners.size(); ++i) {
+            worldBounds[i] = localBounds[i].Transformed(models[i]);
+            tree.MoveProxy(proxies[i], worldBounds[i]);
+        }
+        SetFlagAll(FlagDirty, false);
+        dirtySlots.clear();
+        return owners.size();
+    }
+
+    size_t rebuilt = 0;
+    for (uint32_t slot : dirtySlots) {
+        if (slot < flags.size() && (flags[slot] & FlagDirty)) {
+            Refresh(slot);
+            ++rebuilt;
+        }
+    }
+    dirtySlots.clear();
+    return rebuilt;
+}
+
+size_t TransformStore::CullFrustum(const Frustum& frustum, std::vector<Object3D*>& visible) const
+{
+    PROFILE_SCOPE("TransformStore::CullFrustum");
+    size_t before = visible.size();
+    tree.QueryFrustum(frustum, [&](void* userData) {
+        // Leaves hold fat boxes; confirm with the exact world bounds
+        Object3D* obj = static_cast<Object3D*>(userData);
+        if (frustum.IntersectsAABB(worldBounds[obj->GetSlot()])) {
+            visible.push_back(obj);
+        }
+    });
+    return owners.size() - (visible.size() - before);
+}
+
+Object3D* TransformStore::RayCast(const glm::vec3& origin, const glm::vec3& dir, float& hitT) const
+{
+    const float big = 1e30f;
+    glm::vec3 invDir(dir.x != 0.0f ? 1.0f / dir.x : big,
+        dir.y != 0.0f ? 1.0f / dir.y : big,
+        dir.z != 0.0f ? 1.0f / dir.z : big);
+
+    Object3D* nearest = nullptr;
+    float nearestT = big;
+    tree.RayCast(origin, dir, big, [&](void* userData, float maxT) {
+        Object3D* obj = static_cast<Object3D*>(userData);
+        // Cheap reject on the exact world box before the shape test
+        float tBox;
+        if (!AABBTree::RayHitsAABB(origin, invDir, worldBounds[obj->GetSlot()], maxT, tBox)) {
+            return maxT;
+        }
+        float t;
+        if (obj->IntersectRay(origin, dir, t) && t < maxT) {
+            nearest = obj;
+            nearestT = t;
+            return t;
+        }
+        return maxT;
+    });
+    hitT = nearestT;
+    return nearest;
+}
+
+void TransformStore::QueryBox(const AABB& box, std::vector<Object3D*>& found) const
+{
+    tree.Query(box, [&](void* userData) {
+        Object3D* obj = static_cast<Object3D*>(userData);
+        const AABB& b = worldBounds[obj->GetSlot()];
+        if (b.max.x >= box.min.x && b.min.x <= box.max.x &&
+            b.max.y >= box.min.y && b.min.y <= box.max.y &&
+            b.max.z >= box.min.z && b.min.z <= box.max.z) {
+            found.push_back(obj);
+        }
+        return true;
+    });
+}
@@ -0,0 +1,99 @@
+// TransformStore.h
+#pragma once
+#include <glm/glm.hpp>
+#include "Bounds.h"
+#include "AABBTree.h"
+#include <cstdint>
+#include <vector>
+
+class Object3D;
+
+// Contiguous structure-of-arrays storage for every object's transform,
+// flags and texture index. Object3D only keeps its slot into these arrays,
+// so per-frame passes stream linearly instead of chasing object pointers.
+class TransformStore {
+public:
+    // The store new objects register with (set by the Engine that owns it)
+    static TransformStore* instance;
+
+    // Per-slot flag bits
+    enum Flag : uint8_t {
+        FlagSelected = 1 << 0,
+        FlagTextured = 1 << 1,
+        FlagDirty = 1 << 2      // cached model matrix is stale
+    };
+
+    // Append a slot with the default transform and return its index
+    uint32_t Allocate(Object3D* owner);
+
+    // Remove a slot by moving the last slot into it; the moved object's
+    // handle is patched to its new index
+    void Release(uint32_t slot);
+
+    size_t Size() const { return owners.size(); }
+
+    // Set or clear a flag bit on every slot
+    void SetFlagAll(Flag flag, bool on);
+
+    // T * Rz * Ry * Rx * S for one slot
+    glm::mat4 ComputeModelMatrix(uint32_t slot) const;
+
+    // Flag a slot's cached model matrix for recomputation
+    void MarkDirty(uint32_t slot) {
+        if ((flags[slot] & FlagDirty) == 0) {
+            flags[slot] |= FlagDirty;
+            dirtySlots.push_back(slot);
+        }
+    }
+
+    // Cached model matrix, recomputed on the spot if the slot is dirty
+    const glm::mat4& GetModelMatrix(uint32_t slot);
+
+    // Batch pass: recompute only the dirty matrices (and their world
+    // bounds). Returns how many were rebuilt
+    size_t UpdateModelMatrices();
+
+    // Local-space bounds of a slot's geometry
+    void SetLocalBounds(uint32_t slot, const AABB& box) {
+        localBounds[slot] = box;
+        MarkDirty(slot);
+    }
+
+    // Append the owners whose world bounds touch the frustum, found through
+    // the bounding-volume tree. Expects UpdateModelMatrices() to have run
+    // this frame. Returns the culled count
+    size_t CullFrustum(const Frustum& frustum, std::vector<Object3D*>& visible) const;
+
+    // Append the owners whose world bounds overlap box (proximity query)
+    void QueryBox(const AABB& box, std::vector<Object3D*>& found) const;
+
+    // Nearest owner hit by the world-space ray origin + t*dir, or nullptr.
+    // Candidates come from the tree and are confirmed with the owner's exact
+    // shape test. Expects UpdateModelMatrices() to have run
+    Object3D* RayCast(const glm::vec3& origin, const glm::vec3& dir, float& hitT) const;
+
+    // Spatial index over the world bounds; leaf user data is the Object3D*
+    const AABBTree& GetTree() const { return tree; }
+
+    // Parallel arrays, all Size() long
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> rotations;
+    std::vector<glm::vec3> scales;
+    std::vector<uint8_t>   flags;
+    std::vector<int>       texIndices;
+    std::vector<Object3D*> owners;
+    std::vector<glm::mat4> models;      // cached world matrices
+    std::vector<AABB>      localBounds;
+    std::vector<AABB>      worldBounds; // localBounds under models
+    std::vector<int>       proxies;     // leaf ids in tree
+
+private:
+    // Rebuild one slot's matrix and world bounds and clear its dirty bit
+    void Refresh(uint32_t slot);
+
+    // Slots flagged dirty since the last batch pass (may hold stale or
+    // duplicate entries; the dirty bit is authoritative)
+    std::vector<uint32_t> dirtySlots;
+
+    AABBTree tree;
+};
@@ -1,10 +1,65 @@
 // main.cpp
 #include "Engine.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
+// Command line:
+//   --headless [frames]      render frames (default 100) without a window, then exit
+//   --out <file.ppm>         with --headless, save the last frame
+//   --size <w>x<h>           window / framebuffer size
+//   --software               start on the software rasterizer
+//   --hud                    show the performance HUD (F3)
+//   --raster-bench [frames]  time the GL and software renderers, then exit
 int main(int argc, char** argv) {
+    int benchFrames = 0;
+    int headlessFrames = 0;
+    const char* imagePath = nullptr;
+    int width = 0, height = 0;
+    bool software = false;
+    bool hud = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--raster-bench") == 0) {
+            benchFrames = (i + 1 < argc) ? std::atoi(argv[i + 1]) : 0;
+            if (benchFrames <= 0) benchFrames = 100;
+        }
+        else if (std::strcmp(argv[i], "--headless") == 0) {
+            headlessFrames = (i + 1 < argc) ? std::atoi(argv[i + 1]) : 0;
+            if (headlessFrames <= 0) headlessFrames = 100;
+        }
+        else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            imagePath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%dx%d", &width, &height) != 2 || width <= 0 || height <= 0) {
+                std::fprintf(stderr, "Bad --size %s, expected e.g. 1280x720\n", argv[i]);
+                width = height = 0;
+            }
+        }
+        else if (std::strcmp(argv[i], "--software") == 0) {
+            software = true;
+        }
+        else if (std::strcmp(argv[i], "--hud") == 0) {
+            hud = true;
+        }
+    }
+
     Engine engine(argc, argv);
     engine.SetClearColor(0.1f, 0.1f, 0.15f);
+    if (width > 0) {
+        engine.SetResolution(width, height);
+    }
+    if (headlessFrames > 0) {
+        engine.SetHeadless(headlessFrames, imagePath);
+    }
+    engine.SetSoftwareRendering(software);
+    engine.SetPerfHud(hud);
     engine.Init();
+    if (benchFrames > 0) {
+        engine.BenchmarkRenderers(benchFrames);
+        engine.Cleanup();
+        return 0;
+    }
     engine.Run();
     engine.Cleanup();
     return 0;